@@ -14,6 +14,10 @@ gcc -m64 -nostdlib -static -fno-pie -no-pie -ffreestanding \
     -Wl,-Ttext=0x400000 -Wl,--build-id=none \
     -o bin/userland/hello userland/hello/hello.c
 
+gcc -m64 -nostdlib -static -fno-pie -no-pie -ffreestanding \
+    -Wl,-Ttext=0x400000 -Wl,--build-id=none \
+    -o bin/userland/top userland/top/top.c
+
 truncate -s ${SIZE}M $IMG 
 
 parted -s $IMG mklabel gpt
@@ -40,6 +44,7 @@ sudo cp limine/BOOTX64.EFI /mnt/esp/EFI/BOOT/
 sudo mkdir -p /mnt/root/system/cmd
 sudo cp bin/userland/sh /mnt/root/system/cmd/sh
 sudo cp bin/userland/hello /mnt/root/system/cmd/hello
+sudo cp bin/userland/top /mnt/root/system/cmd/top
 
 
 sudo umount /mnt/esp /mnt/root
@@ -0,0 +1,85 @@
+#include "cpu.h"
+
+#include <stddef.h>
+
+#include "../../../io/terminal.h"
+#include "../../../mem/alloc/heap.h"
+#include "../../../mem/alloc/page_frame_alloc.h"
+#include "../../../std/string.h"
+#include "../fpu/fpu.h"
+
+_Static_assert(offsetof(cpu_t, self) == CPU_SELF, "cpu_t layout does not match CPU_SELF");
+_Static_assert(offsetof(cpu_t, kernel_stack) == CPU_KERNEL_STACK, "cpu_t layout does not match CPU_KERNEL_STACK");
+_Static_assert(offsetof(cpu_t, user_rsp) == CPU_USER_RSP, "cpu_t layout does not match CPU_USER_RSP");
+_Static_assert(offsetof(cpu_t, current) == CPU_CURRENT, "cpu_t layout does not match CPU_CURRENT");
+
+static cpu_t bsp_cpu = {0};
+static cpu_t *cpus[MAX_CPUS] = {0};
+static uint32_t num_cpus = 0;
+
+void cpu_setup(cpu_t *cpu) {
+    gdt_init(cpu->gdt, cpu->tss);
+
+    wrmsr(MSR_GS_BASE, (uint64_t)cpu);
+    wrmsr(MSR_KERNEL_GS_BASE, 0);
+
+    fpu_init_cpu();
+}
+
+void cpu_init_bsp() {
+    bsp_cpu.self = &bsp_cpu;
+    bsp_cpu.id = 0;
+    bsp_cpu.gdt = &_g_gdt;
+    bsp_cpu.tss = &_g_tss;
+    bsp_cpu.online = true;
+
+    cpus[0] = &bsp_cpu;
+    num_cpus = 1;
+
+    cpu_setup(&bsp_cpu);
+}
+
+cpu_t *cpu_create(uint32_t lapic_id) {
+    if (num_cpus >= MAX_CPUS) {
+        printkf_error("cpu_create(): too many CPUs\n");
+        return NULL;
+    }
+
+    cpu_t *cpu = (cpu_t *)malloc(sizeof(cpu_t));
+    if (cpu == NULL) {
+        printkf_error("cpu_create(): failed to allocate cpu\n");
+        return NULL;
+    }
+    memset(cpu, 0, sizeof(cpu_t));
+
+    cpu->gdt = (gdt_t *)pfallocator_request_page();
+    cpu->tss = (tss_t *)malloc(sizeof(tss_t));
+    if (cpu->gdt == NULL || cpu->tss == NULL) {
+        printkf_error("cpu_create(): failed to allocate GDT/TSS\n");
+        if (cpu->gdt)
+            pfallocator_free_page(cpu->gdt);
+        if (cpu->tss)
+            free(cpu->tss);
+        free(cpu);
+        return NULL;
+    }
+
+    cpu->self = cpu;
+    cpu->id = num_cpus;
+    cpu->lapic_id = lapic_id;
+    cpu->online = false;
+
+    cpus[num_cpus++] = cpu;
+
+    return cpu;
+}
+
+cpu_t *cpu_get(uint32_t id) {
+    if (id >= num_cpus)
+        return NULL;
+    return cpus[id];
+}
+
+uint32_t cpu_count() {
+    return num_cpus;
+}
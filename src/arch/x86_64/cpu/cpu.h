@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../../../task/idle.h"
+#include "../../../task/scheduler.h"
+#include "../gdt/gdt.h"
+
+#define MAX_CPUS 64
+
+#define MSR_APIC_BASE 0x1B
+#define MSR_EFER 0xC0000080
+#define MSR_STAR 0xC0000081
+#define MSR_LSTAR 0xC0000082
+#define MSR_SFMASK 0xC0000084
+#define MSR_FS_BASE 0xC0000100
+#define MSR_GS_BASE 0xC0000101
+#define MSR_KERNEL_GS_BASE 0xC0000102
+
+#define CPU_SELF 0
+#define CPU_KERNEL_STACK 8
+#define CPU_USER_RSP 16
+#define CPU_CURRENT 24
+
+typedef struct cpu {
+    struct cpu *self;
+    uint64_t kernel_stack;
+    uint64_t user_rsp;
+    task_t *current;
+
+    uint32_t id;
+    uint32_t lapic_id;
+    volatile bool online;
+    volatile bool need_resched;
+    bool tick_from_user;
+
+    gdt_t *gdt;
+    tss_t *tss;
+
+    task_t *idle;
+    task_t *prev;
+
+    task_t *fpu_owner;
+    task_t *fpu_last;
+
+    page_table_t *page_table;
+    volatile uint64_t tlb_flush_req;
+    volatile uint64_t tlb_flush_done;
+
+    run_queue_t rq;
+
+    idle_stats_t idle_stats;
+} cpu_t;
+
+static inline void wrmsr(uint32_t msr, uint64_t value) {
+    uint32_t low = value & 0xffffffff;
+    uint32_t high = value >> 32;
+    __asm__ volatile("wrmsr" : : "c"(msr), "a"(low), "d"(high));
+}
+
+static inline uint64_t rdmsr(uint32_t msr) {
+    uint32_t low, high;
+    __asm__ volatile("rdmsr" : "=a"(low), "=d"(high) : "c"(msr));
+    return ((uint64_t)high << 32) | low;
+}
+
+static inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t *eax, uint32_t *ebx, uint32_t *ecx, uint32_t *edx) {
+    __asm__ volatile("cpuid" : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx) : "a"(leaf), "c"(subleaf));
+}
+
+static inline cpu_t *cpu_current() {
+    cpu_t *cpu;
+    __asm__ volatile("mov %%gs:0, %0" : "=r"(cpu));
+    return cpu;
+}
+
+static inline task_t *cpu_current_task() {
+    task_t *task;
+    __asm__ volatile("mov %%gs:%c1, %0" : "=r"(task) : "i"(CPU_CURRENT));
+    return task;
+}
+
+static inline void cpu_relax() {
+    __asm__ volatile("pause" ::: "memory");
+}
+
+void cpu_init_bsp();
+cpu_t *cpu_create(uint32_t lapic_id);
+void cpu_setup(cpu_t *cpu);
+
+cpu_t *cpu_get(uint32_t id);
+uint32_t cpu_count();
@@ -0,0 +1,222 @@
+#include "fpu.h"
+
+#include <stddef.h>
+
+#include "../../../io/terminal.h"
+#include "../../../mem/alloc/page_frame_alloc.h"
+#include "../../../std/string.h"
+#include "../../../task/scheduler.h"
+#include "../cpu/cpu.h"
+
+static bool fpu_xsave = false;
+static bool fpu_xsaveopt = false;
+static uint64_t fpu_xcr0 = XCR0_X87 | XCR0_SSE;
+static uint32_t fpu_size = 512;
+
+static inline uint64_t read_cr0() {
+    uint64_t cr0;
+    __asm__ volatile("mov %%cr0, %0" : "=r"(cr0));
+    return cr0;
+}
+
+static inline void write_cr0(uint64_t cr0) {
+    __asm__ volatile("mov %0, %%cr0" : : "r"(cr0) : "memory");
+}
+
+static inline uint64_t read_cr4() {
+    uint64_t cr4;
+    __asm__ volatile("mov %%cr4, %0" : "=r"(cr4));
+    return cr4;
+}
+
+static inline void write_cr4(uint64_t cr4) {
+    __asm__ volatile("mov %0, %%cr4" : : "r"(cr4) : "memory");
+}
+
+static inline void xsetbv(uint32_t index, uint64_t value) {
+    __asm__ volatile("xsetbv" : : "c"(index), "a"((uint32_t)value), "d"((uint32_t)(value >> 32)));
+}
+
+static inline void clts() {
+    __asm__ volatile("clts" ::: "memory");
+}
+
+static void fpu_save(void *area) {
+    if (fpu_xsaveopt) {
+        __asm__ volatile("xsaveopt64 (%0)" : : "r"(area), "a"(0xFFFFFFFF), "d"(0xFFFFFFFF) : "memory");
+    } else if (fpu_xsave) {
+        __asm__ volatile("xsave64 (%0)" : : "r"(area), "a"(0xFFFFFFFF), "d"(0xFFFFFFFF) : "memory");
+    } else {
+        __asm__ volatile("fxsave64 (%0)" : : "r"(area) : "memory");
+    }
+}
+
+static void fpu_restore(void *area) {
+    if (fpu_xsave) {
+        __asm__ volatile("xrstor64 (%0)" : : "r"(area), "a"(0xFFFFFFFF), "d"(0xFFFFFFFF) : "memory");
+    } else {
+        __asm__ volatile("fxrstor64 (%0)" : : "r"(area) : "memory");
+    }
+}
+
+void fpu_init_cpu() {
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+
+    uint64_t cr0 = read_cr0();
+    cr0 &= ~CR0_EM;
+    cr0 |= CR0_MP | CR0_NE | CR0_TS;
+    write_cr0(cr0);
+
+    uint64_t cr4 = read_cr4();
+    cr4 |= CR4_OSFXSR | CR4_OSXMMEXCPT;
+
+    bool has_xsave = ecx & (1 << 26);
+    bool has_avx = ecx & (1 << 28);
+
+    if (has_xsave) {
+        cr4 |= CR4_OSXSAVE;
+        write_cr4(cr4);
+
+        uint32_t xcr0_lo, xcr0_hi, unused;
+        cpuid(0x0D, 0, &xcr0_lo, &unused, &unused, &xcr0_hi);
+        uint64_t supported = ((uint64_t)xcr0_hi << 32) | xcr0_lo;
+
+        uint64_t xcr0 = XCR0_X87 | XCR0_SSE;
+        if (has_avx && (supported & XCR0_AVX)) {
+            xcr0 |= XCR0_AVX;
+        }
+        xsetbv(0, xcr0);
+
+        uint32_t size;
+        cpuid(0x0D, 0, &eax, &size, &ecx, &edx);
+
+        uint32_t features;
+        cpuid(0x0D, 1, &features, &ebx, &ecx, &edx);
+
+        fpu_xsave = true;
+        fpu_xsaveopt = features & 1;
+        fpu_xcr0 = xcr0;
+        fpu_size = size;
+    } else {
+        write_cr4(cr4);
+    }
+
+    if (cpu_current()->id == 0) {
+        printkf_info("FPU: %s, xcr0=0x%llx, state size %u bytes\n",
+                     fpu_xsaveopt ? "xsaveopt" : (fpu_xsave ? "xsave" : "fxsave"), fpu_xcr0, fpu_size);
+    }
+}
+
+uint32_t fpu_state_size() {
+    return fpu_size;
+}
+
+static void *fpu_alloc_state() {
+    if (fpu_size > 4096) {
+        printkf_error("fpu_alloc_state(): state size %u exceeds one page\n", fpu_size);
+        return NULL;
+    }
+
+    uint8_t *area = (uint8_t *)pfallocator_request_zeroed_page();
+    if (area == NULL) {
+        return NULL;
+    }
+
+    *(uint16_t *)(area + 0) = 0x037F;
+    *(uint32_t *)(area + 24) = 0x1F80;
+
+    return area;
+}
+
+void fpu_switch(task_t *prev, task_t *next) {
+    (void)next;
+    cpu_t *cpu = cpu_current();
+
+    if (cpu->fpu_owner != NULL && cpu->fpu_owner == prev) {
+        fpu_save(prev->fpu_state);
+        cpu->fpu_owner = NULL;
+    }
+
+    uint64_t cr0 = read_cr0();
+    if (!(cr0 & CR0_TS)) {
+        write_cr0(cr0 | CR0_TS);
+    }
+}
+
+int fpu_fork(task_t *parent, task_t *child) {
+    if (parent->fpu_state == NULL) {
+        return 0;
+    }
+
+    child->fpu_state = fpu_alloc_state();
+    if (child->fpu_state == NULL) {
+        printkf_error("fpu_fork(): failed to allocate FPU state\n");
+        return -1;
+    }
+
+    preempt_disable();
+
+    cpu_t *cpu = cpu_current();
+    if (cpu->fpu_owner == parent) {
+        fpu_save(parent->fpu_state);
+    }
+    memcpy(child->fpu_state, parent->fpu_state, fpu_size);
+
+    preempt_enable();
+
+    return 0;
+}
+
+void fpu_release(task_t *task) {
+    if (task->fpu_state == NULL) {
+        return;
+    }
+
+    preempt_disable();
+
+    cpu_t *self = cpu_current();
+    if (self->fpu_owner == task) {
+        self->fpu_owner = NULL;
+        write_cr0(read_cr0() | CR0_TS);
+    }
+
+    for (uint32_t i = 0; i < cpu_count(); i++) {
+        cpu_t *cpu = cpu_get(i);
+        if (cpu != NULL && cpu->fpu_last == task) {
+            cpu->fpu_last = NULL;
+        }
+    }
+
+    pfallocator_free_page(task->fpu_state);
+    task->fpu_state = NULL;
+
+    preempt_enable();
+}
+
+__attribute__((interrupt)) void fpu_nm_handler(struct interrupt_frame *frame) {
+    interrupt_enter(frame);
+
+    cpu_t *cpu = cpu_current();
+    task_t *task = cpu->current;
+
+    clts();
+
+    if (task->fpu_state == NULL) {
+        task->fpu_state = fpu_alloc_state();
+        if (task->fpu_state == NULL) {
+            panic_with_frame(frame, 0, "FPU STATE ALLOCATION FAILED");
+        }
+        cpu->fpu_last = NULL;
+    }
+
+    if (cpu->fpu_last != task || task->fpu_cpu != cpu->id) {
+        fpu_restore(task->fpu_state);
+    }
+
+    cpu->fpu_owner = task;
+    cpu->fpu_last = task;
+    task->fpu_cpu = cpu->id;
+
+    interrupt_leave(frame);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../../../interrupts/interrupts.h"
+#include "../../../task/task.h"
+
+#define CR0_MP (1 << 1)
+#define CR0_EM (1 << 2)
+#define CR0_TS (1 << 3)
+#define CR0_NE (1 << 5)
+
+#define CR4_OSFXSR (1 << 9)
+#define CR4_OSXMMEXCPT (1 << 10)
+#define CR4_OSXSAVE (1 << 18)
+
+#define XCR0_X87 (1 << 0)
+#define XCR0_SSE (1 << 1)
+#define XCR0_AVX (1 << 2)
+
+#define FPU_NM_VECTOR 0x07
+
+void fpu_init_cpu();
+uint32_t fpu_state_size();
+
+void fpu_switch(task_t *prev, task_t *next);
+int fpu_fork(task_t *parent, task_t *child);
+void fpu_release(task_t *task);
+
+__attribute__((interrupt)) void fpu_nm_handler(struct interrupt_frame *frame);
@@ -59,5 +59,5 @@ extern tss_t _g_tss;
 
 extern void load_gdt(gdt_desc_t* gdt_desc);
 
-void gdt_init();
+void gdt_init(gdt_t *gdt, tss_t *tss);
 void tss_set_kernel_stack(uint64_t stack);
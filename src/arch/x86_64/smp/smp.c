@@ -0,0 +1,69 @@
+#include "smp.h"
+
+#include <stddef.h>
+
+#include "../../../drivers/apic/lapic.h"
+#include "../../../interrupts/interrupts.h"
+#include "../../../io/terminal.h"
+#include "../../../mem/paging/paging.h"
+#include "../../../syscall/syscall.h"
+#include "../../../task/scheduler.h"
+#include "../cpu/cpu.h"
+
+static volatile uint32_t aps_online = 0;
+
+static void ap_entry(struct limine_mp_info *info) {
+    cpu_t *cpu = (cpu_t *)info->extra_argument;
+
+    uint64_t cr3 = (uint64_t)page_get_pml4() - page_get_offset();
+    __asm__ volatile("mov %0, %%cr3" : : "r"(cr3) : "memory");
+
+    cpu_setup(cpu);
+    interrupts_load();
+    syscall_init_cpu();
+
+    lapic_init();
+    lapic_timer_start();
+
+    scheduler_init_cpu();
+
+    cpu->online = true;
+    __atomic_fetch_add(&aps_online, 1, __ATOMIC_SEQ_CST);
+
+    scheduler_idle();
+}
+
+void smp_init(struct limine_mp_response *mp) {
+    cpu_t *bsp = cpu_current();
+    bsp->lapic_id = lapic_get_id();
+
+    if (mp == NULL) {
+        printkf_error("smp_init(): no MP response, running on BSP only\n");
+        return;
+    }
+
+    lapic_timer_calibrate();
+
+    uint32_t started = 0;
+    for (uint64_t i = 0; i < mp->cpu_count; i++) {
+        struct limine_mp_info *info = mp->cpus[i];
+        if (info->lapic_id == mp->bsp_lapic_id) {
+            continue;
+        }
+
+        cpu_t *cpu = cpu_create(info->lapic_id);
+        if (cpu == NULL) {
+            break;
+        }
+
+        info->extra_argument = (uint64_t)cpu;
+        __atomic_store_n(&info->goto_address, ap_entry, __ATOMIC_SEQ_CST);
+        started++;
+    }
+
+    while (__atomic_load_n(&aps_online, __ATOMIC_SEQ_CST) < started) {
+        cpu_relax();
+    }
+
+    printkf_ok("SMP: %u CPUs online\n", started + 1);
+}
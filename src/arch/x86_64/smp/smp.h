@@ -0,0 +1,5 @@
+#pragma once
+
+#include "../../../limine.h"
+
+void smp_init(struct limine_mp_response *mp);
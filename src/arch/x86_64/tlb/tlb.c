@@ -0,0 +1,80 @@
+#include "tlb.h"
+
+#include "../../../drivers/apic/lapic.h"
+#include "../../../task/scheduler.h"
+#include "../cpu/cpu.h"
+
+static inline void tlb_flush_local() {
+    uint64_t cr3;
+    __asm__ volatile("mov %%cr3, %0\n\t"
+                     "mov %0, %%cr3"
+                     : "=r"(cr3)
+                     :
+                     : "memory");
+}
+
+void tlb_flush_pending() {
+    uint64_t flags;
+    __asm__ volatile("pushfq; pop %0; cli" : "=r"(flags) : : "memory");
+
+    cpu_t *cpu = cpu_current();
+    uint64_t req = __atomic_load_n(&cpu->tlb_flush_req, __ATOMIC_ACQUIRE);
+
+    if (req != cpu->tlb_flush_done) {
+        tlb_flush_local();
+        __atomic_store_n(&cpu->tlb_flush_done, req, __ATOMIC_RELEASE);
+    }
+
+    __asm__ volatile("push %0; popfq" : : "r"(flags) : "memory", "cc");
+}
+
+static void tlb_shootdown_remote(page_table_t *pml4) {
+    cpu_t *self = cpu_current();
+    uint64_t tickets[MAX_CPUS];
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    for (uint32_t i = 0; i < cpu_count(); i++) {
+        cpu_t *cpu = cpu_get(i);
+        tickets[i] = 0;
+
+        if (cpu == NULL || cpu == self || !cpu->online || __atomic_load_n(&cpu->page_table, __ATOMIC_SEQ_CST) != pml4)
+            continue;
+
+        tickets[i] = __atomic_add_fetch(&cpu->tlb_flush_req, 1, __ATOMIC_SEQ_CST);
+        lapic_send_ipi(cpu->lapic_id, LAPIC_IPI_VECTOR);
+    }
+
+    for (uint32_t i = 0; i < cpu_count(); i++) {
+        if (tickets[i] == 0)
+            continue;
+
+        cpu_t *cpu = cpu_get(i);
+        while (__atomic_load_n(&cpu->tlb_flush_done, __ATOMIC_ACQUIRE) < tickets[i]) {
+            tlb_flush_pending();
+            cpu_relax();
+        }
+    }
+}
+
+void tlb_shootdown(page_table_t *pml4, void *virt) {
+    preempt_disable();
+
+    if (cpu_current()->page_table == pml4) {
+        __asm__ volatile("invlpg (%0)" : : "r"(virt) : "memory");
+    }
+    tlb_shootdown_remote(pml4);
+
+    preempt_enable();
+}
+
+void tlb_shootdown_all(page_table_t *pml4) {
+    preempt_disable();
+
+    if (cpu_current()->page_table == pml4) {
+        tlb_flush_local();
+    }
+    tlb_shootdown_remote(pml4);
+
+    preempt_enable();
+}
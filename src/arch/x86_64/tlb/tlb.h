@@ -0,0 +1,7 @@
+#pragma once
+
+#include "../../../mem/paging/paging.h"
+
+void tlb_flush_pending();
+void tlb_shootdown(page_table_t *pml4, void *virt);
+void tlb_shootdown_all(page_table_t *pml4);
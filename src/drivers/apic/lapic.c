@@ -0,0 +1,102 @@
+#include "lapic.h"
+
+#include <stddef.h>
+
+#include "../../arch/x86_64/cpu/cpu.h"
+#include "../../arch/x86_64/tlb/tlb.h"
+#include "../../io/terminal.h"
+#include "../../mem/paging/paging.h"
+#include "../../task/scheduler.h"
+#include "../timer/timer.h"
+
+static volatile uint32_t *lapic_regs = NULL;
+static uint32_t lapic_timer_ticks = 0;
+
+static uint32_t lapic_read(uint32_t reg) {
+    return lapic_regs[reg / 4];
+}
+
+static void lapic_write(uint32_t reg, uint32_t value) {
+    lapic_regs[reg / 4] = value;
+}
+
+void lapic_init() {
+    if (lapic_regs == NULL) {
+        uint64_t phys = rdmsr(MSR_APIC_BASE) & ~0xFFFULL;
+        uint64_t virt = phys + page_get_offset();
+
+        page_map_mmio((void *)virt, (void *)phys);
+        lapic_regs = (volatile uint32_t *)virt;
+    }
+
+    lapic_write(LAPIC_REG_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS_VECTOR);
+}
+
+uint32_t lapic_get_id() {
+    return lapic_read(LAPIC_REG_ID) >> 24;
+}
+
+void lapic_eoi() {
+    lapic_write(LAPIC_REG_EOI, 0);
+}
+
+void lapic_send_ipi(uint32_t lapic_id, uint8_t vector) {
+    if (lapic_regs == NULL)
+        return;
+
+    lapic_write(LAPIC_REG_ICR_HIGH, lapic_id << 24);
+    lapic_write(LAPIC_REG_ICR_LOW, vector);
+
+    while (lapic_read(LAPIC_REG_ICR_LOW) & LAPIC_ICR_PENDING) {
+        cpu_relax();
+    }
+}
+
+void lapic_timer_calibrate() {
+    lapic_write(LAPIC_REG_TIMER_DIV, LAPIC_TIMER_DIV_16);
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED);
+
+    uint64_t start = timer_get_ticks();
+    while (timer_get_ticks() == start) {
+        __asm__ volatile("hlt");
+    }
+
+    lapic_write(LAPIC_REG_TIMER_INIT, 0xFFFFFFFF);
+
+    start = timer_get_ticks();
+    while (timer_get_ticks() - start < LAPIC_CALIBRATION_TICKS) {
+        __asm__ volatile("hlt");
+    }
+
+    uint32_t elapsed = 0xFFFFFFFF - lapic_read(LAPIC_REG_TIMER_CURRENT);
+    lapic_write(LAPIC_REG_TIMER_INIT, 0);
+
+    lapic_timer_ticks = elapsed / LAPIC_CALIBRATION_TICKS;
+    printkf_info("LAPIC timer: %u ticks per period\n", lapic_timer_ticks);
+}
+
+void lapic_timer_start() {
+    lapic_write(LAPIC_REG_TIMER_DIV, LAPIC_TIMER_DIV_16);
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_TIMER_VECTOR | LAPIC_TIMER_PERIODIC);
+    lapic_write(LAPIC_REG_TIMER_INIT, lapic_timer_ticks);
+}
+
+__attribute__((interrupt)) void lapic_timer_handler(struct interrupt_frame *frame) {
+    interrupt_enter(frame);
+    lapic_eoi();
+    cpu_current()->tick_from_user = frame->cs & 3;
+    scheduler_tick();
+    interrupt_leave(frame);
+}
+
+__attribute__((interrupt)) void lapic_ipi_handler(struct interrupt_frame *frame) {
+    interrupt_enter(frame);
+    lapic_eoi();
+    tlb_flush_pending();
+    preempt_check_resched();
+    interrupt_leave(frame);
+}
+
+__attribute__((interrupt)) void lapic_spurious_handler(struct interrupt_frame *frame) {
+    (void)frame;
+}
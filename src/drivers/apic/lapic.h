@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "../../interrupts/interrupts.h"
+
+#define LAPIC_REG_ID 0x20
+#define LAPIC_REG_EOI 0xB0
+#define LAPIC_REG_SVR 0xF0
+#define LAPIC_REG_ICR_LOW 0x300
+#define LAPIC_REG_ICR_HIGH 0x310
+#define LAPIC_REG_LVT_TIMER 0x320
+#define LAPIC_REG_TIMER_INIT 0x380
+#define LAPIC_REG_TIMER_CURRENT 0x390
+#define LAPIC_REG_TIMER_DIV 0x3E0
+
+#define LAPIC_SVR_ENABLE (1 << 8)
+#define LAPIC_LVT_MASKED (1 << 16)
+#define LAPIC_TIMER_PERIODIC (1 << 17)
+#define LAPIC_ICR_PENDING (1 << 12)
+#define LAPIC_TIMER_DIV_16 0x3
+
+#define LAPIC_TIMER_VECTOR 0x30
+#define LAPIC_IPI_VECTOR 0x31
+#define LAPIC_SPURIOUS_VECTOR 0xFF
+
+#define LAPIC_CALIBRATION_TICKS 10
+
+void lapic_init();
+uint32_t lapic_get_id();
+void lapic_eoi();
+void lapic_send_ipi(uint32_t lapic_id, uint8_t vector);
+
+void lapic_timer_calibrate();
+void lapic_timer_start();
+
+__attribute__((interrupt)) void lapic_timer_handler(struct interrupt_frame *frame);
+__attribute__((interrupt)) void lapic_ipi_handler(struct interrupt_frame *frame);
+__attribute__((interrupt)) void lapic_spurious_handler(struct interrupt_frame *frame);
@@ -4,7 +4,8 @@
 
 #include "../../io/io.h"
 #include "../../io/terminal.h"
-#include "../../task/task.h"
+#include "../../sync/spinlock.h"
+#include "../../sync/waitqueue.h"
 #include "../pic/pic.h"
 
 #define KEYBOARD_BUFFER_SIZE 256
@@ -13,7 +14,8 @@ static char buffer[KEYBOARD_BUFFER_SIZE];
 static size_t buffer_head = 0;
 static size_t buffer_tail = 0;
 
-static task_t *waiting_task = NULL;
+static spinlock_t buffer_lock = {0};
+static wait_queue_t keyboard_wq = {0};
 
 static bool shift_pressed = false;
 
@@ -34,23 +36,21 @@ static const char scancode_to_char_shift[128] = {
     0,   0,   0,   0,   0,   0,   0,    0,   0,   0,   0,   0,   0,   0,   0,    0,    0,   0};
 
 static void buffer_put(char c) {
-    size_t next_head = (buffer_head + 1) % KEYBOARD_BUFFER_SIZE;
+    uint64_t flags = spin_lock(&buffer_lock);
 
-    if (next_head == buffer_tail) {
-        return;
+    size_t next_head = (buffer_head + 1) % KEYBOARD_BUFFER_SIZE;
+    if (next_head != buffer_tail) {
+        buffer[buffer_head] = c;
+        buffer_head = next_head;
     }
 
-    buffer[buffer_head] = c;
-    buffer_head = next_head;
+    spin_unlock(&buffer_lock, flags);
+
+    wait_queue_wake_one(&keyboard_wq);
 }
 
 void keyboard_buffer_put(char c) {
     buffer_put(c);
-
-    if (waiting_task != NULL) {
-        task_unblock(waiting_task);
-        waiting_task = NULL;
-    }
 }
 
 static bool buffer_empty() {
@@ -66,7 +66,7 @@ static char buffer_get() {
 void keyboard_init() {
     buffer_head = 0;
     buffer_tail = 0;
-    waiting_task = NULL;
+    wait_queue_init(&keyboard_wq);
     shift_pressed = false;
 
     while (inb(0x64) & 0x01) {
@@ -75,7 +75,7 @@ void keyboard_init() {
 }
 
 void keyboard_handler(struct interrupt_frame *frame) {
-    (void)frame;
+    interrupt_enter(frame);
 
     uint8_t scancode = inb(0x60);
 
@@ -87,31 +87,24 @@ void keyboard_handler(struct interrupt_frame *frame) {
         char c = shift_pressed ? scancode_to_char_shift[scancode] : scancode_to_char[scancode];
         if (c != 0) {
             buffer_put(c);
-
-            if (waiting_task != NULL) {
-                task_unblock(waiting_task);
-                waiting_task = NULL;
-            }
         }
     }
 
     outb(PIC1_COMMAND, PIC_EOI);
+    interrupt_leave(frame);
 }
 
 char keyboard_getchar() {
     while (1) {
-        cli();
+        wait_event(&keyboard_wq, !buffer_empty());
 
+        uint64_t flags = spin_lock(&buffer_lock);
         if (!buffer_empty()) {
             char c = buffer_get();
-            sti();
+            spin_unlock(&buffer_lock, flags);
             return c;
         }
-
-        waiting_task = task_current();
-
-        sti();
-        task_block();
+        spin_unlock(&buffer_lock, flags);
     }
 }
 
@@ -119,6 +112,10 @@ bool keyboard_haschar() {
     return !buffer_empty();
 }
 
+wait_queue_t *keyboard_wait_queue() {
+    return &keyboard_wq;
+}
+
 void keyboard_pic_start() {
     pic_set_mask(1, false);
 }
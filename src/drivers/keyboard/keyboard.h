@@ -4,6 +4,7 @@
 #include <stdint.h>
 
 #include "../../interrupts/interrupts.h"
+#include "../../sync/waitqueue.h"
 
 void keyboard_init();
 
@@ -11,6 +12,7 @@ __attribute__((interrupt)) void keyboard_handler(struct interrupt_frame *frame);
 
 char keyboard_getchar();
 bool keyboard_haschar();
+wait_queue_t *keyboard_wait_queue();
 
 void keyboard_pic_start();
 void keyboard_buffer_put(char c);
\ No newline at end of file
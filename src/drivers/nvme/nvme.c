@@ -5,6 +5,8 @@
 #include "../../mem/alloc/page_frame_alloc.h"
 #include "../../mem/paging/paging.h"
 #include "../../std/string.h"
+#include "../../task/scheduler.h"
+#include "../apic/lapic.h"
 #include "../pci/pci.h"
 
 static const pci_device_id_t nvme_ids[] = {
@@ -12,7 +14,7 @@ static const pci_device_id_t nvme_ids[] = {
     {0},
 };
 
-static int nvme_submit_command(nvme_queue_t *queue, nvme_sqe_t *cmd, void *result) {
+static uint16_t nvme_queue_push(nvme_queue_t *queue, nvme_sqe_t *cmd) {
     uint16_t tail = queue->sq_tail;
 
     memcpy(&queue->sq[tail], cmd, sizeof(nvme_sqe_t));
@@ -22,51 +24,115 @@ static int nvme_submit_command(nvme_queue_t *queue, nvme_sqe_t *cmd, void *resul
 
     *queue->sq_doorbell = queue->sq_tail;
 
-    uint16_t cid = tail;
-    uint32_t timeout = 1000000;
+    return tail;
+}
 
-    while (timeout--) {
-        __asm__ volatile("mfence" ::: "memory");
+static bool nvme_queue_pending(nvme_queue_t *queue) {
+    __asm__ volatile("mfence" ::: "memory");
 
-        nvme_cqe_t *cqe = &queue->cq[queue->cq_head];
+    nvme_cqe_t *cqe = &queue->cq[queue->cq_head];
+    return (cqe->status & 1) == queue->phase;
+}
 
-        uint16_t phase = (cqe->status >> 0) & 1;
-        if (phase != queue->phase) {
-            continue;
-        }
+static bool nvme_queue_reap(nvme_queue_t *queue, uint16_t cid, void *result, int *ret) {
+    while (nvme_queue_pending(queue)) {
+        nvme_cqe_t *cqe = &queue->cq[queue->cq_head];
 
         uint16_t completion_cid = cqe->cid;
         uint16_t status = (cqe->status >> 1) & 0x7FF;
 
-        if (completion_cid == cid) {
-            if (result) {
-                memcpy(result, cqe, sizeof(nvme_cqe_t));
-            }
+        if (completion_cid == cid && result) {
+            memcpy(result, cqe, sizeof(nvme_cqe_t));
+        }
 
-            queue->cq_head = (queue->cq_head + 1) % queue->size;
-            if (queue->cq_head == 0) {
-                queue->phase = !queue->phase;
-            }
-            *queue->cq_doorbell = queue->cq_head;
+        queue->cq_head = (queue->cq_head + 1) % queue->size;
+        if (queue->cq_head == 0) {
+            queue->phase = !queue->phase;
+        }
+        *queue->cq_doorbell = queue->cq_head;
 
+        if (completion_cid == cid) {
             if (status != 0) {
                 printkf_error("nvme_submit_command(): Command %u failed with status 0x%x\n", cid, status);
             }
-            return status == 0 ? 0 : -1;
+            *ret = status == 0 ? 0 : -1;
+            return true;
         }
 
         printkf_info("nvme_submit_command(): Got completion for CID %u while waiting for %u\n", completion_cid, cid);
-        queue->cq_head = (queue->cq_head + 1) % queue->size;
-        if (queue->cq_head == 0) {
-            queue->phase = !queue->phase;
+    }
+
+    return false;
+}
+
+static int nvme_poll_command(nvme_queue_t *queue, nvme_sqe_t *cmd, void *result) {
+    uint64_t flags = spin_lock(&queue->lock);
+
+    uint16_t cid = nvme_queue_push(queue, cmd);
+    uint32_t timeout = 1000000;
+    int ret = -1;
+
+    while (timeout--) {
+        if (nvme_queue_reap(queue, cid, result, &ret)) {
+            spin_unlock(&queue->lock, flags);
+            return ret;
         }
-        *queue->cq_doorbell = queue->cq_head;
     }
 
-    printkf_error("nvme_submit_command(): Command %u timeout (no completion after %u iterations)\n", cid, 5000000);
+    spin_unlock(&queue->lock, flags);
+
+    printkf_error("nvme_submit_command(): Command %u timeout (no completion after %u iterations)\n", cid, 1000000);
     return -1;
 }
 
+static int nvme_wait_command(nvme_queue_t *queue, nvme_sqe_t *cmd, void *result) {
+    uint64_t flags = spin_lock(&queue->lock);
+    uint16_t cid = nvme_queue_push(queue, cmd);
+    spin_unlock(&queue->lock, flags);
+
+    int ret = -1;
+    while (1) {
+        bool pending = wait_event_timeout(&queue->wq, nvme_queue_pending(queue), NVME_IO_TIMEOUT_MS);
+
+        flags = spin_lock(&queue->lock);
+        bool done = nvme_queue_reap(queue, cid, result, &ret);
+        spin_unlock(&queue->lock, flags);
+
+        if (done)
+            return ret;
+
+        if (!pending) {
+            printkf_error("nvme_submit_command(): Command %u timeout (no completion after %u ms)\n", cid,
+                          NVME_IO_TIMEOUT_MS);
+            return -1;
+        }
+    }
+}
+
+static int nvme_submit_command(nvme_queue_t *queue, nvme_sqe_t *cmd, void *result) {
+    if (queue->irq_enabled && scheduler_is_enabled()) {
+        return nvme_wait_command(queue, cmd, result);
+    }
+
+    return nvme_poll_command(queue, cmd, result);
+}
+
+__attribute__((interrupt)) void nvme_irq_handler(struct interrupt_frame *frame) {
+    interrupt_enter(frame);
+    lapic_eoi();
+
+    for (nvme_device_node_t *node = nvme_get_devices(); node != NULL; node = node->next) {
+        nvme_ctrl_t *ctrl = node->ctrl;
+        for (uint32_t i = 0; i < ctrl->num_io_queues; i++) {
+            if (ctrl->io_queues[i].irq_enabled) {
+                wait_queue_wake_all(&ctrl->io_queues[i].wq);
+            }
+        }
+    }
+
+    interrupt_leave(frame);
+}
+
 static int nvme_reset_controller(nvme_ctrl_t *ctrl) {
     ctrl->regs->cc = 0;
 
@@ -227,6 +293,9 @@ static int nvme_create_io_queues(nvme_ctrl_t *ctrl, uint16_t num_queues) {
         queue->sq_tail = 0;
         queue->cq_head = 0;
         queue->phase = 1;
+        queue->lock.locked = 0;
+        queue->irq_enabled = ctrl->irq_enabled;
+        wait_queue_init(&queue->wq);
 
         uint64_t sq_phys = virt_to_phys(queue->sq);
         uint64_t cq_phys = virt_to_phys(queue->cq);
@@ -235,7 +304,7 @@ static int nvme_create_io_queues(nvme_ctrl_t *ctrl, uint16_t num_queues) {
         cmd.cdw0 = NVME_ADMIN_CREATE_IO_CQ;
         cmd.prp1 = cq_phys;
         cmd.cdw10 = ((queue_size - 1) << 16) | qid;
-        cmd.cdw11 = 0x1;
+        cmd.cdw11 = queue->irq_enabled ? 0x3 : 0x1;
 
         if (nvme_submit_command(&ctrl->admin_queue, &cmd, NULL) < 0) {
             printkf_error("nvme_create_io_queues(): Failed to create I/O CQ %u\n", qid);
@@ -310,6 +379,7 @@ static int nvme_probe(pci_device_t *pdev) {
         return -1;
     }
     memset(ctrl, 0, sizeof(nvme_ctrl_t));
+    mutex_init(&ctrl->io_lock);
 
     device_set_driver_data(&pdev->device, ctrl);
 
@@ -355,6 +425,13 @@ static int nvme_probe(pci_device_t *pdev) {
         printkf_error("nvme_probe(): Failed to identify namespace 1\n");
     }
 
+    if (pci_enable_msix(pdev, 0, lapic_get_id(), NVME_IRQ_VECTOR) == 0 ||
+        pci_enable_msi(pdev, lapic_get_id(), NVME_IRQ_VECTOR) == 0) {
+        ctrl->irq_enabled = true;
+    } else {
+        printkf_info("nvme_probe(): No MSI/MSI-X support, falling back to polling\n");
+    }
+
     if (nvme_create_io_queues(ctrl, 1) < 0) {
         printkf_error("nvme_probe(): Failed to create IO queues\n");
     }
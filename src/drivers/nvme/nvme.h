@@ -1,13 +1,22 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 
+#include "../../interrupts/interrupts.h"
+#include "../../sync/mutex.h"
+#include "../../sync/spinlock.h"
+#include "../../sync/waitqueue.h"
+
 #define NVME_ADMIN_IDENTIFY 0x06
 #define NVME_ADMIN_CREATE_IO_CQ 0x05
 #define NVME_ADMIN_CREATE_IO_SQ 0x01
 #define NVME_CMD_READ 0x02
 #define NVME_CMD_WRITE 0x01
 
+#define NVME_IRQ_VECTOR 0x40
+#define NVME_IO_TIMEOUT_MS 5000
+
 typedef struct {
     uint64_t cap;
     uint32_t vs;
@@ -55,12 +64,17 @@ typedef struct {
     uint16_t cq_head;
     uint16_t phase;
     uint16_t size;
+    spinlock_t lock;
+    wait_queue_t wq;
+    bool irq_enabled;
 } nvme_queue_t;
 
 typedef struct {
     volatile nvme_bar_t *regs;
     void *mmio_base;
     void *dma_buffer;
+    mutex_t io_lock;
+    bool irq_enabled;
 
     nvme_queue_t admin_queue;
     nvme_queue_t *io_queues;
@@ -83,4 +97,7 @@ typedef struct nvme_device_node {
 void nvme_driver_init();
 int nvme_read(nvme_ctrl_t *ctrl, uint64_t lba, uint32_t num_blocks, void *buffer);
 int nvme_write(nvme_ctrl_t *ctrl, uint64_t lba, uint32_t num_blocks, const void *buffer);
-void nvme_register_device(nvme_ctrl_t *ctrl);
\ No newline at end of file
+void nvme_register_device(nvme_ctrl_t *ctrl);
+nvme_device_node_t *nvme_get_devices(void);
+
+__attribute__((interrupt)) void nvme_irq_handler(struct interrupt_frame *frame);
\ No newline at end of file
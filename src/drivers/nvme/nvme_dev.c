@@ -10,13 +10,65 @@ static nvme_device_node_t *device_list = NULL;
 static int next_device_id = 0;
 
 static nvme_ctrl_t *get_ctrl_from_node(vfs_node_t *node) {
-    return (nvme_ctrl_t *)node->data;
+    return (nvme_ctrl_t *)node->inode->data;
 }
 
-static int64_t nvme_dev_read(vfs_node_t *node, void *buf, size_t size, size_t offset) {
-    nvme_ctrl_t *ctrl = get_ctrl_from_node(node);
-    if (!ctrl)
-        return -1;
+typedef struct {
+    const vfs_iovec_t *iov;
+    int iovcnt;
+    int index;
+    size_t pos;
+} iov_cursor_t;
+
+static size_t iov_total(const vfs_iovec_t *iov, int iovcnt) {
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        total += iov[i].len;
+    }
+    return total;
+}
+
+static void iov_copy_out(iov_cursor_t *cur, const uint8_t *src, size_t size) {
+    while (size > 0 && cur->index < cur->iovcnt) {
+        const vfs_iovec_t *seg = &cur->iov[cur->index];
+        size_t n = seg->len - cur->pos;
+        if (n > size)
+            n = size;
+
+        memcpy((uint8_t *)seg->base + cur->pos, src, n);
+        src += n;
+        size -= n;
+        cur->pos += n;
+
+        if (cur->pos == seg->len) {
+            cur->index++;
+            cur->pos = 0;
+        }
+    }
+}
+
+static void iov_copy_in(iov_cursor_t *cur, uint8_t *dst, size_t size) {
+    while (size > 0 && cur->index < cur->iovcnt) {
+        const vfs_iovec_t *seg = &cur->iov[cur->index];
+        size_t n = seg->len - cur->pos;
+        if (n > size)
+            n = size;
+
+        memcpy(dst, (const uint8_t *)seg->base + cur->pos, n);
+        dst += n;
+        size -= n;
+        cur->pos += n;
+
+        if (cur->pos == seg->len) {
+            cur->index++;
+            cur->pos = 0;
+        }
+    }
+}
+
+static int64_t nvme_dev_do_readv(nvme_ctrl_t *ctrl, const vfs_iovec_t *iov, int iovcnt, size_t offset) {
+    size_t size = iov_total(iov, iovcnt);
+    iov_cursor_t cur = {iov, iovcnt, 0, 0};
 
     uint64_t start_lba = offset / ctrl->block_size;
     size_t start_offset = offset % ctrl->block_size;
@@ -57,7 +109,7 @@ static int64_t nvme_dev_read(vfs_node_t *node, void *buf, size_t size, size_t of
         }
 
         size_t copy_size = chunk_end - chunk_start;
-        memcpy((uint8_t *)buf + bytes_copied, (uint8_t *)dma_buffer + chunk_start, copy_size);
+        iov_copy_out(&cur, (uint8_t *)dma_buffer + chunk_start, copy_size);
 
         bytes_copied += copy_size;
         current_lba += chunk;
@@ -66,10 +118,9 @@ static int64_t nvme_dev_read(vfs_node_t *node, void *buf, size_t size, size_t of
     return bytes_copied;
 }
 
-static int64_t nvme_dev_write(vfs_node_t *node, const void *buf, size_t size, size_t offset) {
-    nvme_ctrl_t *ctrl = get_ctrl_from_node(node);
-    if (!ctrl)
-        return -1;
+static int64_t nvme_dev_do_writev(nvme_ctrl_t *ctrl, const vfs_iovec_t *iov, int iovcnt, size_t offset) {
+    size_t size = iov_total(iov, iovcnt);
+    iov_cursor_t cur = {iov, iovcnt, 0, 0};
 
     uint64_t start_lba = offset / ctrl->block_size;
     size_t start_offset = offset % ctrl->block_size;
@@ -111,7 +162,7 @@ static int64_t nvme_dev_write(vfs_node_t *node, const void *buf, size_t size, si
         }
 
         size_t copy_size = write_end - write_start;
-        memcpy((uint8_t *)dma_buffer + write_start, (uint8_t *)buf + bytes_written, copy_size);
+        iov_copy_in(&cur, (uint8_t *)dma_buffer + write_start, copy_size);
 
         if (nvme_write(ctrl, current_lba, chunk, dma_buffer) < 0) {
             printkf_error("nvme_dev_write(): NVMe write failed at block %llu\n", current_lba);
@@ -125,9 +176,63 @@ static int64_t nvme_dev_write(vfs_node_t *node, const void *buf, size_t size, si
     return bytes_written;
 }
 
+static int64_t nvme_dev_read(vfs_node_t *node, void *buf, size_t size, size_t offset) {
+    nvme_ctrl_t *ctrl = get_ctrl_from_node(node);
+    if (!ctrl)
+        return -1;
+
+    vfs_iovec_t iov = {buf, size};
+
+    mutex_lock(&ctrl->io_lock);
+    int64_t ret = nvme_dev_do_readv(ctrl, &iov, 1, offset);
+    mutex_unlock(&ctrl->io_lock);
+
+    return ret;
+}
+
+static int64_t nvme_dev_write(vfs_node_t *node, const void *buf, size_t size, size_t offset) {
+    nvme_ctrl_t *ctrl = get_ctrl_from_node(node);
+    if (!ctrl)
+        return -1;
+
+    vfs_iovec_t iov = {(void *)buf, size};
+
+    mutex_lock(&ctrl->io_lock);
+    int64_t ret = nvme_dev_do_writev(ctrl, &iov, 1, offset);
+    mutex_unlock(&ctrl->io_lock);
+
+    return ret;
+}
+
+static int64_t nvme_dev_readv(vfs_node_t *node, const vfs_iovec_t *iov, int iovcnt, size_t offset) {
+    nvme_ctrl_t *ctrl = get_ctrl_from_node(node);
+    if (!ctrl)
+        return -1;
+
+    mutex_lock(&ctrl->io_lock);
+    int64_t ret = nvme_dev_do_readv(ctrl, iov, iovcnt, offset);
+    mutex_unlock(&ctrl->io_lock);
+
+    return ret;
+}
+
+static int64_t nvme_dev_writev(vfs_node_t *node, const vfs_iovec_t *iov, int iovcnt, size_t offset) {
+    nvme_ctrl_t *ctrl = get_ctrl_from_node(node);
+    if (!ctrl)
+        return -1;
+
+    mutex_lock(&ctrl->io_lock);
+    int64_t ret = nvme_dev_do_writev(ctrl, iov, iovcnt, offset);
+    mutex_unlock(&ctrl->io_lock);
+
+    return ret;
+}
+
 static vfs_ops_t nvme_dev_ops = {
     .read = nvme_dev_read,
     .write = nvme_dev_write,
+    .readv = nvme_dev_readv,
+    .writev = nvme_dev_writev,
     .create = NULL,
     .unlink = NULL,
     .truncate = NULL,
@@ -155,10 +260,10 @@ void nvme_register_device(nvme_ctrl_t *ctrl) {
     }
 
     nvme_node->ops = &nvme_dev_ops;
-    nvme_node->size = ctrl->num_blocks * ctrl->block_size;
-    nvme_node->data = ctrl;
+    nvme_node->inode->size = ctrl->num_blocks * ctrl->block_size;
+    nvme_node->inode->data = ctrl;
 
-    printkf_ok("Registered NVMe device at %s (%llu MB)\n", dev_path, nvme_node->size / (1024 * 1024));
+    printkf_ok("Registered NVMe device at %s (%llu MB)\n", dev_path, nvme_node->inode->size / (1024 * 1024));
 
     partition_table_t *table = partition_parse_mbr(dev_path);
     if (table) {
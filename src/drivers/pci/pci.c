@@ -231,4 +231,85 @@ void pci_enable_mmio(pci_device_t *dev) {
     uint16_t command = pci_read_config_word(dev, 0x04);
     command |= (1 << 1);
     pci_write_config_word(dev, 0x04, command);
+}
+
+uint8_t pci_find_capability(pci_device_t *dev, uint8_t cap_id) {
+    uint16_t status = pci_read_config_word(dev, 0x06);
+    if (!(status & (1 << 4)))
+        return 0;
+
+    uint8_t ptr = pci_read_config_byte(dev, 0x34) & ~0x3;
+    while (ptr != 0) {
+        if (pci_read_config_byte(dev, ptr) == cap_id)
+            return ptr;
+        ptr = pci_read_config_byte(dev, ptr + 1) & ~0x3;
+    }
+
+    return 0;
+}
+
+static void pci_disable_intx(pci_device_t *dev) {
+    uint16_t command = pci_read_config_word(dev, 0x04);
+    command |= (1 << 10);
+    pci_write_config_word(dev, 0x04, command);
+}
+
+int pci_enable_msi(pci_device_t *dev, uint32_t lapic_id, uint8_t vector) {
+    uint8_t cap = pci_find_capability(dev, PCI_CAP_MSI);
+    if (cap == 0)
+        return -1;
+
+    uint16_t control = pci_read_config_word(dev, cap + 2);
+
+    pci_write_config_dword(dev, cap + 4, PCI_MSI_ADDRESS_BASE | (lapic_id << 12));
+    if (control & (1 << 7)) {
+        pci_write_config_dword(dev, cap + 8, 0);
+        pci_write_config_word(dev, cap + 12, vector);
+    } else {
+        pci_write_config_word(dev, cap + 8, vector);
+    }
+
+    control &= ~(0x7 << 4);
+    control |= 1;
+    pci_write_config_word(dev, cap + 2, control);
+
+    pci_disable_intx(dev);
+    return 0;
+}
+
+int pci_enable_msix(pci_device_t *dev, uint16_t entry, uint32_t lapic_id, uint8_t vector) {
+    uint8_t cap = pci_find_capability(dev, PCI_CAP_MSIX);
+    if (cap == 0)
+        return -1;
+
+    uint16_t control = pci_read_config_word(dev, cap + 2);
+    uint16_t table_size = (control & 0x7FF) + 1;
+    if (entry >= table_size)
+        return -1;
+
+    uint32_t table = pci_read_config_dword(dev, cap + 4);
+    uint8_t bir = table & 0x7;
+    uint32_t table_offset = table & ~0x7;
+
+    if (table_offset + (entry + 1) * 16 > 8 * 0x1000) {
+        printkf_error("pci_enable_msix(): MSI-X table outside mapped BAR window\n");
+        return -1;
+    }
+
+    uint8_t *bar = (uint8_t *)pci_map_bar(dev, bir);
+    if (bar == NULL)
+        return -1;
+
+    volatile uint32_t *msix_entry = (volatile uint32_t *)(bar + table_offset + entry * 16);
+    msix_entry[0] = PCI_MSI_ADDRESS_BASE | (lapic_id << 12);
+    msix_entry[1] = 0;
+    msix_entry[2] = vector;
+    msix_entry[3] = 0;
+
+    control |= (1 << 15);
+    control &= ~(1 << 14);
+    pci_write_config_word(dev, cap + 2, control);
+
+    pci_disable_intx(dev);
+    return 0;
 }
\ No newline at end of file
@@ -15,6 +15,11 @@ typedef struct {
 
 #define PCI_ANY_ID 0xFFFF
 
+#define PCI_CAP_MSI 0x05
+#define PCI_CAP_MSIX 0x11
+
+#define PCI_MSI_ADDRESS_BASE 0xFEE00000
+
 #define PCI_DEVICE(vend, dev) .vendor = (vend), .device = (dev), .subvendor = PCI_ANY_ID, .subdevice = PCI_ANY_ID
 
 #define PCI_DEVICE_CLASS(dev_class, dev_class_mask)                                                                    \
@@ -79,4 +84,8 @@ void *pci_map_bar(pci_device_t *dev, uint8_t bar_num);
 void pci_enable_bus_mastering(pci_device_t *dev);
 void pci_enable_mmio(pci_device_t *dev);
 
+uint8_t pci_find_capability(pci_device_t *dev, uint8_t cap_id);
+int pci_enable_msi(pci_device_t *dev, uint32_t lapic_id, uint8_t vector);
+int pci_enable_msix(pci_device_t *dev, uint16_t entry, uint32_t lapic_id, uint8_t vector);
+
 extern bus_type_t pci_bus_type;
@@ -17,6 +17,10 @@ uint64_t timer_get_ticks() {
     return pit_get_ticks();
 }
 
+uint32_t timer_get_frequency() {
+    return timer_frequency;
+}
+
 void timer_sleep(uint32_t ms) {
     if (timer_frequency == 0)
         return;
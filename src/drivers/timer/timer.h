@@ -9,6 +9,7 @@ typedef void (*timer_callback_t)();
 void timer_init(uint32_t frequency);
 void timer_set_callback(timer_callback_t callback);
 uint64_t timer_get_ticks();
+uint32_t timer_get_frequency();
 void timer_sleep(uint32_t ms);
 
 #endif
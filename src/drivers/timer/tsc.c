@@ -0,0 +1,46 @@
+#include "tsc.h"
+
+#include "../../io/terminal.h"
+#include "timer.h"
+
+static uint64_t tsc_khz = 0;
+
+void tsc_calibrate() {
+    uint32_t frequency = timer_get_frequency();
+    if (frequency == 0) {
+        printkf_error("tsc_calibrate(): timer not initialized\n");
+        return;
+    }
+
+    uint64_t start = timer_get_ticks();
+    while (timer_get_ticks() == start) {
+        __asm__ volatile("hlt");
+    }
+
+    uint64_t tsc_start = tsc_read();
+    start = timer_get_ticks();
+    while (timer_get_ticks() - start < TSC_CALIBRATION_TICKS) {
+        __asm__ volatile("hlt");
+    }
+    uint64_t elapsed = tsc_read() - tsc_start;
+
+    uint64_t elapsed_ms = (TSC_CALIBRATION_TICKS * 1000) / frequency;
+    tsc_khz = elapsed / elapsed_ms;
+
+    printkf_info("TSC: %llu kHz\n", tsc_khz);
+}
+
+uint64_t tsc_get_khz() {
+    return tsc_khz;
+}
+
+uint64_t tsc_to_ns(uint64_t cycles) {
+    if (tsc_khz == 0)
+        return 0;
+
+    return (cycles / tsc_khz) * 1000000 + ((cycles % tsc_khz) * 1000000) / tsc_khz;
+}
+
+uint64_t tsc_now_ns() {
+    return tsc_to_ns(tsc_read());
+}
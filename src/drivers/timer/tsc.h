@@ -0,0 +1,19 @@
+#ifndef TSC_H
+#define TSC_H
+
+#include <stdint.h>
+
+#define TSC_CALIBRATION_TICKS 10
+
+void tsc_calibrate();
+uint64_t tsc_get_khz();
+uint64_t tsc_to_ns(uint64_t cycles);
+uint64_t tsc_now_ns();
+
+static inline uint64_t tsc_read() {
+    uint32_t low, high;
+    __asm__ volatile("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t)high << 32) | low;
+}
+
+#endif
@@ -7,8 +7,11 @@
 #include "../../mem/paging/paging.h"
 #include "../../std/string.h"
 #include "../../task/scheduler.h"
+#include "../../task/workqueue.h"
 
 static usb_keyboard_t *keyboards = NULL;
+static workqueue_t *usb_keyboard_wq = NULL;
+static work_t usb_keyboard_work;
 
 static const char hid_to_ascii_lower[128] = {
     0,    0,    0,    0,    'a', 'b', 'c', 'd', 'e',  'f',  'g', 'h', 'i',  'j', 'k', 'l', 'm', 'n', 'o', 'p',
@@ -283,9 +286,19 @@ void usb_keyboard_poll() {
     }
 }
 
-void usb_keyboard_task() {
-    while (1) {
-        usb_keyboard_poll();
-        task_yield();
+static void usb_keyboard_work_fn(work_t *work) {
+    usb_keyboard_poll();
+    queue_delayed_work(work->wq, work, USB_KBD_POLL_MS);
+}
+
+int usb_keyboard_start() {
+    usb_keyboard_wq = workqueue_create("usbkbd", 1, WQ_HIGHPRI);
+    if (usb_keyboard_wq == NULL) {
+        printkf_error("usb_keyboard_start(): failed to create workqueue\n");
+        return -1;
     }
+
+    work_init(&usb_keyboard_work, usb_keyboard_work_fn);
+    queue_work(usb_keyboard_wq, &usb_keyboard_work);
+    return 0;
 }
\ No newline at end of file
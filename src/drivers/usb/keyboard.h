@@ -20,6 +20,8 @@ typedef struct {
 #define USB_KBD_MOD_RALT (1 << 6)
 #define USB_KBD_MOD_RGUI (1 << 7)
 
+#define USB_KBD_POLL_MS 10
+
 typedef struct usb_keyboard {
     xhci_controller_t *xhci;
     xhci_device_t *dev;
@@ -42,4 +44,4 @@ int usb_keyboard_probe(xhci_controller_t *xhci, xhci_device_t *dev);
 
 void usb_keyboard_poll(void);
 
-void usb_keyboard_task();
\ No newline at end of file
+int usb_keyboard_start();
\ No newline at end of file
@@ -75,7 +75,7 @@ int elf_load(const void *elf_data, uint64_t *out_entry, page_table_t *page_table
         uint64_t pages_needed = (total_size + 0xFFF) / 0x1000;
 
         for (uint64_t p = 0; p < pages_needed; p++) {
-            void *phys_page = pfallocator_request_page();
+            void *phys_page = pfallocator_request_zeroed_page();
             if (phys_page == NULL) {
                 printkf_error("elf_load(): out of memory\n");
                 return -1;
@@ -86,8 +86,6 @@ int elf_load(const void *elf_data, uint64_t *out_entry, page_table_t *page_table
 
             void *virt_addr = (void *)(vaddr_aligned + p * 0x1000);
             page_map_memory_to(page_table, virt_addr, phys_addr);
-
-            memset(phys_page, 0, 0x1000);
         }
 
         if (filesz > 0) {
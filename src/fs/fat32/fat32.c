@@ -2,7 +2,10 @@
 
 #include "../../io/terminal.h"
 #include "../../mem/alloc/heap.h"
+#include "../../mem/alloc/page_frame_alloc.h"
 #include "../../std/string.h"
+#include "../vfs/dcache.h"
+#include "../vfs/page_cache.h"
 
 static uint32_t cluster_to_sector(fat32_fs_t *fs, uint32_t cluster) {
     return fs->data_start_sector + ((cluster - 2) * fs->boot.sectors_per_cluster);
@@ -163,8 +166,7 @@ static int fat32_read_cluster(fat32_fs_t *fs, uint32_t cluster, void *buffer) {
     uint32_t sector = cluster_to_sector(fs, cluster);
     uint64_t offset = sector * fs->boot.bytes_per_sector;
 
-    vfs_seek(fs->device_fd, offset, SEEK_SET);
-    int64_t bytes = vfs_read(fs->device_fd, buffer, fs->bytes_per_cluster);
+    int64_t bytes = vfs_file_pread(fs->device, buffer, fs->bytes_per_cluster, offset);
 
     if (bytes != (int64_t)fs->bytes_per_cluster) {
         printkf_error("fat32_read_cluster(): Failed to read cluster %u\n", cluster);
@@ -183,8 +185,7 @@ static int fat32_write_cluster(fat32_fs_t *fs, uint32_t cluster, const void *buf
     uint32_t sector = cluster_to_sector(fs, cluster);
     uint64_t offset = sector * fs->boot.bytes_per_sector;
 
-    vfs_seek(fs->device_fd, offset, SEEK_SET);
-    int64_t bytes = vfs_write(fs->device_fd, buffer, fs->bytes_per_cluster);
+    int64_t bytes = vfs_file_pwrite(fs->device, buffer, fs->bytes_per_cluster, offset);
 
     if (bytes != (int64_t)fs->bytes_per_cluster) {
         printkf_error("fat32_write_cluster(): Failed to write cluster %u\n", cluster);
@@ -207,8 +208,7 @@ static int fat32_flush_fat(fat32_fs_t *fs) {
         uint32_t fat_sector = fs->fat_start_sector + (i * fs->boot.sectors_per_fat_32);
         uint64_t offset = fat_sector * fs->boot.bytes_per_sector;
 
-        vfs_seek(fs->device_fd, offset, SEEK_SET);
-        int64_t bytes = vfs_write(fs->device_fd, fs->fat_cache, fat_size_bytes);
+        int64_t bytes = vfs_file_pwrite(fs->device, fs->fat_cache, fat_size_bytes, offset);
 
         if (bytes != (int64_t)fat_size_bytes) {
             printkf_error("fat32_flush_fat(): Failed to write FAT %d\n", i);
@@ -665,8 +665,8 @@ int fat32_create_directory(fat32_fs_t *fs, uint32_t parent_cluster, const char *
 }
 
 fat32_fs_t *fat32_mount(const char *device_path) {
-    int fd = vfs_open(device_path, O_RDWR);
-    if (fd < 0) {
+    vfs_file_t *device = vfs_file_open(device_path, O_RDWR);
+    if (device == NULL) {
         printkf_error("fat32_mount(): Failed to open device %s\n", device_path);
         return NULL;
     }
@@ -675,26 +675,26 @@ fat32_fs_t *fat32_mount(const char *device_path) {
     memset(fs, 0, sizeof(fat32_fs_t));
 
     strncpy(fs->device_path, device_path, sizeof(fs->device_path) - 1);
-    fs->device_fd = fd;
+    fs->device = device;
+    mutex_init(&fs->lock);
 
-    vfs_seek(fd, 0, SEEK_SET);
-    if (vfs_read(fd, &fs->boot, sizeof(fat32_boot_sector_t)) != sizeof(fat32_boot_sector_t)) {
+    if (vfs_file_pread(device, &fs->boot, sizeof(fat32_boot_sector_t), 0) != sizeof(fat32_boot_sector_t)) {
         printkf_error("fat32_mount(): Failed to read boot sector\n");
-        vfs_close(fd);
+        vfs_file_put(device);
         free(fs);
         return NULL;
     }
 
     if (fs->boot.signature != 0xAA55) {
         printkf_error("fat32_mount(): Invalid boot signature: 0x%04x\n", fs->boot.signature);
-        vfs_close(fd);
+        vfs_file_put(device);
         free(fs);
         return NULL;
     }
 
     if (fs->boot.sectors_per_fat_16 != 0 || fs->boot.root_entries != 0) {
         printkf_error("fat32_mount(): Not a FAT32 filesystem (FAT12/16 detected)\n");
-        vfs_close(fd);
+        vfs_file_put(device);
         free(fs);
         return NULL;
     }
@@ -715,16 +715,16 @@ fat32_fs_t *fat32_mount(const char *device_path) {
     fs->fat_cache = (uint32_t *)malloc(fat_size_bytes);
     if (!fs->fat_cache) {
         printkf_error("fat32_mount(): Failed to allocate FAT cache\n");
-        vfs_close(fd);
+        vfs_file_put(device);
         free(fs);
         return NULL;
     }
 
-    vfs_seek(fd, fs->fat_start_sector * fs->boot.bytes_per_sector, SEEK_SET);
-    if (vfs_read(fd, fs->fat_cache, fat_size_bytes) != (int64_t)fat_size_bytes) {
+    uint64_t fat_offset = (uint64_t)fs->fat_start_sector * fs->boot.bytes_per_sector;
+    if (vfs_file_pread(device, fs->fat_cache, fat_size_bytes, fat_offset) != (int64_t)fat_size_bytes) {
         printkf_error("fat32_mount(): Failed to read FAT\n");
         free(fs->fat_cache);
-        vfs_close(fd);
+        vfs_file_put(device);
         free(fs);
         return NULL;
     }
@@ -744,8 +744,8 @@ void fat32_unmount(fat32_fs_t *fs) {
         free(fs->fat_cache);
     }
 
-    if (fs->device_fd >= 0) {
-        vfs_close(fs->device_fd);
+    if (fs->device != NULL) {
+        vfs_file_put(fs->device);
     }
 
     free(fs);
@@ -787,96 +787,369 @@ void fat32_list_root(fat32_fs_t *fs) {
 typedef struct {
     fat32_fs_t *fs;
     fat32_dir_entry_t entry;
+    uint32_t hint_index;
+    uint32_t hint_cluster;
 } fat32_node_data_t;
 
-static int64_t fat32_vfs_read(vfs_node_t *node, void *buf, size_t size, size_t offset) {
-    if (!node->data)
+static uint32_t fat32_entry_cluster(fat32_dir_entry_t *entry) {
+    return ((uint32_t)entry->cluster_high << 16) | entry->cluster_low;
+}
+
+static uint32_t fat32_cluster_at(fat32_fs_t *fs, uint32_t cluster, size_t index) {
+    while (index > 0 && cluster >= 2 && cluster < FAT32_EOC) {
+        cluster = fat32_get_next_cluster(fs, cluster);
+        index--;
+    }
+    return cluster;
+}
+
+static uint32_t fat32_file_cluster(fat32_node_data_t *node_data, uint32_t index, bool allocate) {
+    fat32_fs_t *fs = node_data->fs;
+
+    uint32_t cluster = fat32_entry_cluster(&node_data->entry);
+    if (cluster < 2) {
+        if (!allocate)
+            return 0;
+
+        cluster = fat32_allocate_cluster(fs, 0);
+        if (cluster == 0)
+            return 0;
+        node_data->entry.cluster_high = (cluster >> 16) & 0xFFFF;
+        node_data->entry.cluster_low = cluster & 0xFFFF;
+    }
+
+    uint32_t current = 0;
+    if (node_data->hint_cluster >= 2 && node_data->hint_index <= index) {
+        current = node_data->hint_index;
+        cluster = node_data->hint_cluster;
+    }
+
+    while (current < index) {
+        uint32_t next = fat32_get_next_cluster(fs, cluster);
+        if (next < 2 || next >= FAT32_EOC) {
+            if (!allocate)
+                return 0;
+            next = fat32_allocate_cluster(fs, cluster);
+            if (next == 0)
+                return 0;
+        }
+        cluster = next;
+        current++;
+    }
+
+    node_data->hint_index = index;
+    node_data->hint_cluster = cluster;
+    return cluster;
+}
+
+static uint64_t fat32_cluster_offset(fat32_fs_t *fs, uint32_t cluster) {
+    return (uint64_t)cluster_to_sector(fs, cluster) * fs->boot.bytes_per_sector;
+}
+
+static int fat32_vfs_readpage(vfs_node_t *node, uint64_t index, void *page) {
+    if (!node->inode->data)
         return -1;
 
-    fat32_node_data_t *node_data = (fat32_node_data_t *)node->data;
+    fat32_node_data_t *node_data = (fat32_node_data_t *)node->inode->data;
+    fat32_fs_t *fs = node_data->fs;
 
-    if (offset >= node_data->entry.file_size) {
-        return 0;
+    mutex_lock(&fs->lock);
+
+    uint64_t start = index * PAGE_SIZE;
+    size_t len = 0;
+    if (start < node_data->entry.file_size) {
+        len = node_data->entry.file_size - start;
+        if (len > PAGE_SIZE)
+            len = PAGE_SIZE;
     }
 
-    if (offset + size > node_data->entry.file_size) {
-        size = node_data->entry.file_size - offset;
+    size_t pos = 0;
+    while (pos < len) {
+        uint64_t offset = start + pos;
+        uint32_t cluster = fat32_file_cluster(node_data, offset / fs->bytes_per_cluster, false);
+        if (cluster < 2)
+            break;
+
+        size_t cluster_offset = offset % fs->bytes_per_cluster;
+        size_t chunk = fs->bytes_per_cluster - cluster_offset;
+        if (chunk > len - pos)
+            chunk = len - pos;
+
+        int64_t bytes = vfs_file_pread(fs->device, (uint8_t *)page + pos, chunk,
+                                       fat32_cluster_offset(fs, cluster) + cluster_offset);
+        if (bytes != (int64_t)chunk) {
+            printkf_error("fat32_vfs_readpage(): Failed to read cluster %u\n", cluster);
+            mutex_unlock(&fs->lock);
+            return -1;
+        }
+        pos += chunk;
     }
 
-    uint8_t *file_buffer = (uint8_t *)malloc(node_data->entry.file_size);
-    if (!file_buffer)
+    mutex_unlock(&fs->lock);
+
+    memset((uint8_t *)page + pos, 0, PAGE_SIZE - pos);
+    return 0;
+}
+
+static int fat32_zero_range(fat32_node_data_t *node_data, uint64_t from, uint64_t to) {
+    fat32_fs_t *fs = node_data->fs;
+
+    uint8_t *zeroes = (uint8_t *)malloc(fs->bytes_per_cluster);
+    if (zeroes == NULL) {
+        printkf_error("fat32_zero_range(): out of memory\n");
         return -1;
+    }
+    memset(zeroes, 0, fs->bytes_per_cluster);
+
+    int ret = 0;
+    while (from < to) {
+        uint32_t cluster = fat32_file_cluster(node_data, from / fs->bytes_per_cluster, true);
+        if (cluster < 2) {
+            ret = -1;
+            break;
+        }
+
+        size_t cluster_offset = from % fs->bytes_per_cluster;
+        size_t chunk = fs->bytes_per_cluster - cluster_offset;
+        if (chunk > to - from)
+            chunk = to - from;
+
+        int64_t bytes = vfs_file_pwrite(fs->device, zeroes, chunk, fat32_cluster_offset(fs, cluster) + cluster_offset);
+        if (bytes != (int64_t)chunk) {
+            printkf_error("fat32_zero_range(): Failed to write cluster %u\n", cluster);
+            ret = -1;
+            break;
+        }
+        from += chunk;
+    }
 
-    int bytes_read = fat32_read_file(node_data->fs, &node_data->entry, file_buffer, node_data->entry.file_size);
-    if (bytes_read < 0) {
-        free(file_buffer);
+    free(zeroes);
+    return ret;
+}
+
+static int fat32_vfs_writepage(vfs_node_t *node, uint64_t index, const void *page, size_t len) {
+    if (!node->inode->data)
         return -1;
+
+    fat32_node_data_t *node_data = (fat32_node_data_t *)node->inode->data;
+    fat32_fs_t *fs = node_data->fs;
+
+    mutex_lock(&fs->lock);
+
+    uint64_t start = index * PAGE_SIZE;
+    if (start > node_data->entry.file_size && fat32_zero_range(node_data, node_data->entry.file_size, start) < 0) {
+        mutex_unlock(&fs->lock);
+        return -1;
+    }
+
+    size_t pos = 0;
+    while (pos < len) {
+        uint64_t offset = start + pos;
+        uint32_t cluster = fat32_file_cluster(node_data, offset / fs->bytes_per_cluster, true);
+        if (cluster < 2) {
+            mutex_unlock(&fs->lock);
+            return -1;
+        }
+
+        size_t cluster_offset = offset % fs->bytes_per_cluster;
+        size_t chunk = fs->bytes_per_cluster - cluster_offset;
+        if (chunk > len - pos)
+            chunk = len - pos;
+
+        int64_t bytes = vfs_file_pwrite(fs->device, (const uint8_t *)page + pos, chunk,
+                                        fat32_cluster_offset(fs, cluster) + cluster_offset);
+        if (bytes != (int64_t)chunk) {
+            printkf_error("fat32_vfs_writepage(): Failed to write cluster %u\n", cluster);
+            mutex_unlock(&fs->lock);
+            return -1;
+        }
+        pos += chunk;
     }
 
-    memcpy(buf, file_buffer + offset, size);
-    free(file_buffer);
+    if (start + len > node_data->entry.file_size)
+        node_data->entry.file_size = start + len;
 
-    return size;
+    mutex_unlock(&fs->lock);
+    return 0;
 }
 
-static int64_t fat32_vfs_write(vfs_node_t *node, const void *buf, size_t size, size_t offset) {
-    if (!node->data)
+static int fat32_vfs_sync(vfs_node_t *node) {
+    if (!node->inode->data)
         return -1;
 
-    fat32_node_data_t *node_data = (fat32_node_data_t *)node->data;
+    fat32_fs_t *fs = ((fat32_node_data_t *)node->inode->data)->fs;
 
-    bool append = (offset == node_data->entry.file_size);
+    mutex_lock(&fs->lock);
+    int ret = fat32_flush_fat(fs);
+    mutex_unlock(&fs->lock);
+    return ret;
+}
 
-    int bytes_written = fat32_write_file(node_data->fs, &node_data->entry, buf, size, append);
-    if (bytes_written < 0) {
+static int fat32_vfs_truncate(vfs_node_t *node, size_t size) {
+    if (!node->inode->data || node->type != VFS_FILE)
         return -1;
+
+    fat32_node_data_t *node_data = (fat32_node_data_t *)node->inode->data;
+    fat32_fs_t *fs = node_data->fs;
+
+    mutex_lock(&fs->lock);
+
+    if (size < node_data->entry.file_size) {
+        uint32_t keep = (size + fs->bytes_per_cluster - 1) / fs->bytes_per_cluster;
+        uint32_t cluster;
+
+        if (keep == 0) {
+            cluster = fat32_entry_cluster(&node_data->entry);
+            node_data->entry.cluster_high = 0;
+            node_data->entry.cluster_low = 0;
+        } else {
+            uint32_t last = fat32_file_cluster(node_data, keep - 1, false);
+            cluster = last >= 2 ? fat32_get_next_cluster(fs, last) : 0;
+            if (last >= 2)
+                fat32_set_fat_entry(fs, last, FAT32_EOC);
+        }
+
+        while (cluster >= 2 && cluster < FAT32_EOC) {
+            uint32_t next = fat32_get_next_cluster(fs, cluster);
+            fat32_set_fat_entry(fs, cluster, FAT32_FREE_CLUSTER);
+            cluster = next;
+        }
+    } else if (size > node_data->entry.file_size) {
+        uint64_t from = node_data->entry.file_size;
+        uint64_t to = (from + fs->bytes_per_cluster - 1) / fs->bytes_per_cluster * fs->bytes_per_cluster;
+        if (to > size)
+            to = size;
+        if (from < to && fat32_zero_range(node_data, from, to) < 0) {
+            mutex_unlock(&fs->lock);
+            return -1;
+        }
     }
 
-    node->size = node_data->entry.file_size;
+    node_data->hint_index = 0;
+    node_data->hint_cluster = 0;
+    node_data->entry.file_size = size;
+    node->inode->size = size;
 
-    fat32_flush_fat(node_data->fs);
+    int ret = fat32_flush_fat(fs);
+    mutex_unlock(&fs->lock);
+    return ret;
+}
 
-    return bytes_written;
+static int64_t fat32_vfs_copy_range(vfs_node_t *src, size_t src_offset, vfs_node_t *dst, size_t dst_offset,
+                                    size_t size) {
+    if (!src->inode->data || !dst->inode->data)
+        return -1;
+
+    fat32_node_data_t *src_data = (fat32_node_data_t *)src->inode->data;
+    fat32_node_data_t *dst_data = (fat32_node_data_t *)dst->inode->data;
+    fat32_fs_t *fs = src_data->fs;
+    size_t cluster_size = fs->bytes_per_cluster;
+
+    if (dst_data->fs != fs || src_offset % cluster_size != 0)
+        return 0;
+
+    mutex_lock(&fs->lock);
+
+    uint8_t *cluster_buffer = NULL;
+    if (dst_offset == dst_data->entry.file_size && dst_offset % cluster_size == 0 &&
+        src_offset < src_data->entry.file_size)
+        cluster_buffer = (uint8_t *)malloc(cluster_size);
+    if (!cluster_buffer) {
+        mutex_unlock(&fs->lock);
+        return 0;
+    }
+
+    if (size > src_data->entry.file_size - src_offset)
+        size = src_data->entry.file_size - src_offset;
+
+    uint32_t src_cluster = fat32_cluster_at(fs, fat32_entry_cluster(&src_data->entry), src_offset / cluster_size);
+    uint32_t dst_first = fat32_entry_cluster(&dst_data->entry);
+    uint32_t dst_prev = 0;
+    if (dst_offset > 0)
+        dst_prev = fat32_cluster_at(fs, dst_first, dst_offset / cluster_size - 1);
+
+    size_t copied = 0;
+    while (copied < size && src_cluster >= 2 && src_cluster < FAT32_EOC) {
+        uint32_t dst_cluster = dst_prev >= 2 ? fat32_get_next_cluster(fs, dst_prev) : dst_first;
+        if (dst_cluster < 2 || dst_cluster >= FAT32_EOC) {
+            dst_cluster = fat32_allocate_cluster(fs, dst_prev);
+            if (dst_cluster == 0)
+                break;
+            if (dst_prev < 2) {
+                dst_data->entry.cluster_high = (dst_cluster >> 16) & 0xFFFF;
+                dst_data->entry.cluster_low = dst_cluster & 0xFFFF;
+                dst_first = dst_cluster;
+            }
+        }
+
+        if (fat32_read_cluster(fs, src_cluster, cluster_buffer) < 0)
+            break;
+
+        size_t chunk = cluster_size;
+        if (chunk > size - copied) {
+            chunk = size - copied;
+            memset(cluster_buffer + chunk, 0, cluster_size - chunk);
+        }
+
+        if (fat32_write_cluster(fs, dst_cluster, cluster_buffer) < 0)
+            break;
+
+        copied += chunk;
+        dst_prev = dst_cluster;
+        src_cluster = fat32_get_next_cluster(fs, src_cluster);
+    }
+
+    free(cluster_buffer);
+
+    dst_data->entry.file_size += copied;
+    dst->inode->size = dst_data->entry.file_size;
+
+    fat32_flush_fat(fs);
+    mutex_unlock(&fs->lock);
+
+    return copied;
 }
 
 static vfs_node_t *fat32_vfs_create(vfs_node_t *parent, const char *name, vfs_node_type_t type) {
-    if (!parent->data)
+    if (!parent->inode->data)
         return NULL;
 
-    fat32_node_data_t *parent_data = (fat32_node_data_t *)parent->data;
+    fat32_node_data_t *parent_data = (fat32_node_data_t *)parent->inode->data;
     fat32_fs_t *fs = parent_data->fs;
 
     uint32_t parent_cluster = ((uint32_t)parent_data->entry.cluster_high << 16) | parent_data->entry.cluster_low;
 
+    if (type != VFS_FILE && type != VFS_DIRECTORY) {
+        return NULL;
+    }
+
+    mutex_lock(&fs->lock);
+
+    int created;
     if (type == VFS_FILE) {
-        if (fat32_create_file(fs, parent_cluster, name) < 0) {
-            return NULL;
-        }
-    } else if (type == VFS_DIRECTORY) {
-        if (fat32_create_directory(fs, parent_cluster, name) < 0) {
-            return NULL;
-        }
+        created = fat32_create_file(fs, parent_cluster, name);
     } else {
-        return NULL;
+        created = fat32_create_directory(fs, parent_cluster, name);
     }
 
-    fat32_dir_entry_t *new_entry = fat32_find_file(fs, parent_cluster, name);
+    fat32_dir_entry_t *new_entry = created < 0 ? NULL : fat32_find_file(fs, parent_cluster, name);
+    mutex_unlock(&fs->lock);
     if (!new_entry) {
         return NULL;
     }
 
-    vfs_node_t *node = (vfs_node_t *)malloc(sizeof(vfs_node_t));
-    memset(node, 0, sizeof(vfs_node_t));
-
-    strncpy(node->name, name, VFS_MAX_NAME - 1);
-    node->type = type;
-    node->size = new_entry->file_size;
-    node->ops = parent->ops;
+    vfs_node_t *node = vfs_node_alloc(name, type, parent->ops);
+    if (!node) {
+        free(new_entry);
+        return NULL;
+    }
+    node->inode->size = new_entry->file_size;
 
     fat32_node_data_t *node_data = (fat32_node_data_t *)malloc(sizeof(fat32_node_data_t));
+    memset(node_data, 0, sizeof(fat32_node_data_t));
     node_data->fs = fs;
     memcpy(&node_data->entry, new_entry, sizeof(fat32_dir_entry_t));
-    node->data = node_data;
+    node->inode->data = node_data;
 
     node->parent = parent;
     node->next = parent->children;
@@ -888,11 +1161,13 @@ static vfs_node_t *fat32_vfs_create(vfs_node_t *parent, const char *name, vfs_no
 }
 
 static vfs_ops_t fat32_vfs_ops = {
-    .read = fat32_vfs_read,
-    .write = fat32_vfs_write,
     .create = fat32_vfs_create,
     .unlink = NULL,
-    .truncate = NULL,
+    .truncate = fat32_vfs_truncate,
+    .copy_range = fat32_vfs_copy_range,
+    .readpage = fat32_vfs_readpage,
+    .writepage = fat32_vfs_writepage,
+    .sync = fat32_vfs_sync,
 };
 
 static void fat32_populate_vfs_dir(fat32_fs_t *fs, vfs_node_t *vfs_dir, uint32_t cluster) {
@@ -912,18 +1187,17 @@ static void fat32_populate_vfs_dir(fat32_fs_t *fs, vfs_node_t *vfs_dir, uint32_t
             continue;
         }
 
-        vfs_node_t *node = (vfs_node_t *)malloc(sizeof(vfs_node_t));
-        memset(node, 0, sizeof(vfs_node_t));
-
-        strncpy(node->name, filename, VFS_MAX_NAME - 1);
-        node->type = (entry->attributes & FAT32_ATTR_DIRECTORY) ? VFS_DIRECTORY : VFS_FILE;
-        node->size = entry->file_size;
-        node->ops = &fat32_vfs_ops;
+        vfs_node_type_t type = (entry->attributes & FAT32_ATTR_DIRECTORY) ? VFS_DIRECTORY : VFS_FILE;
+        vfs_node_t *node = vfs_node_alloc(filename, type, &fat32_vfs_ops);
+        if (!node)
+            continue;
+        node->inode->size = entry->file_size;
 
         fat32_node_data_t *node_data = (fat32_node_data_t *)malloc(sizeof(fat32_node_data_t));
+        memset(node_data, 0, sizeof(fat32_node_data_t));
         node_data->fs = fs;
         memcpy(&node_data->entry, entry, sizeof(fat32_dir_entry_t));
-        node->data = node_data;
+        node->inode->data = node_data;
 
         node->parent = vfs_dir;
         node->next = vfs_dir->children;
@@ -949,17 +1223,19 @@ int fat32_mount_vfs(const char *device_path, const char *mountpoint, void **fs_d
         return -1;
     }
 
-    vfs_node_t *mount_node = vfs_lookup(mountpoint);
-    if (!mount_node) {
-        mount_node = vfs_create(mountpoint, VFS_DIRECTORY);
-        if (!mount_node) {
-            printkf_error("fat32_mount_vfs(): Failed to create mountpoint\n");
-            fat32_unmount(fs);
-            return -1;
-        }
+    if (!vfs_lookup(mountpoint) && !vfs_create(mountpoint, VFS_DIRECTORY)) {
+        printkf_error("fat32_mount_vfs(): Failed to create mountpoint\n");
+        fat32_unmount(fs);
+        return -1;
     }
 
-    fat32_populate_vfs_dir(fs, mount_node, fs->boot.root_cluster);
+    vfs_lock_tree();
+    vfs_node_t *mount_node = vfs_lookup_locked(mountpoint);
+    if (mount_node && mount_node->type == VFS_DIRECTORY) {
+        fat32_populate_vfs_dir(fs, mount_node, fs->boot.root_cluster);
+    }
+    dcache_flush();
+    vfs_unlock_tree();
 
     *fs_data_out = fs;
 
@@ -977,12 +1253,14 @@ static void fat32_free_vfs_node(vfs_node_t *node) {
         child = next;
     }
 
-    if (node->data) {
-        free(node->data);
-        node->data = NULL;
+    page_cache_sync(node);
+
+    if (node->inode->data) {
+        free(node->inode->data);
+        node->inode->data = NULL;
     }
 
-    free(node);
+    vfs_node_free(node);
 }
 
 void fat32_unmount_vfs(void *fs_data, const char *mountpoint) {
@@ -991,7 +1269,8 @@ void fat32_unmount_vfs(void *fs_data, const char *mountpoint) {
 
     fat32_fs_t *fs = (fat32_fs_t *)fs_data;
 
-    vfs_node_t *mount_node = vfs_lookup(mountpoint);
+    vfs_lock_tree();
+    vfs_node_t *mount_node = vfs_lookup_locked(mountpoint);
     if (mount_node) {
         vfs_node_t *child = mount_node->children;
         while (child) {
@@ -1001,6 +1280,8 @@ void fat32_unmount_vfs(void *fs_data, const char *mountpoint) {
         }
         mount_node->children = NULL;
     }
+    dcache_flush();
+    vfs_unlock_tree();
 
     fat32_unmount(fs);
 }
\ No newline at end of file
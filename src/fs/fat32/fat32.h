@@ -3,6 +3,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "../../sync/mutex.h"
 #include "../vfs/vfs.h"
 
 #define FAT32_ATTR_READ_ONLY 0x01
@@ -78,7 +79,7 @@ typedef struct {
 
 typedef struct {
     char device_path[256];
-    int device_fd;
+    vfs_file_t *device;
 
     fat32_boot_sector_t boot;
 
@@ -89,6 +90,8 @@ typedef struct {
 
     uint32_t *fat_cache;
     bool fat_cache_dirty;
+
+    mutex_t lock;
 } fat32_fs_t;
 
 fat32_fs_t *fat32_mount(const char *device_path);
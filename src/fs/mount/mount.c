@@ -4,6 +4,8 @@
 #include "../../mem/alloc/heap.h"
 #include "../../std/string.h"
 #include "../fat32/fat32.h"
+#include "../vfs/dcache.h"
+#include "../vfs/page_cache.h"
 #include "../vfs/vfs.h"
 
 static mount_point_t *mount_list_head = NULL;
@@ -76,6 +78,8 @@ int mount(const char *device, const char *mountpoint, const char *fs_type) {
     mp->next = mount_list_head;
     mount_list_head = mp;
 
+    dcache_flush();
+
     return 0;
 }
 
@@ -86,12 +90,16 @@ int unmount(const char *mountpoint) {
         if (strcmp((*current)->mountpoint, mountpoint) == 0) {
             mount_point_t *mp = *current;
 
+            page_cache_drain();
+
             if (mp->fs_type == FS_TYPE_FAT32 && mp->fs_data) {
                 fat32_unmount_vfs(mp->fs_data, mountpoint);
             }
 
             *current = mp->next;
             free(mp);
+
+            dcache_flush();
             return 0;
         }
         current = &(*current)->next;
@@ -53,6 +53,7 @@ static const uint8_t BASIC_DATA_GUID[16] = {0xA2, 0xA0, 0xD0, 0xEB, 0xE5, 0xB9,
 
 typedef struct {
     char base_device[256];
+    vfs_file_t *base;
     uint64_t offset;
     uint64_t size;
 } partition_data_t;
@@ -111,10 +112,9 @@ static const char *gpt_type_name(const uint8_t *type_guid) {
     return "Unknown";
 }
 
-static partition_table_t *partition_parse_gpt(int fd, const char *device_path) {
+static partition_table_t *partition_parse_gpt(vfs_file_t *device, const char *device_path) {
     gpt_header_t gpt;
-    vfs_seek(fd, 512, SEEK_SET);
-    if (vfs_read(fd, &gpt, sizeof(gpt_header_t)) != sizeof(gpt_header_t)) {
+    if (vfs_file_pread(device, &gpt, sizeof(gpt_header_t), 512) != sizeof(gpt_header_t)) {
         printkf_error("partition_parse_gpt(): Failed to read GPT header\n");
         return NULL;
     }
@@ -140,8 +140,8 @@ static partition_table_t *partition_parse_gpt(int fd, const char *device_path) {
     gpt_entry_t *entry = (gpt_entry_t *)malloc(sizeof(gpt_entry_t));
 
     for (uint32_t i = 0; i < entries_to_read && table->num_partitions < MAX_PARTITIONS; i++) {
-        vfs_seek(fd, entries_offset + (i * gpt.partition_entry_size), SEEK_SET);
-        if (vfs_read(fd, entry, sizeof(gpt_entry_t)) != sizeof(gpt_entry_t)) {
+        uint64_t entry_offset = entries_offset + (i * gpt.partition_entry_size);
+        if (vfs_file_pread(device, entry, sizeof(gpt_entry_t), entry_offset) != sizeof(gpt_entry_t)) {
             continue;
         }
 
@@ -177,39 +177,39 @@ static partition_table_t *partition_parse_gpt(int fd, const char *device_path) {
 }
 
 partition_table_t *partition_parse_mbr(const char *device_path) {
-    int fd = vfs_open(device_path, O_RDONLY);
-    if (fd < 0) {
+    vfs_file_t *device = vfs_file_open(device_path, O_RDONLY);
+    if (device == NULL) {
         printkf_error("partition_parse_mbr(): Failed to open device\n");
         return NULL;
     }
 
     mbr_t *mbr = (mbr_t *)malloc(sizeof(mbr_t));
-    int64_t bytes = vfs_read(fd, mbr, 512);
+    int64_t bytes = vfs_file_pread(device, mbr, 512, 0);
 
     if (bytes != 512) {
         printkf_error("partition_parse_mbr(): Failed to read MBR (got %lld bytes)\n", bytes);
         free(mbr);
-        vfs_close(fd);
+        vfs_file_put(device);
         return NULL;
     }
 
     if (mbr->signature != 0xAA55) {
         printkf_error("partition_parse_mbr(): Invalid MBR signature: 0x%04x (expected 0xAA55)\n", mbr->signature);
         free(mbr);
-        vfs_close(fd);
+        vfs_file_put(device);
         return NULL;
     }
 
     for (int i = 0; i < 4; i++) {
         if (mbr->partitions[i].type == 0xEE) {
             free(mbr);
-            partition_table_t *table = partition_parse_gpt(fd, device_path);
-            vfs_close(fd);
+            partition_table_t *table = partition_parse_gpt(device, device_path);
+            vfs_file_put(device);
             return table;
         }
     }
 
-    vfs_close(fd);
+    vfs_file_put(device);
 
     partition_table_t *table = (partition_table_t *)malloc(sizeof(partition_table_t));
     memset(table, 0, sizeof(partition_table_t));
@@ -273,7 +273,7 @@ partition_info_t *partition_get(partition_table_t *table, int index) {
 }
 
 static int64_t partition_dev_read(vfs_node_t *node, void *buf, size_t size, size_t offset) {
-    partition_data_t *pdata = (partition_data_t *)node->data;
+    partition_data_t *pdata = (partition_data_t *)node->inode->data;
 
     if (offset >= pdata->size) {
         return 0;
@@ -283,19 +283,11 @@ static int64_t partition_dev_read(vfs_node_t *node, void *buf, size_t size, size
         size = pdata->size - offset;
     }
 
-    int fd = vfs_open(pdata->base_device, O_RDONLY);
-    if (fd < 0)
-        return -1;
-
-    vfs_seek(fd, pdata->offset + offset, SEEK_SET);
-    int64_t bytes = vfs_read(fd, buf, size);
-    vfs_close(fd);
-
-    return bytes;
+    return vfs_file_pread(pdata->base, buf, size, pdata->offset + offset);
 }
 
 static int64_t partition_dev_write(vfs_node_t *node, const void *buf, size_t size, size_t offset) {
-    partition_data_t *pdata = (partition_data_t *)node->data;
+    partition_data_t *pdata = (partition_data_t *)node->inode->data;
 
     if (offset >= pdata->size) {
         return 0;
@@ -305,15 +297,7 @@ static int64_t partition_dev_write(vfs_node_t *node, const void *buf, size_t siz
         size = pdata->size - offset;
     }
 
-    int fd = vfs_open(pdata->base_device, O_WRONLY);
-    if (fd < 0)
-        return -1;
-
-    vfs_seek(fd, pdata->offset + offset, SEEK_SET);
-    int64_t bytes = vfs_write(fd, buf, size);
-    vfs_close(fd);
-
-    return bytes;
+    return vfs_file_pwrite(pdata->base, buf, size, pdata->offset + offset);
 }
 
 static vfs_ops_t partition_dev_ops = {
@@ -328,6 +312,12 @@ void partition_register(partition_table_t *table) {
     if (!table)
         return;
 
+    vfs_file_t *base = vfs_file_open(table->device_path, O_RDWR);
+    if (base == NULL) {
+        printkf_error("partition_register(): Failed to open %s\n", table->device_path);
+        return;
+    }
+
     for (int i = 0; i < table->num_partitions; i++) {
         partition_info_t *part = &table->partitions[i];
 
@@ -341,12 +331,17 @@ void partition_register(partition_table_t *table) {
         }
 
         partition_data_t *pdata = (partition_data_t *)malloc(sizeof(partition_data_t));
+        memset(pdata, 0, sizeof(partition_data_t));
         strncpy(pdata->base_device, table->device_path, sizeof(pdata->base_device) - 1);
+        pdata->base = base;
+        vfs_file_get(base);
         pdata->offset = part->lba_start * 512;
         pdata->size = part->num_sectors * 512;
 
         part_node->ops = &partition_dev_ops;
-        part_node->size = pdata->size;
-        part_node->data = pdata;
+        part_node->inode->size = pdata->size;
+        part_node->inode->data = pdata;
     }
+
+    vfs_file_put(base);
 }
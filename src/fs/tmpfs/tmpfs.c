@@ -3,14 +3,21 @@
 #include "../../io/terminal.h"
 #include "../../mem/alloc/heap.h"
 #include "../../std/string.h"
+#include "../../sync/mutex.h"
+#include "../../sync/spinlock.h"
 
 typedef struct {
+    mutex_t lock;
     void *data;
     size_t capacity;
 } tmpfs_file_t;
 
+static spinlock_t tmpfs_alloc_lock = {0};
+
 static int64_t tmpfs_read(vfs_node_t *node, void *buf, size_t size, size_t offset);
 static int64_t tmpfs_write(vfs_node_t *node, const void *buf, size_t size, size_t offset);
+static int64_t tmpfs_readv(vfs_node_t *node, const vfs_iovec_t *iov, int iovcnt, size_t offset);
+static int64_t tmpfs_writev(vfs_node_t *node, const vfs_iovec_t *iov, int iovcnt, size_t offset);
 static vfs_node_t *tmpfs_create(vfs_node_t *parent, const char *name, vfs_node_type_t type);
 static int tmpfs_delete(vfs_node_t *node);
 static int tmpfs_truncate(vfs_node_t *node, size_t size);
@@ -18,6 +25,8 @@ static int tmpfs_truncate(vfs_node_t *node, size_t size);
 static vfs_ops_t tmpfs_ops = {
     .read = tmpfs_read,
     .write = tmpfs_write,
+    .readv = tmpfs_readv,
+    .writev = tmpfs_writev,
     .create = tmpfs_create,
     .unlink = tmpfs_delete,
     .truncate = tmpfs_truncate,
@@ -29,77 +38,168 @@ void tmpfs_init() {
     printkf_ok("tmpfs mounted at /\n");
 }
 
+static tmpfs_file_t *tmpfs_file_get(vfs_node_t *node, bool create) {
+    tmpfs_file_t *file = (tmpfs_file_t *)__atomic_load_n(&node->inode->data, __ATOMIC_ACQUIRE);
+    if (file != NULL || !create)
+        return file;
+
+    tmpfs_file_t *new_file = (tmpfs_file_t *)malloc(sizeof(tmpfs_file_t));
+    if (new_file == NULL)
+        return NULL;
+    memset(new_file, 0, sizeof(tmpfs_file_t));
+    mutex_init(&new_file->lock);
+
+    uint64_t flags = spin_lock(&tmpfs_alloc_lock);
+    file = (tmpfs_file_t *)node->inode->data;
+    if (file == NULL) {
+        file = new_file;
+        __atomic_store_n(&node->inode->data, file, __ATOMIC_RELEASE);
+        new_file = NULL;
+    }
+    spin_unlock(&tmpfs_alloc_lock, flags);
+
+    if (new_file != NULL)
+        free(new_file);
+    return file;
+}
+
 static int64_t tmpfs_read(vfs_node_t *node, void *buf, size_t size, size_t offset) {
     if (node->type != VFS_FILE)
         return -1;
 
-    tmpfs_file_t *file = (tmpfs_file_t *)node->data;
-    if (file == NULL || file->data == NULL)
+    tmpfs_file_t *file = tmpfs_file_get(node, false);
+    if (file == NULL)
         return 0;
 
-    if (offset >= node->size)
+    mutex_lock(&file->lock);
+
+    if (file->data == NULL || offset >= node->inode->size) {
+        mutex_unlock(&file->lock);
         return 0;
-    if (offset + size > node->size) {
-        size = node->size - offset;
+    }
+    if (offset + size > node->inode->size) {
+        size = node->inode->size - offset;
     }
 
     memcpy(buf, (uint8_t *)file->data + offset, size);
+
+    mutex_unlock(&file->lock);
     return size;
 }
 
-static int64_t tmpfs_write(vfs_node_t *node, const void *buf, size_t size, size_t offset) {
+static int64_t tmpfs_readv(vfs_node_t *node, const vfs_iovec_t *iov, int iovcnt, size_t offset) {
     if (node->type != VFS_FILE)
         return -1;
 
-    tmpfs_file_t *file = (tmpfs_file_t *)node->data;
+    tmpfs_file_t *file = tmpfs_file_get(node, false);
+    if (file == NULL)
+        return 0;
 
-    if (file == NULL) {
-        file = (tmpfs_file_t *)malloc(sizeof(tmpfs_file_t));
-        file->data = NULL;
-        file->capacity = 0;
-        node->data = file;
+    mutex_lock(&file->lock);
+
+    size_t total = 0;
+    for (int i = 0; file->data != NULL && i < iovcnt && offset < node->inode->size; i++) {
+        size_t size = iov[i].len;
+        if (size > node->inode->size - offset)
+            size = node->inode->size - offset;
+
+        memcpy(iov[i].base, (uint8_t *)file->data + offset, size);
+        offset += size;
+        total += size;
     }
 
-    size_t required = offset + size;
+    mutex_unlock(&file->lock);
+    return total;
+}
 
-    if (required > file->capacity) {
-        size_t new_capacity = (required + 4095) & ~4095;
-        void *new_data = malloc(new_capacity);
+static int tmpfs_reserve(vfs_node_t *node, tmpfs_file_t *file, size_t required) {
+    if (required <= file->capacity)
+        return 0;
 
-        if (new_data == NULL)
-            return -1;
+    size_t new_capacity = (required + 4095) & ~4095;
+    void *new_data = malloc(new_capacity);
 
-        if (file->data != NULL) {
-            memcpy(new_data, file->data, node->size);
-            free(file->data);
-        }
+    if (new_data == NULL)
+        return -1;
 
-        if (new_capacity > node->size) {
-            memset((uint8_t *)new_data + node->size, 0, new_capacity - node->size);
-        }
+    if (file->data != NULL) {
+        memcpy(new_data, file->data, node->inode->size);
+        free(file->data);
+    }
 
-        file->data = new_data;
-        file->capacity = new_capacity;
+    if (new_capacity > node->inode->size) {
+        memset((uint8_t *)new_data + node->inode->size, 0, new_capacity - node->inode->size);
+    }
+
+    file->data = new_data;
+    file->capacity = new_capacity;
+    return 0;
+}
+
+static int64_t tmpfs_write(vfs_node_t *node, const void *buf, size_t size, size_t offset) {
+    if (node->type != VFS_FILE)
+        return -1;
+
+    tmpfs_file_t *file = tmpfs_file_get(node, true);
+    if (file == NULL)
+        return -1;
+
+    mutex_lock(&file->lock);
+
+    if (tmpfs_reserve(node, file, offset + size) < 0) {
+        mutex_unlock(&file->lock);
+        return -1;
     }
 
     memcpy((uint8_t *)file->data + offset, buf, size);
 
-    if (offset + size > node->size) {
-        node->size = offset + size;
+    if (offset + size > node->inode->size) {
+        node->inode->size = offset + size;
     }
 
+    mutex_unlock(&file->lock);
     return size;
 }
 
+static int64_t tmpfs_writev(vfs_node_t *node, const vfs_iovec_t *iov, int iovcnt, size_t offset) {
+    if (node->type != VFS_FILE)
+        return -1;
+
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        total += iov[i].len;
+    }
+
+    tmpfs_file_t *file = tmpfs_file_get(node, true);
+    if (file == NULL)
+        return -1;
+
+    mutex_lock(&file->lock);
+
+    if (tmpfs_reserve(node, file, offset + total) < 0) {
+        mutex_unlock(&file->lock);
+        return -1;
+    }
+
+    size_t pos = offset;
+    for (int i = 0; i < iovcnt; i++) {
+        memcpy((uint8_t *)file->data + pos, iov[i].base, iov[i].len);
+        pos += iov[i].len;
+    }
+
+    if (pos > node->inode->size) {
+        node->inode->size = pos;
+    }
+
+    mutex_unlock(&file->lock);
+    return total;
+}
+
 static vfs_node_t *tmpfs_create(vfs_node_t *parent, const char *name, vfs_node_type_t type) {
-    vfs_node_t *node = (vfs_node_t *)malloc(sizeof(vfs_node_t));
+    vfs_node_t *node = vfs_node_alloc(name, type, &tmpfs_ops);
     if (node == NULL)
         return NULL;
 
-    memset(node, 0, sizeof(vfs_node_t));
-    strcpy(node->name, name);
-    node->type = type;
-    node->ops = &tmpfs_ops;
     node->parent = parent;
 
     node->next = parent->children;
@@ -109,12 +209,13 @@ static vfs_node_t *tmpfs_create(vfs_node_t *parent, const char *name, vfs_node_t
 }
 
 static int tmpfs_delete(vfs_node_t *node) {
-    if (node->type == VFS_FILE && node->data != NULL) {
-        tmpfs_file_t *file = (tmpfs_file_t *)node->data;
+    if (node->type == VFS_FILE && node->inode->data != NULL) {
+        tmpfs_file_t *file = (tmpfs_file_t *)node->inode->data;
         if (file->data != NULL) {
             free(file->data);
         }
         free(file);
+        node->inode->data = NULL;
     }
     return 0;
 }
@@ -123,45 +224,31 @@ static int tmpfs_truncate(vfs_node_t *node, size_t size) {
     if (node->type != VFS_FILE)
         return -1;
 
-    tmpfs_file_t *file = (tmpfs_file_t *)node->data;
+    tmpfs_file_t *file = tmpfs_file_get(node, size > 0);
+    if (file == NULL) {
+        node->inode->size = 0;
+        return size == 0 ? 0 : -1;
+    }
+
+    mutex_lock(&file->lock);
 
+    int ret = 0;
     if (size == 0) {
-        if (file != NULL) {
-            if (file->data != NULL) {
-                free(file->data);
-                file->data = NULL;
-            }
-            file->capacity = 0;
-        }
-        node->size = 0;
-    } else if (size < node->size) {
-        node->size = size;
-    } else if (size > node->size) {
-        if (file == NULL) {
-            file = (tmpfs_file_t *)malloc(sizeof(tmpfs_file_t));
+        if (file->data != NULL) {
+            free(file->data);
             file->data = NULL;
-            file->capacity = 0;
-            node->data = file;
-        }
-
-        if (size > file->capacity) {
-            size_t new_capacity = (size + 4095) & ~4095;
-            void *new_data = malloc(new_capacity);
-            if (new_data == NULL)
-                return -1;
-
-            if (file->data != NULL) {
-                memcpy(new_data, file->data, node->size);
-                free(file->data);
-            }
-
-            memset((uint8_t *)new_data + node->size, 0, new_capacity - node->size);
-            file->data = new_data;
-            file->capacity = new_capacity;
         }
-
-        node->size = size;
+        file->capacity = 0;
+        node->inode->size = 0;
+    } else if (size < node->inode->size) {
+        node->inode->size = size;
+    } else if (size > node->inode->size) {
+        if (tmpfs_reserve(node, file, size) < 0)
+            ret = -1;
+        else
+            node->inode->size = size;
     }
 
-    return 0;
+    mutex_unlock(&file->lock);
+    return ret;
 }
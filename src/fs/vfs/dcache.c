@@ -0,0 +1,202 @@
+#include "dcache.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../../mem/alloc/heap.h"
+#include "../../std/string.h"
+#include "../../sync/spinlock.h"
+
+typedef struct dentry {
+    vfs_node_t *parent;
+    vfs_node_t *node;
+    uint32_t hash;
+    struct dentry *hash_next;
+    struct dentry *lru_prev;
+    struct dentry *lru_next;
+    char name[DCACHE_NAME_MAX];
+} dentry_t;
+
+static dentry_t *dcache_table[DCACHE_BUCKETS];
+static dentry_t *lru_head = NULL;
+static dentry_t *lru_tail = NULL;
+static uint32_t dcache_count = 0;
+
+static spinlock_t dcache_lock = {0};
+
+static uint32_t dcache_hash(vfs_node_t *dir, const char *name) {
+    uint32_t hash = 2166136261u;
+    for (const char *p = name; *p; p++) {
+        hash ^= (uint8_t)*p;
+        hash *= 16777619u;
+    }
+
+    uint64_t key = (uint64_t)dir;
+    hash ^= (uint32_t)(key >> 4) ^ (uint32_t)(key >> 36);
+    return hash * 2654435761u;
+}
+
+static inline uint32_t dcache_index(uint32_t hash) {
+    return hash & (DCACHE_BUCKETS - 1);
+}
+
+static void lru_unlink(dentry_t *dentry) {
+    if (dentry->lru_prev)
+        dentry->lru_prev->lru_next = dentry->lru_next;
+    else
+        lru_head = dentry->lru_next;
+
+    if (dentry->lru_next)
+        dentry->lru_next->lru_prev = dentry->lru_prev;
+    else
+        lru_tail = dentry->lru_prev;
+
+    dentry->lru_prev = NULL;
+    dentry->lru_next = NULL;
+}
+
+static void lru_push(dentry_t *dentry) {
+    dentry->lru_prev = NULL;
+    dentry->lru_next = lru_head;
+    if (lru_head)
+        lru_head->lru_prev = dentry;
+    lru_head = dentry;
+    if (lru_tail == NULL)
+        lru_tail = dentry;
+}
+
+static dentry_t **dcache_find(vfs_node_t *dir, const char *name, uint32_t hash) {
+    dentry_t **link = &dcache_table[dcache_index(hash)];
+    while (*link != NULL) {
+        dentry_t *dentry = *link;
+        if (dentry->hash == hash && dentry->parent == dir && strcmp(dentry->name, name) == 0)
+            return link;
+        link = &dentry->hash_next;
+    }
+    return NULL;
+}
+
+static dentry_t *dcache_detach(dentry_t *dentry) {
+    dentry_t **link = &dcache_table[dcache_index(dentry->hash)];
+    while (*link != dentry)
+        link = &(*link)->hash_next;
+    *link = dentry->hash_next;
+
+    lru_unlink(dentry);
+    dcache_count--;
+    return dentry;
+}
+
+vfs_node_t *dcache_lookup(vfs_node_t *dir, const char *name, bool *hit) {
+    *hit = false;
+    if (strlen(name) >= DCACHE_NAME_MAX)
+        return NULL;
+
+    uint32_t hash = dcache_hash(dir, name);
+    vfs_node_t *node = NULL;
+
+    uint64_t flags = spin_lock(&dcache_lock);
+
+    dentry_t **link = dcache_find(dir, name, hash);
+    if (link != NULL) {
+        dentry_t *dentry = *link;
+        lru_unlink(dentry);
+        lru_push(dentry);
+        node = dentry->node;
+        *hit = true;
+    }
+
+    spin_unlock(&dcache_lock, flags);
+    return node;
+}
+
+void dcache_insert(vfs_node_t *dir, const char *name, vfs_node_t *node) {
+    size_t len = strlen(name);
+    if (len >= DCACHE_NAME_MAX)
+        return;
+
+    dentry_t *dentry = (dentry_t *)malloc(sizeof(dentry_t));
+    if (dentry == NULL)
+        return;
+    memset(dentry, 0, sizeof(dentry_t));
+    dentry->parent = dir;
+    dentry->node = node;
+    dentry->hash = dcache_hash(dir, name);
+    memcpy(dentry->name, name, len + 1);
+
+    dentry_t *stale = NULL;
+    dentry_t *evicted = NULL;
+
+    uint64_t flags = spin_lock(&dcache_lock);
+
+    dentry_t **link = dcache_find(dir, name, dentry->hash);
+    if (link != NULL)
+        stale = dcache_detach(*link);
+    else if (dcache_count >= DCACHE_MAX_ENTRIES && lru_tail != NULL)
+        evicted = dcache_detach(lru_tail);
+
+    uint32_t index = dcache_index(dentry->hash);
+    dentry->hash_next = dcache_table[index];
+    dcache_table[index] = dentry;
+    lru_push(dentry);
+    dcache_count++;
+
+    spin_unlock(&dcache_lock, flags);
+
+    if (stale)
+        free(stale);
+    if (evicted)
+        free(evicted);
+}
+
+void dcache_invalidate(vfs_node_t *dir, const char *name) {
+    if (strlen(name) >= DCACHE_NAME_MAX)
+        return;
+
+    uint32_t hash = dcache_hash(dir, name);
+    dentry_t *dentry = NULL;
+
+    uint64_t flags = spin_lock(&dcache_lock);
+
+    dentry_t **link = dcache_find(dir, name, hash);
+    if (link != NULL)
+        dentry = dcache_detach(*link);
+
+    spin_unlock(&dcache_lock, flags);
+
+    if (dentry)
+        free(dentry);
+}
+
+static void dcache_purge(vfs_node_t *dir, bool all) {
+    dentry_t *victims = NULL;
+
+    uint64_t flags = spin_lock(&dcache_lock);
+
+    dentry_t *dentry = lru_head;
+    while (dentry != NULL) {
+        dentry_t *next = dentry->lru_next;
+        if (all || dentry->parent == dir || dentry->node == dir) {
+            dcache_detach(dentry);
+            dentry->hash_next = victims;
+            victims = dentry;
+        }
+        dentry = next;
+    }
+
+    spin_unlock(&dcache_lock, flags);
+
+    while (victims != NULL) {
+        dentry_t *next = victims->hash_next;
+        free(victims);
+        victims = next;
+    }
+}
+
+void dcache_purge_dir(vfs_node_t *dir) {
+    dcache_purge(dir, false);
+}
+
+void dcache_flush() {
+    dcache_purge(NULL, true);
+}
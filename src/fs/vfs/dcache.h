@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "vfs.h"
+
+#define DCACHE_BUCKETS 1024
+#define DCACHE_MAX_ENTRIES 4096
+#define DCACHE_NAME_MAX 48
+
+vfs_node_t *dcache_lookup(vfs_node_t *dir, const char *name, bool *hit);
+void dcache_insert(vfs_node_t *dir, const char *name, vfs_node_t *node);
+void dcache_invalidate(vfs_node_t *dir, const char *name);
+void dcache_purge_dir(vfs_node_t *dir);
+void dcache_flush();
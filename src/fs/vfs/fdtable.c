@@ -0,0 +1,224 @@
+#include "fdtable.h"
+
+#include <stddef.h>
+
+#include "../../io/terminal.h"
+#include "../../mem/alloc/heap.h"
+#include "../../std/string.h"
+
+#define FD_SETFL_MASK (O_APPEND | O_NONBLOCK)
+
+fd_table_t *fd_table_create() {
+    fd_table_t *table = (fd_table_t *)malloc(sizeof(fd_table_t));
+    if (table == NULL) {
+        printkf_error("fd_table_create(): failed to allocate fd table\n");
+        return NULL;
+    }
+    memset(table, 0, sizeof(fd_table_t));
+
+    table->refcount = 1;
+    table->used[0] = (1ULL << FD_FIRST) - 1;
+
+    return table;
+}
+
+fd_table_t *fd_table_clone(fd_table_t *table) {
+    fd_table_t *clone = fd_table_create();
+    if (clone == NULL)
+        return NULL;
+
+    uint64_t flags = spin_lock(&table->lock);
+
+    for (int i = 0; i < FD_WORDS; i++) {
+        clone->used[i] = table->used[i];
+        clone->cloexec[i] = table->cloexec[i];
+    }
+    for (int fd = 0; fd < FD_MAX; fd++) {
+        vfs_file_t *file = table->files[fd];
+        if (file != NULL) {
+            vfs_file_get(file);
+            clone->files[fd] = file;
+        }
+    }
+
+    spin_unlock(&table->lock, flags);
+
+    return clone;
+}
+
+void fd_table_get(fd_table_t *table) {
+    __atomic_fetch_add(&table->refcount, 1, __ATOMIC_RELAXED);
+}
+
+void fd_table_put(fd_table_t *table) {
+    if (__atomic_sub_fetch(&table->refcount, 1, __ATOMIC_ACQ_REL) != 0)
+        return;
+
+    for (int fd = 0; fd < FD_MAX; fd++) {
+        if (table->files[fd] != NULL)
+            vfs_file_put(table->files[fd]);
+    }
+
+    free(table);
+}
+
+static vfs_file_t *fd_remove_locked(fd_table_t *table, int fd) {
+    vfs_file_t *file = table->files[fd];
+    table->files[fd] = NULL;
+    if (fd >= FD_FIRST)
+        table->used[fd / 64] &= ~(1ULL << (fd % 64));
+    table->cloexec[fd / 64] &= ~(1ULL << (fd % 64));
+    return file;
+}
+
+void fd_table_close_on_exec(fd_table_t *table) {
+    vfs_file_t *closing[FD_MAX];
+    int count = 0;
+
+    uint64_t flags = spin_lock(&table->lock);
+
+    for (int word = 0; word < FD_WORDS; word++) {
+        uint64_t bits = table->cloexec[word];
+        while (bits != 0) {
+            int fd = word * 64 + __builtin_ctzll(bits);
+            bits &= bits - 1;
+
+            vfs_file_t *file = fd_remove_locked(table, fd);
+            if (file != NULL)
+                closing[count++] = file;
+        }
+    }
+
+    spin_unlock(&table->lock, flags);
+
+    for (int i = 0; i < count; i++) {
+        vfs_file_put(closing[i]);
+    }
+}
+
+int fd_install(fd_table_t *table, vfs_file_t *file, bool cloexec) {
+    uint64_t flags = spin_lock(&table->lock);
+
+    for (int word = 0; word < FD_WORDS; word++) {
+        uint64_t free_bits = ~table->used[word];
+        if (free_bits == 0)
+            continue;
+
+        int bit = __builtin_ctzll(free_bits);
+        int fd = word * 64 + bit;
+
+        table->used[word] |= 1ULL << bit;
+        if (cloexec)
+            table->cloexec[word] |= 1ULL << bit;
+        table->files[fd] = file;
+
+        spin_unlock(&table->lock, flags);
+        return fd;
+    }
+
+    spin_unlock(&table->lock, flags);
+    return -1;
+}
+
+vfs_file_t *fd_get(fd_table_t *table, int fd) {
+    if (fd < 0 || fd >= FD_MAX)
+        return NULL;
+
+    uint64_t flags = spin_lock(&table->lock);
+
+    vfs_file_t *file = table->files[fd];
+    if (file != NULL)
+        vfs_file_get(file);
+
+    spin_unlock(&table->lock, flags);
+
+    return file;
+}
+
+int fd_close(fd_table_t *table, int fd) {
+    if (fd < 0 || fd >= FD_MAX)
+        return -1;
+
+    uint64_t flags = spin_lock(&table->lock);
+
+    if (table->files[fd] == NULL) {
+        spin_unlock(&table->lock, flags);
+        return -1;
+    }
+
+    vfs_file_t *file = fd_remove_locked(table, fd);
+
+    spin_unlock(&table->lock, flags);
+
+    vfs_file_put(file);
+    return 0;
+}
+
+int fd_dup2(fd_table_t *table, int oldfd, int newfd) {
+    if (oldfd < 0 || oldfd >= FD_MAX || newfd < 0 || newfd >= FD_MAX)
+        return -1;
+
+    uint64_t flags = spin_lock(&table->lock);
+
+    vfs_file_t *file = table->files[oldfd];
+    if (file == NULL) {
+        spin_unlock(&table->lock, flags);
+        return -1;
+    }
+    if (oldfd == newfd) {
+        spin_unlock(&table->lock, flags);
+        return newfd;
+    }
+
+    vfs_file_get(file);
+    vfs_file_t *old = table->files[newfd];
+    table->files[newfd] = file;
+    table->used[newfd / 64] |= 1ULL << (newfd % 64);
+    table->cloexec[newfd / 64] &= ~(1ULL << (newfd % 64));
+
+    spin_unlock(&table->lock, flags);
+
+    if (old != NULL)
+        vfs_file_put(old);
+    return newfd;
+}
+
+int fd_fcntl(fd_table_t *table, int fd, int cmd, int arg) {
+    if (fd < 0 || fd >= FD_MAX)
+        return -1;
+
+    uint64_t flags = spin_lock(&table->lock);
+
+    if (table->files[fd] == NULL) {
+        spin_unlock(&table->lock, flags);
+        return -1;
+    }
+
+    uint64_t bit = 1ULL << (fd % 64);
+    int ret = 0;
+
+    switch (cmd) {
+    case F_GETFD:
+        ret = (table->cloexec[fd / 64] & bit) ? FD_CLOEXEC : 0;
+        break;
+    case F_SETFD:
+        if (arg & FD_CLOEXEC)
+            table->cloexec[fd / 64] |= bit;
+        else
+            table->cloexec[fd / 64] &= ~bit;
+        break;
+    case F_GETFL:
+        ret = table->files[fd]->flags;
+        break;
+    case F_SETFL:
+        table->files[fd]->flags = (table->files[fd]->flags & ~FD_SETFL_MASK) | (arg & FD_SETFL_MASK);
+        break;
+    default:
+        ret = -1;
+        break;
+    }
+
+    spin_unlock(&table->lock, flags);
+
+    return ret;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../../sync/spinlock.h"
+#include "vfs.h"
+
+#define FD_MAX 256
+#define FD_FIRST 3
+#define FD_WORDS (FD_MAX / 64)
+
+#define F_GETFD 1
+#define F_SETFD 2
+#define F_GETFL 3
+#define F_SETFL 4
+#define FD_CLOEXEC 1
+
+typedef struct fd_table {
+    volatile uint32_t refcount;
+    spinlock_t lock;
+    uint64_t used[FD_WORDS];
+    uint64_t cloexec[FD_WORDS];
+    vfs_file_t *files[FD_MAX];
+} fd_table_t;
+
+fd_table_t *fd_table_create();
+fd_table_t *fd_table_clone(fd_table_t *table);
+void fd_table_get(fd_table_t *table);
+void fd_table_put(fd_table_t *table);
+void fd_table_close_on_exec(fd_table_t *table);
+
+int fd_install(fd_table_t *table, vfs_file_t *file, bool cloexec);
+vfs_file_t *fd_get(fd_table_t *table, int fd);
+int fd_close(fd_table_t *table, int fd);
+int fd_dup2(fd_table_t *table, int oldfd, int newfd);
+int fd_fcntl(fd_table_t *table, int fd, int cmd, int arg);
@@ -0,0 +1,811 @@
+#include "page_cache.h"
+
+#include <stdbool.h>
+
+#include "../../io/terminal.h"
+#include "../../mem/alloc/heap.h"
+#include "../../mem/alloc/page_frame_alloc.h"
+#include "../../std/string.h"
+#include "../../sync/mutex.h"
+#include "../../sync/spinlock.h"
+#include "../../sync/waitqueue.h"
+#include "../../task/workqueue.h"
+
+#define PAGE_CACHE_RADIX_MASK (PAGE_CACHE_RADIX_SLOTS - 1)
+#define PAGE_CACHE_MAX_HEIGHT 11
+
+typedef struct radix_node {
+    void *slots[PAGE_CACHE_RADIX_SLOTS];
+    uint32_t count;
+} radix_node_t;
+
+typedef struct address_space {
+    mutex_t lock;
+    vfs_node_t *host;
+    radix_node_t *root;
+    uint32_t height;
+    uint64_t nrpages;
+} address_space_t;
+
+typedef struct cache_page {
+    address_space_t *mapping;
+    uint64_t index;
+    void *data;
+    uint32_t pins;
+    bool dirty;
+    bool busy;
+    bool readahead;
+    bool marker;
+    struct cache_page *lru_prev;
+    struct cache_page *lru_next;
+} cache_page_t;
+
+static spinlock_t lru_lock = {0};
+static cache_page_t *lru_head = NULL;
+static cache_page_t *lru_tail = NULL;
+static page_cache_stats_t cache_stats = {0};
+
+static wait_queue_t io_wq;
+static volatile uint64_t io_seq = 0;
+static workqueue_t *readahead_wq = NULL;
+static work_t reclaim_work;
+static void *deferred_free = NULL;
+
+typedef struct {
+    work_t work;
+    vfs_file_t *file;
+    uint64_t start;
+    uint32_t count;
+} readahead_req_t;
+
+static inline void stat_add(uint64_t *counter, int64_t delta) {
+    __atomic_add_fetch(counter, delta, __ATOMIC_RELAXED);
+}
+
+static uint64_t radix_max_index(uint32_t height) {
+    if (height == 0)
+        return 0;
+    if (height * PAGE_CACHE_RADIX_SHIFT >= 64)
+        return UINT64_MAX;
+    return (1ULL << (height * PAGE_CACHE_RADIX_SHIFT)) - 1;
+}
+
+static void defer_free(void *ptr) {
+    *(void **)ptr = deferred_free;
+    deferred_free = ptr;
+}
+
+static void flush_deferred_free() {
+    uint64_t flags = spin_lock(&lru_lock);
+    void *ptr = deferred_free;
+    deferred_free = NULL;
+    spin_unlock(&lru_lock, flags);
+
+    while (ptr != NULL) {
+        void *next = *(void **)ptr;
+        free(ptr);
+        ptr = next;
+    }
+}
+
+static radix_node_t *radix_node_alloc() {
+    radix_node_t *rnode = (radix_node_t *)malloc(sizeof(radix_node_t));
+    if (rnode != NULL)
+        memset(rnode, 0, sizeof(radix_node_t));
+    return rnode;
+}
+
+static cache_page_t *radix_lookup(address_space_t *mapping, uint64_t index) {
+    if (mapping->root == NULL || index > radix_max_index(mapping->height))
+        return NULL;
+
+    radix_node_t *rnode = mapping->root;
+    for (uint32_t level = mapping->height - 1; level > 0; level--) {
+        rnode = (radix_node_t *)rnode->slots[(index >> (level * PAGE_CACHE_RADIX_SHIFT)) & PAGE_CACHE_RADIX_MASK];
+        if (rnode == NULL)
+            return NULL;
+    }
+    return (cache_page_t *)rnode->slots[index & PAGE_CACHE_RADIX_MASK];
+}
+
+static cache_page_t *radix_next_from(radix_node_t *rnode, uint32_t level, uint64_t base, uint64_t from) {
+    uint32_t shift = (level - 1) * PAGE_CACHE_RADIX_SHIFT;
+    uint32_t slot = from > base ? (from - base) >> shift : 0;
+
+    for (; slot < PAGE_CACHE_RADIX_SLOTS; slot++) {
+        if (rnode->slots[slot] == NULL)
+            continue;
+        if (level == 1)
+            return (cache_page_t *)rnode->slots[slot];
+
+        uint64_t child_base = base + ((uint64_t)slot << shift);
+        cache_page_t *page = radix_next_from((radix_node_t *)rnode->slots[slot], level - 1, child_base, from);
+        if (page != NULL)
+            return page;
+    }
+    return NULL;
+}
+
+static cache_page_t *radix_next(address_space_t *mapping, uint64_t from) {
+    if (mapping->root == NULL || from > radix_max_index(mapping->height))
+        return NULL;
+    return radix_next_from(mapping->root, mapping->height, 0, from);
+}
+
+static int radix_insert(address_space_t *mapping, uint64_t index, cache_page_t *page) {
+    if (mapping->root == NULL) {
+        mapping->root = radix_node_alloc();
+        if (mapping->root == NULL)
+            return -1;
+        mapping->height = 1;
+    }
+
+    while (index > radix_max_index(mapping->height)) {
+        radix_node_t *root = radix_node_alloc();
+        if (root == NULL)
+            return -1;
+        root->slots[0] = mapping->root;
+        root->count = 1;
+        mapping->root = root;
+        mapping->height++;
+    }
+
+    radix_node_t *rnode = mapping->root;
+    for (uint32_t level = mapping->height - 1; level > 0; level--) {
+        uint32_t slot = (index >> (level * PAGE_CACHE_RADIX_SHIFT)) & PAGE_CACHE_RADIX_MASK;
+        if (rnode->slots[slot] == NULL) {
+            rnode->slots[slot] = radix_node_alloc();
+            if (rnode->slots[slot] == NULL)
+                return -1;
+            rnode->count++;
+        }
+        rnode = (radix_node_t *)rnode->slots[slot];
+    }
+
+    rnode->slots[index & PAGE_CACHE_RADIX_MASK] = page;
+    rnode->count++;
+    return 0;
+}
+
+static void radix_delete(address_space_t *mapping, uint64_t index, bool defer) {
+    if (mapping->root == NULL || index > radix_max_index(mapping->height))
+        return;
+
+    radix_node_t *path[PAGE_CACHE_MAX_HEIGHT];
+    uint32_t slots[PAGE_CACHE_MAX_HEIGHT];
+
+    radix_node_t *rnode = mapping->root;
+    uint32_t depth = 0;
+    for (uint32_t level = mapping->height; level > 0; level--) {
+        uint32_t slot = (index >> ((level - 1) * PAGE_CACHE_RADIX_SHIFT)) & PAGE_CACHE_RADIX_MASK;
+        path[depth] = rnode;
+        slots[depth] = slot;
+        depth++;
+
+        if (level == 1)
+            break;
+        rnode = (radix_node_t *)rnode->slots[slot];
+        if (rnode == NULL)
+            return;
+    }
+
+    while (depth > 0) {
+        depth--;
+        rnode = path[depth];
+        if (rnode->slots[slots[depth]] == NULL)
+            return;
+
+        rnode->slots[slots[depth]] = NULL;
+        rnode->count--;
+        if (rnode->count > 0)
+            return;
+
+        if (defer)
+            defer_free(rnode);
+        else
+            free(rnode);
+        if (depth == 0) {
+            mapping->root = NULL;
+            mapping->height = 0;
+        }
+    }
+}
+
+static void lru_unlink(cache_page_t *page) {
+    if (page->lru_prev)
+        page->lru_prev->lru_next = page->lru_next;
+    else
+        lru_head = page->lru_next;
+
+    if (page->lru_next)
+        page->lru_next->lru_prev = page->lru_prev;
+    else
+        lru_tail = page->lru_prev;
+
+    page->lru_prev = NULL;
+    page->lru_next = NULL;
+}
+
+static void lru_push(cache_page_t *page) {
+    page->lru_prev = NULL;
+    page->lru_next = lru_head;
+    if (lru_head)
+        lru_head->lru_prev = page;
+    lru_head = page;
+    if (lru_tail == NULL)
+        lru_tail = page;
+}
+
+static void lru_touch(cache_page_t *page) {
+    uint64_t flags = spin_lock(&lru_lock);
+    if (lru_head != page) {
+        lru_unlink(page);
+        lru_push(page);
+    }
+    spin_unlock(&lru_lock, flags);
+}
+
+static void lru_remove(cache_page_t *page) {
+    lru_unlink(page);
+
+    if (page->dirty)
+        stat_add(&cache_stats.dirty, -1);
+    stat_add(&cache_stats.pages, -1);
+}
+
+static void page_set_dirty(cache_page_t *page) {
+    if (!page->dirty) {
+        page->dirty = true;
+        stat_add(&cache_stats.dirty, 1);
+    }
+}
+
+static int page_writeback(cache_page_t *page) {
+    if (!page->dirty)
+        return 0;
+
+    vfs_node_t *node = page->mapping->host;
+    uint64_t start = page->index * PAGE_SIZE;
+    size_t len = 0;
+    if (node->inode->size > start) {
+        len = node->inode->size - start;
+        if (len > PAGE_SIZE)
+            len = PAGE_SIZE;
+    }
+
+    if (len > 0 && node->ops->writepage(node, page->index, page->data, len) < 0) {
+        printkf_error("page_writeback(): failed to write page %llu\n", page->index);
+        return -1;
+    }
+
+    page->dirty = false;
+    stat_add(&cache_stats.dirty, -1);
+    stat_add(&cache_stats.writebacks, 1);
+    return 0;
+}
+
+static void page_wait_io(address_space_t *mapping) {
+    uint64_t seq = io_seq;
+    mutex_unlock(&mapping->lock);
+    wait_event(&io_wq, __atomic_load_n(&io_seq, __ATOMIC_ACQUIRE) != seq);
+    mutex_lock(&mapping->lock);
+}
+
+static void page_io_done() {
+    __atomic_add_fetch(&io_seq, 1, __ATOMIC_RELEASE);
+    wait_queue_wake_all(&io_wq);
+}
+
+static void page_unpin(cache_page_t *page) {
+    if (--page->pins == 0)
+        page_io_done();
+}
+
+static void page_drop(cache_page_t *page) {
+    address_space_t *mapping = page->mapping;
+    radix_delete(mapping, page->index, false);
+    mapping->nrpages--;
+
+    uint64_t flags = spin_lock(&lru_lock);
+    lru_remove(page);
+    spin_unlock(&lru_lock, flags);
+
+    pfallocator_free_page(page->data);
+    free(page);
+}
+
+static uint64_t page_cache_shrink(uint64_t target) {
+    uint64_t freed = 0;
+    uint32_t scanned = 0;
+
+    uint64_t flags = spin_lock(&lru_lock);
+
+    cache_page_t *page = lru_tail;
+    while (page != NULL && freed < target && scanned < PAGE_CACHE_RECLAIM_BATCH) {
+        cache_page_t *prev = page->lru_prev;
+        address_space_t *mapping = page->mapping;
+        scanned++;
+
+        if (mutex_trylock(&mapping->lock)) {
+            if (!page->busy && !page->dirty && page->pins == 0) {
+                radix_delete(mapping, page->index, true);
+                mapping->nrpages--;
+                lru_remove(page);
+                pfallocator_free_page(page->data);
+                defer_free(page);
+                stat_add(&cache_stats.evictions, 1);
+                freed++;
+            }
+            mutex_unlock(&mapping->lock);
+        }
+        page = prev;
+    }
+
+    spin_unlock(&lru_lock, flags);
+    return freed;
+}
+
+static cache_page_t *reclaim_pick() {
+    uint64_t flags = spin_lock(&lru_lock);
+
+    cache_page_t *page = lru_tail;
+    while (page != NULL) {
+        if (mutex_trylock(&page->mapping->lock)) {
+            if (!page->busy && page->pins == 0)
+                break;
+            mutex_unlock(&page->mapping->lock);
+        }
+        page = page->lru_prev;
+    }
+
+    spin_unlock(&lru_lock, flags);
+    return page;
+}
+
+static void reclaim_worker(work_t *work) {
+    (void)work;
+
+    for (uint32_t scanned = 0; scanned < PAGE_CACHE_RECLAIM_BATCH && pfallocator_get_free_ram() < PAGE_CACHE_MIN_FREE;
+         scanned++) {
+        cache_page_t *page = reclaim_pick();
+        if (page == NULL)
+            break;
+
+        address_space_t *mapping = page->mapping;
+        if (page_writeback(page) == 0) {
+            page_drop(page);
+            stat_add(&cache_stats.evictions, 1);
+        } else {
+            lru_touch(page);
+        }
+
+        uint64_t flags = spin_lock(&lru_lock);
+        mutex_unlock(&mapping->lock);
+        spin_unlock(&lru_lock, flags);
+    }
+
+    flush_deferred_free();
+}
+
+static address_space_t *mapping_get(vfs_node_t *node) {
+    vfs_inode_t *inode = node->inode;
+    address_space_t *mapping = __atomic_load_n(&inode->mapping, __ATOMIC_ACQUIRE);
+    if (mapping == NULL) {
+        address_space_t *fresh = (address_space_t *)malloc(sizeof(address_space_t));
+        if (fresh == NULL)
+            return NULL;
+        memset(fresh, 0, sizeof(address_space_t));
+        mutex_init(&fresh->lock);
+        fresh->host = node;
+
+        if (__atomic_compare_exchange_n(&inode->mapping, &mapping, fresh, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            mapping = fresh;
+        else
+            free(fresh);
+    }
+
+    mapping->host = node;
+    return mapping;
+}
+
+static cache_page_t *page_alloc() {
+    flush_deferred_free();
+    if (readahead_wq != NULL && pfallocator_get_free_ram() < PAGE_CACHE_MIN_FREE)
+        queue_work(readahead_wq, &reclaim_work);
+
+    cache_page_t *page = (cache_page_t *)malloc(sizeof(cache_page_t));
+    if (page == NULL)
+        return NULL;
+    memset(page, 0, sizeof(cache_page_t));
+
+    page->data = pfallocator_request_page();
+    if (page->data == NULL) {
+        free(page);
+        return NULL;
+    }
+    return page;
+}
+
+static int page_insert(address_space_t *mapping, uint64_t index, cache_page_t *page) {
+    if (radix_insert(mapping, index, page) < 0) {
+        printkf_error("page_insert(): failed to grow radix tree\n");
+        pfallocator_free_page(page->data);
+        free(page);
+        return -1;
+    }
+
+    page->mapping = mapping;
+    page->index = index;
+    mapping->nrpages++;
+    stat_add(&cache_stats.pages, 1);
+
+    uint64_t flags = spin_lock(&lru_lock);
+    lru_push(page);
+    spin_unlock(&lru_lock, flags);
+    return 0;
+}
+
+static cache_page_t *page_get(address_space_t *mapping, uint64_t index, bool fill) {
+    cache_page_t *page = radix_lookup(mapping, index);
+    while (page != NULL && page->busy) {
+        page_wait_io(mapping);
+        page = radix_lookup(mapping, index);
+    }
+
+    if (page != NULL) {
+        stat_add(&cache_stats.hits, 1);
+        lru_touch(page);
+        return page;
+    }
+
+    stat_add(&cache_stats.misses, 1);
+
+    page = page_alloc();
+    if (page == NULL)
+        return NULL;
+
+    vfs_node_t *node = mapping->host;
+    if (!fill || index * PAGE_SIZE >= node->inode->size) {
+        memset(page->data, 0, PAGE_SIZE);
+        return page_insert(mapping, index, page) < 0 ? NULL : page;
+    }
+
+    page->busy = true;
+    if (page_insert(mapping, index, page) < 0)
+        return NULL;
+
+    mutex_unlock(&mapping->lock);
+    int ret = node->ops->readpage(node, index, page->data);
+    mutex_lock(&mapping->lock);
+
+    page->busy = false;
+    page_io_done();
+
+    if (ret < 0) {
+        page_drop(page);
+        return NULL;
+    }
+    return page;
+}
+
+static void readahead_worker(work_t *work) {
+    readahead_req_t *req = (readahead_req_t *)work;
+    vfs_node_t *node = req->file->node;
+    cache_page_t *batch[PAGE_CACHE_RA_MAX];
+    uint32_t nr = 0;
+
+    address_space_t *mapping = mapping_get(node);
+    if (mapping == NULL) {
+        vfs_file_put(req->file);
+        free(req);
+        return;
+    }
+
+    mutex_lock(&mapping->lock);
+
+    for (uint32_t i = 0; i < req->count && nr < PAGE_CACHE_RA_MAX; i++) {
+        uint64_t index = req->start + i;
+        if (index * PAGE_SIZE >= node->inode->size)
+            break;
+        if (radix_lookup(mapping, index) != NULL)
+            continue;
+
+        cache_page_t *page = page_alloc();
+        if (page == NULL)
+            break;
+
+        page->busy = true;
+        page->readahead = true;
+        page->marker = nr == 0;
+        if (page_insert(mapping, index, page) < 0)
+            break;
+        batch[nr++] = page;
+    }
+    stat_add(&cache_stats.ra_pages, nr);
+
+    mutex_unlock(&mapping->lock);
+
+    for (uint32_t i = 0; i < nr; i++) {
+        cache_page_t *page = batch[i];
+        int ret = node->ops->readpage(node, page->index, page->data);
+
+        mutex_lock(&mapping->lock);
+        page->busy = false;
+        if (ret < 0)
+            page_drop(page);
+        page_io_done();
+        mutex_unlock(&mapping->lock);
+    }
+
+    vfs_file_put(req->file);
+    free(req);
+}
+
+static void readahead_submit(vfs_file_t *file, uint64_t start, uint32_t count) {
+    if (readahead_wq == NULL || count == 0)
+        return;
+
+    readahead_req_t *req = (readahead_req_t *)malloc(sizeof(readahead_req_t));
+    if (req == NULL)
+        return;
+
+    work_init(&req->work, readahead_worker);
+    req->file = file;
+    req->start = start;
+    req->count = count;
+
+    vfs_file_get(file);
+    queue_work(readahead_wq, &req->work);
+}
+
+static void readahead_miss(vfs_file_t *file, uint64_t index) {
+    vfs_readahead_t *ra = &file->ra;
+
+    stat_add(&cache_stats.ra_misses, 1);
+
+    if (index == 0 || index == ra->prev_index || index == ra->prev_index + 1) {
+        ra->size = ra->size == 0 ? PAGE_CACHE_RA_INIT : ra->size * 2;
+        if (ra->size > PAGE_CACHE_RA_MAX)
+            ra->size = PAGE_CACHE_RA_MAX;
+    } else {
+        ra->size = 0;
+    }
+
+    ra->start = index;
+    if (ra->size > 1)
+        readahead_submit(file, index + 1, ra->size - 1);
+}
+
+static void readahead_marker(vfs_file_t *file, cache_page_t *page) {
+    vfs_readahead_t *ra = &file->ra;
+
+    page->marker = false;
+
+    if (ra->size == 0 || page->index < ra->start || page->index >= ra->start + ra->size) {
+        ra->start = page->index;
+        ra->size = PAGE_CACHE_RA_INIT;
+    }
+
+    ra->start += ra->size;
+    ra->size *= 2;
+    if (ra->size > PAGE_CACHE_RA_MAX)
+        ra->size = PAGE_CACHE_RA_MAX;
+
+    readahead_submit(file, ra->start, ra->size);
+}
+
+void page_cache_init() {
+    wait_queue_init(&io_wq);
+    work_init(&reclaim_work, reclaim_worker);
+    pfallocator_set_reclaim(page_cache_shrink);
+
+    readahead_wq = workqueue_create("readahead", 2, 0);
+    if (readahead_wq == NULL)
+        printkf_error("page_cache_init(): failed to create readahead workqueue\n");
+}
+
+void page_cache_drain() {
+    if (readahead_wq != NULL)
+        flush_workqueue(readahead_wq);
+}
+
+int64_t page_cache_read(vfs_file_t *file, void *buf, size_t size, size_t offset) {
+    vfs_node_t *node = file->node;
+
+    address_space_t *mapping = mapping_get(node);
+    if (mapping == NULL)
+        return -1;
+
+    mutex_lock(&mapping->lock);
+
+    uint64_t file_size = node->inode->size;
+    if (offset >= file_size) {
+        mutex_unlock(&mapping->lock);
+        return 0;
+    }
+    if (size > file_size - offset)
+        size = file_size - offset;
+
+    size_t done = 0;
+    while (done < size) {
+        uint64_t pos = offset + done;
+        uint64_t index = pos / PAGE_SIZE;
+
+        if (radix_lookup(mapping, index) == NULL)
+            readahead_miss(file, index);
+
+        cache_page_t *page = page_get(mapping, index, true);
+        if (page == NULL)
+            break;
+
+        if (page->readahead) {
+            page->readahead = false;
+            stat_add(&cache_stats.ra_hits, 1);
+        }
+        if (page->marker)
+            readahead_marker(file, page);
+        file->ra.prev_index = index;
+
+        size_t page_offset = pos % PAGE_SIZE;
+        size_t chunk = PAGE_SIZE - page_offset;
+        if (chunk > size - done)
+            chunk = size - done;
+
+        page->pins++;
+        mutex_unlock(&mapping->lock);
+
+        memcpy((uint8_t *)buf + done, (uint8_t *)page->data + page_offset, chunk);
+        done += chunk;
+
+        mutex_lock(&mapping->lock);
+        page_unpin(page);
+    }
+
+    mutex_unlock(&mapping->lock);
+
+    if (done == 0 && size > 0)
+        return -1;
+    return done;
+}
+
+int64_t page_cache_write(vfs_node_t *node, const void *buf, size_t size, size_t offset) {
+    address_space_t *mapping = mapping_get(node);
+    if (mapping == NULL)
+        return -1;
+
+    mutex_lock(&mapping->lock);
+
+    size_t done = 0;
+    while (done < size) {
+        uint64_t pos = offset + done;
+        size_t page_offset = pos % PAGE_SIZE;
+        size_t chunk = PAGE_SIZE - page_offset;
+        if (chunk > size - done)
+            chunk = size - done;
+
+        cache_page_t *page = page_get(mapping, pos / PAGE_SIZE, chunk < PAGE_SIZE);
+        if (page == NULL)
+            break;
+
+        page->busy = true;
+        mutex_unlock(&mapping->lock);
+
+        memcpy((uint8_t *)page->data + page_offset, (const uint8_t *)buf + done, chunk);
+        done += chunk;
+
+        mutex_lock(&mapping->lock);
+        page->busy = false;
+        page_set_dirty(page);
+        page_io_done();
+
+        if (pos + chunk > node->inode->size)
+            node->inode->size = pos + chunk;
+    }
+
+    mutex_unlock(&mapping->lock);
+
+    if (done == 0 && size > 0)
+        return -1;
+    return done;
+}
+
+static int mapping_sync(address_space_t *mapping, radix_node_t *rnode, uint32_t level) {
+    int ret = 0;
+    for (uint32_t i = 0; i < PAGE_CACHE_RADIX_SLOTS; i++) {
+        if (rnode->slots[i] == NULL)
+            continue;
+
+        if (level > 1) {
+            if (mapping_sync(mapping, (radix_node_t *)rnode->slots[i], level - 1) < 0)
+                ret = -1;
+        } else if (page_writeback((cache_page_t *)rnode->slots[i]) < 0) {
+            ret = -1;
+        }
+    }
+    return ret;
+}
+
+int page_cache_sync(vfs_node_t *node) {
+    if (node->inode->mapping == NULL)
+        return 0;
+
+    address_space_t *mapping = mapping_get(node);
+    int ret = 0;
+
+    mutex_lock(&mapping->lock);
+    if (mapping->root != NULL)
+        ret = mapping_sync(mapping, mapping->root, mapping->height);
+    mutex_unlock(&mapping->lock);
+
+    if (node->ops->sync && node->ops->sync(node) < 0)
+        ret = -1;
+
+    return ret;
+}
+
+static void mapping_drop_from(address_space_t *mapping, uint64_t from) {
+    cache_page_t *page;
+    while ((page = radix_next(mapping, from)) != NULL) {
+        if (page->busy || page->pins > 0) {
+            page_wait_io(mapping);
+            continue;
+        }
+        from = page->index + 1;
+        page_drop(page);
+    }
+}
+
+void page_cache_truncate(vfs_node_t *node, size_t size) {
+    if (node->inode->mapping == NULL)
+        return;
+
+    address_space_t *mapping = mapping_get(node);
+    mutex_lock(&mapping->lock);
+
+    mapping_drop_from(mapping, (size + PAGE_SIZE - 1) / PAGE_SIZE);
+
+    if (size % PAGE_SIZE != 0) {
+        cache_page_t *page = radix_lookup(mapping, size / PAGE_SIZE);
+        while (page != NULL && page->busy) {
+            page_wait_io(mapping);
+            page = radix_lookup(mapping, size / PAGE_SIZE);
+        }
+        if (page != NULL) {
+            memset((uint8_t *)page->data + size % PAGE_SIZE, 0, PAGE_SIZE - size % PAGE_SIZE);
+            page_set_dirty(page);
+        }
+    }
+
+    mutex_unlock(&mapping->lock);
+}
+
+void page_cache_invalidate(vfs_node_t *node, size_t offset) {
+    if (node->inode->mapping == NULL)
+        return;
+
+    address_space_t *mapping = mapping_get(node);
+    mutex_lock(&mapping->lock);
+    mapping_drop_from(mapping, offset / PAGE_SIZE);
+    mutex_unlock(&mapping->lock);
+}
+
+void page_cache_release(vfs_inode_t *inode) {
+    address_space_t *mapping = (address_space_t *)inode->mapping;
+    if (mapping == NULL)
+        return;
+
+    mutex_lock(&mapping->lock);
+    mapping_drop_from(mapping, 0);
+    mutex_unlock(&mapping->lock);
+
+    // Shrink and reclaim unlock a mapping only while holding lru_lock.
+    uint64_t flags = spin_lock(&lru_lock);
+    spin_unlock(&lru_lock, flags);
+
+    inode->mapping = NULL;
+    free(mapping);
+}
+
+void page_cache_get_stats(page_cache_stats_t *stats) {
+    *stats = cache_stats;
+}
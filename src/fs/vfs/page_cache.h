@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "vfs.h"
+
+#define PAGE_CACHE_RADIX_SHIFT 6
+#define PAGE_CACHE_RADIX_SLOTS (1 << PAGE_CACHE_RADIX_SHIFT)
+#define PAGE_CACHE_MIN_FREE (4 * 1024 * 1024)
+#define PAGE_CACHE_RECLAIM_BATCH 32
+#define PAGE_CACHE_RA_INIT 4
+#define PAGE_CACHE_RA_MAX 64
+
+typedef struct {
+    uint64_t pages;
+    uint64_t dirty;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t writebacks;
+    uint64_t ra_hits;
+    uint64_t ra_misses;
+    uint64_t ra_pages;
+} page_cache_stats_t;
+
+void page_cache_init();
+void page_cache_drain();
+
+int64_t page_cache_read(vfs_file_t *file, void *buf, size_t size, size_t offset);
+int64_t page_cache_write(vfs_node_t *node, const void *buf, size_t size, size_t offset);
+int page_cache_sync(vfs_node_t *node);
+void page_cache_truncate(vfs_node_t *node, size_t size);
+void page_cache_invalidate(vfs_node_t *node, size_t offset);
+void page_cache_release(vfs_inode_t *inode);
+void page_cache_get_stats(page_cache_stats_t *stats);
@@ -1,52 +1,158 @@
 #include "vfs.h"
 
 #include "../../io/terminal.h"
+#include "../../ipc/poll.h"
 #include "../../mem/alloc/heap.h"
+#include "../../mem/alloc/page_frame_alloc.h"
 #include "../../std/string.h"
+#include "../../sync/rwlock.h"
+#include "../../sync/spinlock.h"
+#include "../../task/task.h"
+#include "dcache.h"
+#include "fdtable.h"
+#include "page_cache.h"
 
 static vfs_node_t *root_node = NULL;
+static rwlock_t tree_lock;
 
-#define MAX_FDS 256
-static file_descriptor_t fd_table[MAX_FDS];
+static vfs_file_t *open_files = NULL;
+static spinlock_t open_files_lock = {0};
+static uint64_t next_ino = 1;
 
 void vfs_init() {
     printkf_info("Initializing VFS...\n");
-    for (int i = 0; i < MAX_FDS; i++) {
-        fd_table[i].in_use = false;
-    }
 
-    root_node = (vfs_node_t *)malloc(sizeof(vfs_node_t));
-    memset(root_node, 0, sizeof(vfs_node_t));
+    rwlock_init(&tree_lock);
 
-    root_node->name[0] = '/';
-    root_node->name[1] = '\0';
-    root_node->type = VFS_DIRECTORY;
+    root_node = vfs_node_alloc("/", VFS_DIRECTORY, NULL);
     root_node->parent = root_node;
 
     printkf_ok("VFS Initialized\n");
 }
 
+static int node_set_name(vfs_node_t *node, const char *name) {
+    size_t len = strlen(name);
+    if (len >= VFS_MAX_NAME)
+        len = VFS_MAX_NAME - 1;
+
+    char *storage = node->name_inline;
+    if (len >= VFS_NAME_INLINE) {
+        storage = (char *)malloc(len + 1);
+        if (storage == NULL)
+            return -1;
+    }
+
+    memcpy(storage, name, len);
+    storage[len] = '\0';
+    node->name = storage;
+    return 0;
+}
+
+vfs_node_t *vfs_node_alloc(const char *name, vfs_node_type_t type, vfs_ops_t *ops) {
+    vfs_node_t *node = (vfs_node_t *)malloc(sizeof(vfs_node_t));
+    vfs_inode_t *inode = (vfs_inode_t *)malloc(sizeof(vfs_inode_t));
+    if (node == NULL || inode == NULL) {
+        printkf_error("vfs_node_alloc(): failed to allocate node\n");
+        if (node)
+            free(node);
+        if (inode)
+            free(inode);
+        return NULL;
+    }
+    memset(node, 0, sizeof(vfs_node_t));
+    memset(inode, 0, sizeof(vfs_inode_t));
+
+    if (node_set_name(node, name) < 0) {
+        printkf_error("vfs_node_alloc(): failed to allocate name\n");
+        free(inode);
+        free(node);
+        return NULL;
+    }
+
+    inode->links = 1;
+    node->inode = inode;
+    node->type = type;
+    node->ops = ops;
+    return node;
+}
+
+void vfs_node_init(vfs_node_t *node, vfs_inode_t *inode, const char *name, vfs_node_type_t type) {
+    memset(node, 0, sizeof(vfs_node_t));
+    memset(inode, 0, sizeof(vfs_inode_t));
+
+    strncpy(node->name_inline, name, VFS_NAME_INLINE - 1);
+    node->name = node->name_inline;
+    inode->links = 1;
+    node->inode = inode;
+    node->type = type;
+}
+
+void vfs_node_free(vfs_node_t *node) {
+    if (node->name != node->name_inline)
+        free((void *)node->name);
+
+    vfs_inode_t *inode = node->inode;
+    if (inode != NULL && __atomic_sub_fetch(&inode->links, 1, __ATOMIC_ACQ_REL) == 0) {
+        page_cache_release(inode);
+        free(inode);
+    }
+
+    free(node);
+}
+
 vfs_node_t *vfs_root() {
     return root_node;
 }
 
-static int alloc_fd() {
-    for (int i = 3; i < MAX_FDS; i++) {
-        if (!fd_table[i].in_use) {
-            fd_table[i].in_use = true;
-            return i;
+void vfs_lock_tree() {
+    rwlock_write_lock(&tree_lock);
+}
+
+void vfs_unlock_tree() {
+    rwlock_write_unlock(&tree_lock);
+}
+
+static uint64_t node_ino(vfs_node_t *node) {
+    vfs_inode_t *inode = node->inode;
+    if (inode->ino == 0) {
+        uint64_t ino = __atomic_fetch_add(&next_ino, 1, __ATOMIC_RELAXED);
+        uint64_t expected = 0;
+        __atomic_compare_exchange_n(&inode->ino, &expected, ino, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+    return inode->ino;
+}
+
+static void fill_stat(vfs_node_t *node, vfs_stat_t *stat) {
+    stat->type = node->type;
+    stat->size = node->inode->size;
+    stat->ino = node_ino(node);
+}
+
+static bool node_is_open(vfs_node_t *node) {
+    bool open = false;
+    uint64_t flags = spin_lock(&open_files_lock);
+
+    for (vfs_file_t *file = open_files; file != NULL; file = file->next_open) {
+        if (file->node == node) {
+            open = true;
+            break;
         }
     }
 
-    return -1;
+    spin_unlock(&open_files_lock, flags);
+    return open;
 }
 
-static file_descriptor_t *get_fd(int fd) {
-    if (fd < 0 || fd >= MAX_FDS)
-        return NULL;
-    if (!fd_table[fd].in_use)
-        return NULL;
-    return &fd_table[fd];
+static void detach_cursors(vfs_node_t *node) {
+    uint64_t flags = spin_lock(&open_files_lock);
+
+    for (vfs_file_t *file = open_files; file != NULL; file = file->next_open) {
+        if (file->dir_cursor == node) {
+            file->dir_cursor = node->next;
+        }
+    }
+
+    spin_unlock(&open_files_lock, flags);
 }
 
 static vfs_node_t *find_child(vfs_node_t *dir, const char *name) {
@@ -63,6 +169,20 @@ static vfs_node_t *find_child(vfs_node_t *dir, const char *name) {
     return NULL;
 }
 
+static vfs_node_t *lookup_child(vfs_node_t *dir, const char *name) {
+    if (dir->type != VFS_DIRECTORY)
+        return NULL;
+
+    bool hit;
+    vfs_node_t *node = dcache_lookup(dir, name, &hit);
+    if (hit)
+        return node;
+
+    node = find_child(dir, name);
+    dcache_insert(dir, name, node);
+    return node;
+}
+
 static void add_child(vfs_node_t *dir, vfs_node_t *child) {
     child->parent = dir;
     child->next = dir->children;
@@ -84,7 +204,36 @@ static void remove_child(vfs_node_t *dir, vfs_node_t *child) {
     }
 }
 
-vfs_node_t *vfs_lookup(const char *path) {
+static int64_t node_read(vfs_file_t *f, void *buf, size_t size, size_t offset) {
+    vfs_node_t *node = f->node;
+    if (node->ops == NULL)
+        return -1;
+    if (node->ops->readpage)
+        return page_cache_read(f, buf, size, offset);
+    if (node->ops->read)
+        return node->ops->read(node, buf, size, offset);
+    return -1;
+}
+
+static int64_t node_write(vfs_node_t *node, const void *buf, size_t size, size_t offset) {
+    if (node->ops == NULL)
+        return -1;
+    if (node->ops->writepage)
+        return page_cache_write(node, buf, size, offset);
+    if (node->ops->write)
+        return node->ops->write(node, buf, size, offset);
+    return -1;
+}
+
+static int node_truncate(vfs_node_t *node, size_t size) {
+    if (node->ops == NULL || node->ops->truncate == NULL)
+        return -1;
+    if (node->ops->readpage)
+        page_cache_truncate(node, size);
+    return node->ops->truncate(node, size);
+}
+
+vfs_node_t *vfs_lookup_locked(const char *path) {
     if (path == NULL || path[0] == '\0')
         return NULL;
     if (path[0] != '/')
@@ -105,7 +254,7 @@ vfs_node_t *vfs_lookup(const char *path) {
                 } else if (strcmp(component, "..") == 0) {
                     current = current->parent;
                 } else {
-                    current = find_child(current, component);
+                    current = lookup_child(current, component);
                     if (current == NULL) {
                         return NULL;
                     }
@@ -122,7 +271,14 @@ vfs_node_t *vfs_lookup(const char *path) {
     return current;
 }
 
-vfs_node_t *vfs_create(const char *path, vfs_node_type_t type) {
+vfs_node_t *vfs_lookup(const char *path) {
+    rwlock_read_lock(&tree_lock);
+    vfs_node_t *node = vfs_lookup_locked(path);
+    rwlock_read_unlock(&tree_lock);
+    return node;
+}
+
+static vfs_node_t *create_locked(const char *path, vfs_node_type_t type) {
     if (path == NULL || path[0] != '/')
         return NULL;
 
@@ -148,35 +304,53 @@ vfs_node_t *vfs_create(const char *path, vfs_node_type_t type) {
     if (name[0] == '\0')
         return NULL;
 
-    vfs_node_t *parent = vfs_lookup(parent_path);
+    vfs_node_t *parent = vfs_lookup_locked(parent_path);
     if (parent == NULL || parent->type != VFS_DIRECTORY) {
         return NULL;
     }
 
-    if (find_child(parent, name) != NULL) {
+    if (lookup_child(parent, name) != NULL) {
         return NULL;
     }
 
+    vfs_node_t *node;
     if (parent->ops && parent->ops->create) {
-        return parent->ops->create(parent, name, type);
+        node = parent->ops->create(parent, name, type);
+    } else {
+        node = vfs_node_alloc(name, type, parent->ops);
+        if (node != NULL)
+            add_child(parent, node);
     }
 
-    vfs_node_t *node = (vfs_node_t *)malloc(sizeof(vfs_node_t));
-    memset(node, 0, sizeof(vfs_node_t));
-    strcpy(node->name, name);
-    node->type = type;
-    node->ops = parent->ops;
+    if (node != NULL)
+        dcache_insert(parent, name, node);
+    else
+        dcache_invalidate(parent, name);
 
-    add_child(parent, node);
+    return node;
+}
 
+vfs_node_t *vfs_create(const char *path, vfs_node_type_t type) {
+    rwlock_write_lock(&tree_lock);
+    vfs_node_t *node = create_locked(path, type);
+    rwlock_write_unlock(&tree_lock);
     return node;
 }
 
-int vfs_unlink(const char *path, bool recursive) {
-    vfs_node_t *node = vfs_lookup(path);
+int vfs_mknod(const char *path, vfs_node_type_t type, uint64_t *ino) {
+    rwlock_write_lock(&tree_lock);
+    vfs_node_t *node = create_locked(path, type);
+    if (node != NULL && ino != NULL)
+        *ino = node_ino(node);
+    rwlock_write_unlock(&tree_lock);
+    return node != NULL ? 0 : -1;
+}
+
+static int unlink_locked(const char *path, bool recursive) {
+    vfs_node_t *node = vfs_lookup_locked(path);
     if (node == NULL)
         return -1;
-    if (node == root_node)
+    if (node == root_node || node_is_open(node))
         return -1;
 
     if (node->type == VFS_DIRECTORY) {
@@ -204,7 +378,7 @@ int vfs_unlink(const char *path, bool recursive) {
                 memcpy(child_path + path_len, child->name, name_len);
                 child_path[path_len + name_len] = '\0';
 
-                int result = vfs_unlink(child_path, true);
+                int result = unlink_locked(child_path, true);
                 if (result < 0) {
                     return result;
                 }
@@ -219,99 +393,314 @@ int vfs_unlink(const char *path, bool recursive) {
             return res;
     }
 
+    detach_cursors(node);
+    dcache_invalidate(node->parent, node->name);
+    if (node->type == VFS_DIRECTORY)
+        dcache_purge_dir(node);
     remove_child(node->parent, node);
 
-    free(node);
+    vfs_node_free(node);
 
     return 0;
 }
 
-int vfs_open(const char *path, int flags) {
-    vfs_node_t *node = vfs_lookup(path);
+int vfs_unlink(const char *path, bool recursive) {
+    rwlock_write_lock(&tree_lock);
+    int ret = unlink_locked(path, recursive);
+    rwlock_write_unlock(&tree_lock);
+    return ret;
+}
+
+int vfs_stat(const char *path, vfs_stat_t *stat) {
+    rwlock_read_lock(&tree_lock);
+
+    vfs_node_t *node = vfs_lookup_locked(path);
+    if (node != NULL)
+        fill_stat(node, stat);
+
+    rwlock_read_unlock(&tree_lock);
+    return node ? 0 : -1;
+}
+
+int vfs_file_fstat(vfs_file_t *f, vfs_stat_t *stat) {
+    fill_stat(f->node, stat);
+    return 0;
+}
+
+vfs_file_t *vfs_file_open(const char *path, int flags) {
+    bool write = (flags & O_CREAT) != 0;
+    if (write)
+        rwlock_write_lock(&tree_lock);
+    else
+        rwlock_read_lock(&tree_lock);
 
+    vfs_node_t *node = vfs_lookup_locked(path);
     if (node == NULL && (flags & O_CREAT)) {
-        node = vfs_create(path, VFS_FILE);
+        node = create_locked(path, VFS_FILE);
     }
 
-    if (node == NULL)
-        return -1;
-    if (node->type == VFS_DIRECTORY && (flags & (O_WRONLY | O_RDWR))) {
-        return -1;
+    vfs_file_t *file = NULL;
+    if (node != NULL && !(node->type == VFS_DIRECTORY && (flags & (O_WRONLY | O_RDWR)))) {
+        if (flags & O_TRUNC) {
+            node_truncate(node, 0);
+        }
+        file = vfs_file_alloc(node, flags, NULL, NULL);
     }
 
-    if ((flags & O_TRUNC) && node->ops && node->ops->truncate) {
-        node->ops->truncate(node, 0);
+    if (write)
+        rwlock_write_unlock(&tree_lock);
+    else
+        rwlock_read_unlock(&tree_lock);
+    return file;
+}
+
+vfs_file_t *vfs_file_alloc(vfs_node_t *node, int flags, const vfs_file_ops_t *fops, void *private) {
+    vfs_file_t *file = (vfs_file_t *)malloc(sizeof(vfs_file_t));
+    if (file == NULL) {
+        printkf_error("vfs_file_alloc(): failed to allocate file\n");
+        return NULL;
     }
+    memset(file, 0, sizeof(vfs_file_t));
+
+    file->node = node;
+    file->flags = flags & ~O_CLOEXEC;
+    file->offset = (flags & O_APPEND) ? node->inode->size : 0;
+    file->dir_cursor = node->type == VFS_DIRECTORY ? node->children : NULL;
+    file->fops = fops;
+    file->private = private;
+    file->refcount = 1;
+
+    uint64_t irq = spin_lock(&open_files_lock);
+    file->next_open = open_files;
+    if (open_files != NULL)
+        open_files->prev_open = file;
+    open_files = file;
+    spin_unlock(&open_files_lock, irq);
+
+    return file;
+}
 
-    int fd = alloc_fd();
-    if (fd < 0)
-        return -1;
+void vfs_file_get(vfs_file_t *file) {
+    __atomic_fetch_add(&file->refcount, 1, __ATOMIC_RELAXED);
+}
 
-    fd_table[fd].node = node;
-    fd_table[fd].flags = flags;
-    fd_table[fd].offset = (flags & O_APPEND) ? node->size : 0;
+void vfs_file_put(vfs_file_t *file) {
+    if (__atomic_sub_fetch(&file->refcount, 1, __ATOMIC_ACQ_REL) != 0)
+        return;
 
-    return fd;
+    uint64_t irq = spin_lock(&open_files_lock);
+    if (file->prev_open != NULL)
+        file->prev_open->next_open = file->next_open;
+    else
+        open_files = file->next_open;
+    if (file->next_open != NULL)
+        file->next_open->prev_open = file->prev_open;
+    spin_unlock(&open_files_lock, irq);
+
+    if (file->fops && file->fops->release)
+        file->fops->release(file);
+    else if (file->fops == NULL && file->node->inode->mapping != NULL)
+        page_cache_sync(file->node);
+
+    free(file);
 }
 
-int vfs_close(int fd) {
-    file_descriptor_t *f = get_fd(fd);
-    if (f == NULL)
-        return -1;
+static bool file_readable(vfs_file_t *f) {
+    if (f->node->type == VFS_DIRECTORY)
+        return false;
+    if ((f->flags & O_WRONLY))
+        return false;
+    return true;
+}
+
+static bool file_writable(vfs_file_t *f) {
+    if (f->node->type == VFS_DIRECTORY)
+        return false;
+    if ((f->flags & O_RDONLY) && !(f->flags & O_RDWR))
+        return false;
+    return true;
+}
 
-    f->in_use = false;
-    f->node = NULL;
+static int check_iov(const vfs_iovec_t *iov, int iovcnt) {
+    if (iov == NULL || iovcnt <= 0 || iovcnt > VFS_IOV_MAX)
+        return -1;
 
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].len > (SIZE_MAX >> 1) - total)
+            return -1;
+        total += iov[i].len;
+    }
     return 0;
 }
 
-int64_t vfs_read(int fd, void *buf, size_t size) {
-    file_descriptor_t *f = get_fd(fd);
-    if (f == NULL)
+static int64_t node_readv(vfs_file_t *f, const vfs_iovec_t *iov, int iovcnt, size_t offset) {
+    vfs_node_t *node = f->node;
+    if (node->ops == NULL)
         return -1;
-    if (f->node->type == VFS_DIRECTORY)
+    if (node->ops->readv && !node->ops->readpage)
+        return node->ops->readv(node, iov, iovcnt, offset);
+
+    int64_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].len == 0)
+            continue;
+
+        int64_t bytes = node_read(f, iov[i].base, iov[i].len, offset + total);
+        if (bytes < 0)
+            return total > 0 ? total : -1;
+
+        total += bytes;
+        if ((size_t)bytes < iov[i].len)
+            break;
+    }
+
+    return total;
+}
+
+static int64_t node_writev(vfs_node_t *node, const vfs_iovec_t *iov, int iovcnt, size_t offset) {
+    if (node->ops == NULL)
         return -1;
-    if ((f->flags & O_WRONLY))
+    if (node->ops->writev && !node->ops->writepage)
+        return node->ops->writev(node, iov, iovcnt, offset);
+
+    int64_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].len == 0)
+            continue;
+
+        int64_t bytes = node_write(node, iov[i].base, iov[i].len, offset + total);
+        if (bytes < 0)
+            return total > 0 ? total : -1;
+
+        total += bytes;
+        if ((size_t)bytes < iov[i].len)
+            break;
+    }
+
+    return total;
+}
+
+static int64_t file_ops_readv(vfs_file_t *f, const vfs_iovec_t *iov, int iovcnt) {
+    if (f->fops->read == NULL)
         return -1;
 
-    if (f->node->ops && f->node->ops->read) {
-        int64_t bytes = f->node->ops->read(f->node, buf, size, f->offset);
-        if (bytes > 0) {
-            f->offset += bytes;
-        }
-        return bytes;
+    int64_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].len == 0)
+            continue;
+
+        int64_t bytes = f->fops->read(f, iov[i].base, iov[i].len);
+        if (bytes < 0)
+            return total > 0 ? total : -1;
+
+        total += bytes;
+        if ((size_t)bytes < iov[i].len)
+            break;
     }
 
-    return -1;
+    return total;
 }
 
-int64_t vfs_write(int fd, const void *buf, size_t size) {
-    file_descriptor_t *f = get_fd(fd);
-    if (f == NULL)
+static int64_t file_ops_writev(vfs_file_t *f, const vfs_iovec_t *iov, int iovcnt) {
+    if (f->fops->write == NULL)
         return -1;
-    if (f->node->type == VFS_DIRECTORY)
+
+    int64_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].len == 0)
+            continue;
+
+        int64_t bytes = f->fops->write(f, iov[i].base, iov[i].len);
+        if (bytes < 0)
+            return total > 0 ? total : -1;
+
+        total += bytes;
+        if ((size_t)bytes < iov[i].len)
+            break;
+    }
+
+    return total;
+}
+
+int64_t vfs_file_read(vfs_file_t *f, void *buf, size_t size) {
+    if (!file_readable(f))
         return -1;
-    if ((f->flags & O_RDONLY) && !(f->flags & O_RDWR))
+
+    if (f->fops)
+        return f->fops->read ? f->fops->read(f, buf, size) : -1;
+
+    int64_t bytes = node_read(f, buf, size, f->offset);
+    if (bytes > 0) {
+        f->offset += bytes;
+    }
+    return bytes;
+}
+
+int64_t vfs_file_write(vfs_file_t *f, const void *buf, size_t size) {
+    if (!file_writable(f))
         return -1;
 
+    if (f->fops)
+        return f->fops->write ? f->fops->write(f, buf, size) : -1;
+
     if (f->flags & O_APPEND) {
-        f->offset = f->node->size;
+        f->offset = f->node->inode->size;
     }
 
-    if (f->node->ops && f->node->ops->write) {
-        int64_t bytes = f->node->ops->write(f->node, buf, size, f->offset);
-        if (bytes > 0) {
-            f->offset += bytes;
-        }
-        return bytes;
+    int64_t bytes = node_write(f->node, buf, size, f->offset);
+    if (bytes > 0) {
+        f->offset += bytes;
     }
+    return bytes;
+}
 
-    return -1;
+int64_t vfs_file_pread(vfs_file_t *f, void *buf, size_t size, size_t offset) {
+    if (!file_readable(f) || f->fops)
+        return -1;
+
+    return node_read(f, buf, size, offset);
 }
 
-int64_t vfs_seek(int fd, int64_t offset, int whence) {
-    file_descriptor_t *f = get_fd(fd);
-    if (f == NULL)
+int64_t vfs_file_pwrite(vfs_file_t *f, const void *buf, size_t size, size_t offset) {
+    if (!file_writable(f) || f->fops)
+        return -1;
+
+    return node_write(f->node, buf, size, offset);
+}
+
+int64_t vfs_file_readv(vfs_file_t *f, const vfs_iovec_t *iov, int iovcnt) {
+    if (!file_readable(f) || check_iov(iov, iovcnt) < 0)
+        return -1;
+
+    if (f->fops)
+        return file_ops_readv(f, iov, iovcnt);
+
+    int64_t bytes = node_readv(f, iov, iovcnt, f->offset);
+    if (bytes > 0)
+        f->offset += bytes;
+    return bytes;
+}
+
+int64_t vfs_file_writev(vfs_file_t *f, const vfs_iovec_t *iov, int iovcnt) {
+    if (!file_writable(f) || check_iov(iov, iovcnt) < 0)
+        return -1;
+
+    if (f->fops)
+        return file_ops_writev(f, iov, iovcnt);
+
+    if (f->flags & O_APPEND) {
+        f->offset = f->node->inode->size;
+    }
+
+    int64_t bytes = node_writev(f->node, iov, iovcnt, f->offset);
+    if (bytes > 0)
+        f->offset += bytes;
+    return bytes;
+}
+
+int64_t vfs_file_seek(vfs_file_t *f, int64_t offset, int whence) {
+    if (f->fops)
         return -1;
 
     int64_t new_offset;
@@ -323,7 +712,7 @@ int64_t vfs_seek(int fd, int64_t offset, int whence) {
         new_offset = f->offset + offset;
         break;
     case SEEK_END:
-        new_offset = f->node->size + offset;
+        new_offset = f->node->inode->size + offset;
         break;
     default:
         return -1;
@@ -332,38 +721,154 @@ int64_t vfs_seek(int fd, int64_t offset, int whence) {
     if (new_offset < 0)
         return -1;
 
+    if (f->node->type == VFS_DIRECTORY) {
+        rwlock_read_lock(&tree_lock);
+        vfs_node_t *child = f->node->children;
+        for (int64_t i = 0; child != NULL && i < new_offset; i++) {
+            child = child->next;
+        }
+        f->dir_cursor = child;
+        rwlock_read_unlock(&tree_lock);
+    }
+
     f->offset = new_offset;
     return new_offset;
 }
 
-int64_t vfs_tell(int fd) {
-    file_descriptor_t *f = get_fd(fd);
-    if (f == NULL)
-        return -1;
+int64_t vfs_file_tell(vfs_file_t *f) {
     return f->offset;
 }
 
+int vfs_file_truncate(vfs_file_t *f, size_t size) {
+    if (f->fops)
+        return f->fops->truncate ? f->fops->truncate(f, size) : -1;
+
+    if (!file_writable(f))
+        return -1;
+    return node_truncate(f->node, size);
+}
+
+uint32_t vfs_file_poll(vfs_file_t *f, poll_table_t *pt) {
+    if (f->fops && f->fops->poll)
+        return f->fops->poll(f, pt);
+    return POLLIN | POLLOUT;
+}
+
+static int64_t copy_write(vfs_file_t *out, const void *buf, size_t size, size_t offset) {
+    if (out->fops)
+        return out->fops->write ? out->fops->write(out, buf, size) : -1;
+    return node_write(out->node, buf, size, offset);
+}
+
+int64_t vfs_file_copy_range(vfs_file_t *in, int64_t *in_offset, vfs_file_t *out, int64_t *out_offset, size_t size) {
+    if (!file_readable(in) || !file_writable(out) || in->fops)
+        return -1;
+    if (in->node->ops == NULL)
+        return -1;
+    if (out->fops && out_offset != NULL)
+        return -1;
+    if (!out->fops && out->node->ops == NULL)
+        return -1;
+    if (in->node == out->node)
+        return -1;
+    if ((in_offset != NULL && *in_offset < 0) || (out_offset != NULL && *out_offset < 0))
+        return -1;
+
+    size_t in_pos = in_offset ? (size_t)*in_offset : in->offset;
+    size_t out_pos = 0;
+    if (!out->fops) {
+        if (out_offset != NULL)
+            out_pos = (size_t)*out_offset;
+        else if (out->flags & O_APPEND)
+            out_pos = out->node->inode->size;
+        else
+            out_pos = out->offset;
+    }
+
+    int64_t total = 0;
+
+    vfs_ops_t *ops = in->node->ops;
+    if (!out->fops && out->node->ops == ops && ops->copy_range) {
+        if (ops->readpage && (page_cache_sync(in->node) < 0 || page_cache_sync(out->node) < 0))
+            return -1;
+
+        total = ops->copy_range(in->node, in_pos, out->node, out_pos, size);
+        if (total < 0)
+            return -1;
+
+        if (ops->readpage && total > 0)
+            page_cache_invalidate(out->node, out_pos);
+    }
+
+    void *page = NULL;
+    if ((size_t)total < size) {
+        page = pfallocator_request_page();
+        if (page == NULL) {
+            printkf_error("vfs_file_copy_range(): failed to allocate bounce page\n");
+            if (total == 0)
+                return -1;
+        }
+    }
+
+    while (page != NULL && (size_t)total < size) {
+        size_t chunk = size - total;
+        if (chunk > PAGE_SIZE)
+            chunk = PAGE_SIZE;
+
+        int64_t bytes = node_read(in, page, chunk, in_pos + total);
+        if (bytes <= 0) {
+            if (bytes < 0 && total == 0)
+                total = -1;
+            break;
+        }
+
+        int64_t written = copy_write(out, page, bytes, out_pos + total);
+        if (written <= 0) {
+            if (total == 0)
+                total = -1;
+            break;
+        }
+
+        total += written;
+        if (written < bytes)
+            break;
+    }
+
+    if (page != NULL)
+        pfallocator_free_page(page);
+
+    if (total <= 0)
+        return total;
+
+    if (in_offset)
+        *in_offset += total;
+    else
+        in->offset += total;
+
+    if (!out->fops) {
+        if (out_offset)
+            *out_offset += total;
+        else
+            out->offset = out_pos + total;
+    }
+
+    return total;
+}
+
 int vfs_mkdir(const char *path) {
     vfs_node_t *node = vfs_create(path, VFS_DIRECTORY);
     return node ? 0 : -1;
 }
 
-int vfs_readdir(int fd, char *name, size_t name_size) {
-    file_descriptor_t *f = get_fd(fd);
-    if (f == NULL)
-        return -1;
+int vfs_file_readdir(vfs_file_t *f, char *name, size_t name_size) {
     if (f->node->type != VFS_DIRECTORY)
         return -1;
 
-    vfs_node_t *child = f->node->children;
-    size_t idx = 0;
-
-    while (child != NULL && idx < f->offset) {
-        child = child->next;
-        idx++;
-    }
+    rwlock_read_lock(&tree_lock);
 
+    vfs_node_t *child = f->dir_cursor;
     if (child == NULL) {
+        rwlock_read_unlock(&tree_lock);
         return 0;
     }
 
@@ -373,7 +878,240 @@ int vfs_readdir(int fd, char *name, size_t name_size) {
     memcpy(name, child->name, len);
     name[len] = '\0';
 
+    f->dir_cursor = child->next;
     f->offset++;
 
+    rwlock_read_unlock(&tree_lock);
     return 1;
 }
+
+int64_t vfs_file_getdents(vfs_file_t *f, void *buf, size_t size) {
+    if (f->node->type != VFS_DIRECTORY)
+        return -1;
+
+    uint8_t *out = (uint8_t *)buf;
+    size_t used = 0;
+
+    rwlock_read_lock(&tree_lock);
+
+    while (f->dir_cursor != NULL) {
+        vfs_node_t *child = f->dir_cursor;
+        size_t namelen = strlen(child->name);
+        size_t reclen = (sizeof(vfs_dirent_t) + namelen + 1 + 7) & ~(size_t)7;
+
+        if (used + reclen > size) {
+            if (used == 0) {
+                rwlock_read_unlock(&tree_lock);
+                return -1;
+            }
+            break;
+        }
+
+        vfs_dirent_t *dirent = (vfs_dirent_t *)(out + used);
+        dirent->ino = node_ino(child);
+        dirent->size = child->inode->size;
+        dirent->reclen = reclen;
+        dirent->type = child->type;
+        dirent->namelen = namelen;
+        memcpy(dirent->name, child->name, namelen + 1);
+
+        used += reclen;
+        f->dir_cursor = child->next;
+        f->offset++;
+    }
+
+    rwlock_read_unlock(&tree_lock);
+    return used;
+}
+
+static fd_table_t *current_fds() {
+    task_t *current = task_current();
+    return current ? current->fds : NULL;
+}
+
+int vfs_open(const char *path, int flags) {
+    fd_table_t *table = current_fds();
+    if (table == NULL)
+        return -1;
+
+    vfs_file_t *file = vfs_file_open(path, flags);
+    if (file == NULL)
+        return -1;
+
+    int fd = fd_install(table, file, (flags & O_CLOEXEC) != 0);
+    if (fd < 0)
+        vfs_file_put(file);
+    return fd;
+}
+
+int vfs_close(int fd) {
+    fd_table_t *table = current_fds();
+    if (table == NULL)
+        return -1;
+    return fd_close(table, fd);
+}
+
+static vfs_file_t *get_file(int fd) {
+    fd_table_t *table = current_fds();
+    if (table == NULL)
+        return NULL;
+    return fd_get(table, fd);
+}
+
+int64_t vfs_read(int fd, void *buf, size_t size) {
+    vfs_file_t *file = get_file(fd);
+    if (file == NULL)
+        return -1;
+
+    int64_t ret = vfs_file_read(file, buf, size);
+    vfs_file_put(file);
+    return ret;
+}
+
+int64_t vfs_write(int fd, const void *buf, size_t size) {
+    vfs_file_t *file = get_file(fd);
+    if (file == NULL)
+        return -1;
+
+    int64_t ret = vfs_file_write(file, buf, size);
+    vfs_file_put(file);
+    return ret;
+}
+
+int64_t vfs_pread(int fd, void *buf, size_t size, size_t offset) {
+    vfs_file_t *file = get_file(fd);
+    if (file == NULL)
+        return -1;
+
+    int64_t ret = vfs_file_pread(file, buf, size, offset);
+    vfs_file_put(file);
+    return ret;
+}
+
+int64_t vfs_pwrite(int fd, const void *buf, size_t size, size_t offset) {
+    vfs_file_t *file = get_file(fd);
+    if (file == NULL)
+        return -1;
+
+    int64_t ret = vfs_file_pwrite(file, buf, size, offset);
+    vfs_file_put(file);
+    return ret;
+}
+
+int64_t vfs_readv(int fd, const vfs_iovec_t *iov, int iovcnt) {
+    vfs_file_t *file = get_file(fd);
+    if (file == NULL)
+        return -1;
+
+    int64_t ret = vfs_file_readv(file, iov, iovcnt);
+    vfs_file_put(file);
+    return ret;
+}
+
+int64_t vfs_writev(int fd, const vfs_iovec_t *iov, int iovcnt) {
+    vfs_file_t *file = get_file(fd);
+    if (file == NULL)
+        return -1;
+
+    int64_t ret = vfs_file_writev(file, iov, iovcnt);
+    vfs_file_put(file);
+    return ret;
+}
+
+int64_t vfs_seek(int fd, int64_t offset, int whence) {
+    vfs_file_t *file = get_file(fd);
+    if (file == NULL)
+        return -1;
+
+    int64_t ret = vfs_file_seek(file, offset, whence);
+    vfs_file_put(file);
+    return ret;
+}
+
+int64_t vfs_tell(int fd) {
+    vfs_file_t *file = get_file(fd);
+    if (file == NULL)
+        return -1;
+
+    int64_t ret = vfs_file_tell(file);
+    vfs_file_put(file);
+    return ret;
+}
+
+int vfs_ftruncate(int fd, size_t size) {
+    vfs_file_t *file = get_file(fd);
+    if (file == NULL)
+        return -1;
+
+    int ret = vfs_file_truncate(file, size);
+    vfs_file_put(file);
+    return ret;
+}
+
+int64_t vfs_copy_file_range(int fd_in, int64_t *off_in, int fd_out, int64_t *off_out, size_t size) {
+    vfs_file_t *in = get_file(fd_in);
+    if (in == NULL)
+        return -1;
+
+    vfs_file_t *out = get_file(fd_out);
+    if (out == NULL) {
+        vfs_file_put(in);
+        return -1;
+    }
+
+    int64_t ret = -1;
+    if (!out->fops)
+        ret = vfs_file_copy_range(in, off_in, out, off_out, size);
+
+    vfs_file_put(out);
+    vfs_file_put(in);
+    return ret;
+}
+
+int64_t vfs_sendfile(int out_fd, int in_fd, int64_t *offset, size_t count) {
+    vfs_file_t *in = get_file(in_fd);
+    if (in == NULL)
+        return -1;
+
+    vfs_file_t *out = get_file(out_fd);
+    if (out == NULL) {
+        vfs_file_put(in);
+        return -1;
+    }
+
+    int64_t ret = vfs_file_copy_range(in, offset, out, NULL, count);
+
+    vfs_file_put(out);
+    vfs_file_put(in);
+    return ret;
+}
+
+int vfs_readdir(int fd, char *name, size_t name_size) {
+    vfs_file_t *file = get_file(fd);
+    if (file == NULL)
+        return -1;
+
+    int ret = vfs_file_readdir(file, name, name_size);
+    vfs_file_put(file);
+    return ret;
+}
+
+int64_t vfs_getdents(int fd, void *buf, size_t size) {
+    vfs_file_t *file = get_file(fd);
+    if (file == NULL)
+        return -1;
+
+    int64_t ret = vfs_file_getdents(file, buf, size);
+    vfs_file_put(file);
+    return ret;
+}
+
+int vfs_fstat(int fd, vfs_stat_t *stat) {
+    vfs_file_t *file = get_file(fd);
+    if (file == NULL)
+        return -1;
+
+    int ret = vfs_file_fstat(file, stat);
+    vfs_file_put(file);
+    return ret;
+}
@@ -5,11 +5,21 @@
 #include <stdint.h>
 
 typedef struct vfs_node vfs_node_t;
+typedef struct vfs_inode vfs_inode_t;
 typedef struct vfs_ops vfs_ops_t;
+typedef struct vfs_file vfs_file_t;
+typedef struct vfs_file_ops vfs_file_ops_t;
+
+struct poll_table;
+struct address_space;
 
 typedef enum {
     VFS_FILE,
     VFS_DIRECTORY,
+    VFS_PIPE,
+    VFS_SHM,
+    VFS_SOCKET,
+    VFS_EPOLL,
 } vfs_node_type_t;
 
 #define O_RDONLY 0x0000
@@ -18,57 +28,156 @@ typedef enum {
 #define O_CREAT 0x0040
 #define O_TRUNC 0x0200
 #define O_APPEND 0x0400
+#define O_NONBLOCK 0x0800
+#define O_CLOEXEC 0x80000
 
 #define SEEK_SET 0
 #define SEEK_CUR 1
 #define SEEK_END 2
 
 #define VFS_MAX_NAME 256
+#define VFS_NAME_INLINE 32
 #define VFS_MAX_PATH 4096
+#define VFS_IOV_MAX 64
 
-struct vfs_node {
-    char name[VFS_MAX_NAME];
-    vfs_node_type_t type;
-    uint64_t size;
-
-    vfs_node_t *parent;
-    vfs_node_t *children;
-    vfs_node_t *next;
+typedef struct {
+    void *base;
+    size_t len;
+} vfs_iovec_t;
 
+struct vfs_inode {
+    uint64_t size;
+    uint64_t ino;
     void *data;
+    struct address_space *mapping;
+    volatile uint32_t links;
+};
 
+struct vfs_node {
+    vfs_node_t *next;
+    const char *name;
+    vfs_node_t *children;
+    vfs_node_t *parent;
+    vfs_node_type_t type;
     vfs_ops_t *ops;
+    vfs_inode_t *inode;
+
+    char name_inline[VFS_NAME_INLINE];
 };
 
 struct vfs_ops {
     int64_t (*read)(vfs_node_t *node, void *buf, size_t size, size_t offset);
     int64_t (*write)(vfs_node_t *node, const void *buf, size_t size, size_t offset);
+    int64_t (*readv)(vfs_node_t *node, const vfs_iovec_t *iov, int iovcnt, size_t offset);
+    int64_t (*writev)(vfs_node_t *node, const vfs_iovec_t *iov, int iovcnt, size_t offset);
     vfs_node_t *(*create)(vfs_node_t *parent, const char *name, vfs_node_type_t type);
     int (*unlink)(vfs_node_t *node);
     int (*truncate)(vfs_node_t *node, size_t size);
+    int64_t (*copy_range)(vfs_node_t *src, size_t src_offset, vfs_node_t *dst, size_t dst_offset, size_t size);
+    int (*readpage)(vfs_node_t *node, uint64_t index, void *page);
+    int (*writepage)(vfs_node_t *node, uint64_t index, const void *page, size_t len);
+    int (*sync)(vfs_node_t *node);
+};
+
+struct vfs_file_ops {
+    int64_t (*read)(vfs_file_t *file, void *buf, size_t size);
+    int64_t (*write)(vfs_file_t *file, const void *buf, size_t size);
+    int (*truncate)(vfs_file_t *file, size_t size);
+    uint32_t (*poll)(vfs_file_t *file, struct poll_table *pt);
+    void (*release)(vfs_file_t *file);
 };
 
 typedef struct {
+    uint64_t start;
+    uint64_t prev_index;
+    uint32_t size;
+} vfs_readahead_t;
+
+struct vfs_file {
     vfs_node_t *node;
     int flags;
     size_t offset;
-    bool in_use;
-} file_descriptor_t;
+    vfs_node_t *dir_cursor;
+    const vfs_file_ops_t *fops;
+    void *private;
+    volatile uint32_t refcount;
+    vfs_readahead_t ra;
+    struct vfs_file *prev_open;
+    struct vfs_file *next_open;
+};
+
+typedef struct {
+    int64_t off_in;
+    int64_t off_out;
+    uint64_t len;
+} vfs_copy_range_t;
+
+typedef struct {
+    uint32_t type;
+    uint64_t size;
+    uint64_t ino;
+} vfs_stat_t;
+
+typedef struct {
+    uint64_t ino;
+    uint64_t size;
+    uint16_t reclen;
+    uint8_t type;
+    uint8_t namelen;
+    char name[];
+} vfs_dirent_t;
 
 void vfs_init();
 
+vfs_node_t *vfs_node_alloc(const char *name, vfs_node_type_t type, vfs_ops_t *ops);
+void vfs_node_init(vfs_node_t *node, vfs_inode_t *inode, const char *name, vfs_node_type_t type);
+void vfs_node_free(vfs_node_t *node);
+
 vfs_node_t *vfs_lookup(const char *path);
+vfs_node_t *vfs_lookup_locked(const char *path);
 vfs_node_t *vfs_create(const char *path, vfs_node_type_t type);
+int vfs_mknod(const char *path, vfs_node_type_t type, uint64_t *ino);
 int vfs_unlink(const char *path, bool recursive);
+int vfs_stat(const char *path, vfs_stat_t *stat);
+int vfs_fstat(int fd, vfs_stat_t *stat);
+
+vfs_file_t *vfs_file_alloc(vfs_node_t *node, int flags, const vfs_file_ops_t *fops, void *private);
+vfs_file_t *vfs_file_open(const char *path, int flags);
+void vfs_file_get(vfs_file_t *file);
+void vfs_file_put(vfs_file_t *file);
+int64_t vfs_file_read(vfs_file_t *file, void *buf, size_t size);
+int64_t vfs_file_write(vfs_file_t *file, const void *buf, size_t size);
+int64_t vfs_file_pread(vfs_file_t *file, void *buf, size_t size, size_t offset);
+int64_t vfs_file_pwrite(vfs_file_t *file, const void *buf, size_t size, size_t offset);
+int64_t vfs_file_readv(vfs_file_t *file, const vfs_iovec_t *iov, int iovcnt);
+int64_t vfs_file_writev(vfs_file_t *file, const vfs_iovec_t *iov, int iovcnt);
+int64_t vfs_file_seek(vfs_file_t *file, int64_t offset, int whence);
+int64_t vfs_file_tell(vfs_file_t *file);
+int vfs_file_readdir(vfs_file_t *file, char *name, size_t name_size);
+int64_t vfs_file_getdents(vfs_file_t *file, void *buf, size_t size);
+int vfs_file_fstat(vfs_file_t *file, vfs_stat_t *stat);
+int vfs_file_truncate(vfs_file_t *file, size_t size);
+uint32_t vfs_file_poll(vfs_file_t *file, struct poll_table *pt);
+int64_t vfs_file_copy_range(vfs_file_t *in, int64_t *in_offset, vfs_file_t *out, int64_t *out_offset, size_t size);
 
 int vfs_open(const char *path, int flags);
 int vfs_close(int fd);
 int64_t vfs_read(int fd, void *buf, size_t size);
 int64_t vfs_write(int fd, const void *buf, size_t size);
+int64_t vfs_pread(int fd, void *buf, size_t size, size_t offset);
+int64_t vfs_pwrite(int fd, const void *buf, size_t size, size_t offset);
+int64_t vfs_readv(int fd, const vfs_iovec_t *iov, int iovcnt);
+int64_t vfs_writev(int fd, const vfs_iovec_t *iov, int iovcnt);
 int64_t vfs_seek(int fd, int64_t offset, int whence);
 int64_t vfs_tell(int fd);
+int vfs_ftruncate(int fd, size_t size);
+int64_t vfs_copy_file_range(int fd_in, int64_t *off_in, int fd_out, int64_t *off_out, size_t size);
+int64_t vfs_sendfile(int out_fd, int in_fd, int64_t *offset, size_t count);
 
 int vfs_mkdir(const char *path);
 int vfs_readdir(int fd, char *name, size_t name_size);
+int64_t vfs_getdents(int fd, void *buf, size_t size);
 
 vfs_node_t *vfs_root();
+void vfs_lock_tree();
+void vfs_unlock_tree();
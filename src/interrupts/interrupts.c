@@ -1,6 +1,10 @@
 #include "interrupts.h"
 
+#include "../arch/x86_64/cpu/cpu.h"
+#include "../arch/x86_64/fpu/fpu.h"
+#include "../drivers/apic/lapic.h"
 #include "../drivers/keyboard/keyboard.h"
+#include "../drivers/nvme/nvme.h"
 #include "../drivers/pic/pic.h"
 #include "../drivers/timer/pit.h"
 #include "../io/io.h"
@@ -11,11 +15,14 @@
 #include "../task/task.h"
 
 __attribute__((interrupt)) void page_fault_handler(struct interrupt_frame *frame, uint64_t error_code) {
+    interrupt_enter(frame);
+
     uint64_t fault_addr;
     __asm__ volatile("mov %%cr2, %0" : "=r"(fault_addr));
 
     if ((error_code & 0x7) == 0x7) {
         if (page_handle_cow_fault((void *)fault_addr)) {
+            interrupt_leave(frame);
             return;
         }
     }
@@ -41,9 +48,11 @@ __attribute__((interrupt)) void gp_fault_handler(struct interrupt_frame *frame,
 }
 
 __attribute__((interrupt)) void irq0_handler(struct interrupt_frame *frame) {
-    (void)frame;
+    interrupt_enter(frame);
     outb(PIC1_COMMAND, PIC_EOI);
+    cpu_current()->tick_from_user = frame->cs & 3;
     pit_interrupt_handler();
+    interrupt_leave(frame);
 }
 
 idtr_t _g_idtr;
@@ -65,12 +74,22 @@ void interrupts_init() {
     add_idt_entry((uint64_t)page_fault_handler, 0x0e, IDT_INTERRUPT_GATE, 0x08);
     add_idt_entry((uint64_t)double_fault_handler, 0x08, IDT_INTERRUPT_GATE, 0x08);
     add_idt_entry((uint64_t)gp_fault_handler, 0x0d, IDT_INTERRUPT_GATE, 0x08);
+    add_idt_entry((uint64_t)fpu_nm_handler, FPU_NM_VECTOR, IDT_INTERRUPT_GATE, 0x08);
 
     add_idt_entry((uint64_t)keyboard_handler, 0x21, IDT_INTERRUPT_GATE, 0x08);
+    add_idt_entry((uint64_t)nvme_irq_handler, NVME_IRQ_VECTOR, IDT_INTERRUPT_GATE, 0x08);
 
     add_idt_entry((uint64_t)irq0_handler, 0x20, IDT_INTERRUPT_GATE, 0x08);
 
+    add_idt_entry((uint64_t)lapic_timer_handler, LAPIC_TIMER_VECTOR, IDT_INTERRUPT_GATE, 0x08);
+    add_idt_entry((uint64_t)lapic_ipi_handler, LAPIC_IPI_VECTOR, IDT_INTERRUPT_GATE, 0x08);
+    add_idt_entry((uint64_t)lapic_spurious_handler, LAPIC_SPURIOUS_VECTOR, IDT_INTERRUPT_GATE, 0x08);
+
     printkf_info("Loading IDT...\n");
-    __asm__("lidt %0" : : "m"(_g_idtr));
+    interrupts_load();
     printkf_info("IDT Loaded\n");
 }
+
+void interrupts_load() {
+    __asm__("lidt %0" : : "m"(_g_idtr));
+}
@@ -11,6 +11,20 @@ struct interrupt_frame {
 };
 
 void interrupts_init();
+void interrupts_load();
+
+static inline void interrupt_enter(struct interrupt_frame *frame) {
+    if (frame->cs & 3) {
+        __asm__ volatile("swapgs" ::: "memory");
+    }
+}
+
+static inline void interrupt_leave(struct interrupt_frame *frame) {
+    __asm__ volatile("cli" ::: "memory");
+    if (frame->cs & 3) {
+        __asm__ volatile("swapgs" ::: "memory");
+    }
+}
 
 static inline void sti() {
     __asm__ volatile("sti");
@@ -0,0 +1,345 @@
+#include "pipe.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../arch/x86_64/tlb/tlb.h"
+#include "../fs/vfs/fdtable.h"
+#include "../fs/vfs/vfs.h"
+#include "../io/terminal.h"
+#include "../mem/alloc/heap.h"
+#include "../mem/alloc/page_frame_alloc.h"
+#include "../mem/paging/paging.h"
+#include "../std/string.h"
+#include "../sync/mutex.h"
+#include "../sync/waitqueue.h"
+#include "../task/task.h"
+#include "poll.h"
+
+#define USER_SPACE_END 0x800000000000ULL
+
+typedef struct {
+    uint8_t *page;
+    uint32_t offset;
+    uint32_t len;
+} pipe_buffer_t;
+
+struct pipe {
+    mutex_t lock;
+    wait_queue_t read_wq;
+    wait_queue_t write_wq;
+
+    pipe_buffer_t bufs[PIPE_BUFFERS];
+    uint32_t head;
+    volatile uint32_t count;
+
+    volatile uint32_t readers;
+    volatile uint32_t writers;
+    volatile uint32_t ends;
+
+    vfs_node_t node;
+    vfs_inode_t inode;
+};
+
+static int64_t pipe_read(vfs_file_t *file, void *buf, size_t size);
+static int64_t pipe_write(vfs_file_t *file, const void *buf, size_t size);
+static uint32_t pipe_poll(vfs_file_t *file, poll_table_t *pt);
+static void pipe_release(vfs_file_t *file);
+
+static const vfs_file_ops_t pipe_read_fops = {
+    .read = pipe_read,
+    .poll = pipe_poll,
+    .release = pipe_release,
+};
+
+static const vfs_file_ops_t pipe_write_fops = {
+    .write = pipe_write,
+    .poll = pipe_poll,
+    .release = pipe_release,
+};
+
+static pipe_buffer_t *pipe_tail(pipe_t *pipe) {
+    return &pipe->bufs[(pipe->head + pipe->count - 1) % PIPE_BUFFERS];
+}
+
+static bool pipe_full(pipe_t *pipe) {
+    if (pipe->count < PIPE_BUFFERS)
+        return false;
+
+    pipe_buffer_t *tail = pipe_tail(pipe);
+    return tail->offset + tail->len == PAGE_SIZE;
+}
+
+static void *pipe_steal_page(const void *addr) {
+    task_t *current = task_current();
+
+    if (!current->is_user || task_has_threads(current))
+        return NULL;
+    if ((uint64_t)addr & (PAGE_SIZE - 1) || (uint64_t)addr >= USER_SPACE_END)
+        return NULL;
+    if ((uint64_t)addr >= current->user_stack_virt &&
+        (uint64_t)addr < current->user_stack_virt + current->user_stack_size)
+        return NULL;
+
+    page_direntry_t *pte = page_table_get_pte(current->page_table, (void *)addr);
+    if (pte == NULL || !page_direntry_get_flag(pte, PAGE_PRESENT) || !page_direntry_get_flag(pte, PAGE_USER_SUPER))
+        return NULL;
+    if (page_direntry_get_flag(pte, PAGE_SHARED))
+        return NULL;
+
+    void *page = (void *)((page_direntry_get_address(pte) << 12) + page_get_offset());
+    pfallocator_ref_page(page);
+
+    if (page_direntry_get_flag(pte, PAGE_READ_WRITE)) {
+        page_direntry_set_flag(pte, PAGE_READ_WRITE, false);
+        page_direntry_set_flag(pte, PAGE_COW, true);
+        tlb_shootdown(current->page_table, (void *)addr);
+    }
+
+    return page;
+}
+
+static int64_t pipe_fill(pipe_t *pipe, const uint8_t *src, size_t size) {
+    if (pipe->count > 0) {
+        pipe_buffer_t *tail = pipe_tail(pipe);
+        uint32_t end = tail->offset + tail->len;
+        if (end < PAGE_SIZE) {
+            size_t n = size < PAGE_SIZE - end ? size : PAGE_SIZE - end;
+            memcpy(tail->page + end, src, n);
+            tail->len += n;
+            return n;
+        }
+    }
+
+    if (pipe->count == PIPE_BUFFERS)
+        return 0;
+
+    pipe_buffer_t *buf = &pipe->bufs[(pipe->head + pipe->count) % PIPE_BUFFERS];
+
+    if (size >= PAGE_SIZE) {
+        void *page = pipe_steal_page(src);
+        if (page != NULL) {
+            buf->page = (uint8_t *)page;
+            buf->offset = 0;
+            buf->len = PAGE_SIZE;
+            pipe->count++;
+            return PAGE_SIZE;
+        }
+    }
+
+    void *page = pfallocator_request_page();
+    if (page == NULL) {
+        printkf_error("pipe_fill(): out of memory\n");
+        return -1;
+    }
+
+    size_t n = size < PAGE_SIZE ? size : PAGE_SIZE;
+    memcpy(page, src, n);
+    buf->page = (uint8_t *)page;
+    buf->offset = 0;
+    buf->len = n;
+    pipe->count++;
+    return n;
+}
+
+int64_t pipe_read_buffer(pipe_t *pipe, void *buf, size_t size, bool nonblock) {
+    uint8_t *dst = (uint8_t *)buf;
+
+    if (size == 0)
+        return 0;
+
+    mutex_lock(&pipe->lock);
+
+    while (pipe->count == 0) {
+        if (pipe->writers == 0) {
+            mutex_unlock(&pipe->lock);
+            return 0;
+        }
+        if (nonblock) {
+            mutex_unlock(&pipe->lock);
+            return -1;
+        }
+
+        mutex_unlock(&pipe->lock);
+        wait_event(&pipe->read_wq, pipe->count > 0 || pipe->writers == 0);
+        mutex_lock(&pipe->lock);
+    }
+
+    size_t copied = 0;
+    while (copied < size && pipe->count > 0) {
+        pipe_buffer_t *pb = &pipe->bufs[pipe->head];
+        size_t n = size - copied < pb->len ? size - copied : pb->len;
+
+        memcpy(dst + copied, pb->page + pb->offset, n);
+        pb->offset += n;
+        pb->len -= n;
+        copied += n;
+
+        if (pb->len == 0) {
+            pfallocator_unref_page(pb->page);
+            pb->page = NULL;
+            pb->offset = 0;
+            pipe->head = (pipe->head + 1) % PIPE_BUFFERS;
+            pipe->count--;
+        }
+    }
+
+    mutex_unlock(&pipe->lock);
+
+    wait_queue_wake_all(&pipe->write_wq);
+    return copied;
+}
+
+int64_t pipe_write_buffer(pipe_t *pipe, const void *buf, size_t size, bool nonblock) {
+    const uint8_t *src = (const uint8_t *)buf;
+    size_t written = 0;
+
+    mutex_lock(&pipe->lock);
+
+    while (written < size && pipe->readers > 0) {
+        if (pipe_full(pipe)) {
+            if (nonblock)
+                break;
+
+            mutex_unlock(&pipe->lock);
+            if (written > 0)
+                wait_queue_wake_all(&pipe->read_wq);
+            wait_event(&pipe->write_wq, !pipe_full(pipe) || pipe->readers == 0);
+            mutex_lock(&pipe->lock);
+            continue;
+        }
+
+        int64_t n = pipe_fill(pipe, src + written, size - written);
+        if (n < 0)
+            break;
+        written += n;
+    }
+
+    mutex_unlock(&pipe->lock);
+
+    if (written > 0)
+        wait_queue_wake_all(&pipe->read_wq);
+
+    if (written == 0 && size > 0)
+        return -1;
+    return written;
+}
+
+void pipe_close_end(pipe_t *pipe, bool reader) {
+    mutex_lock(&pipe->lock);
+    if (reader)
+        pipe->readers--;
+    else
+        pipe->writers--;
+    mutex_unlock(&pipe->lock);
+
+    wait_queue_wake_all(&pipe->read_wq);
+    wait_queue_wake_all(&pipe->write_wq);
+
+    if (__atomic_sub_fetch(&pipe->ends, 1, __ATOMIC_ACQ_REL) != 0)
+        return;
+
+    for (uint32_t i = 0; i < pipe->count; i++) {
+        pfallocator_unref_page(pipe->bufs[(pipe->head + i) % PIPE_BUFFERS].page);
+    }
+    free(pipe);
+}
+
+uint32_t pipe_poll_end(pipe_t *pipe, bool reader, poll_table_t *pt) {
+    uint32_t mask = 0;
+
+    if (reader) {
+        poll_wait(pt, &pipe->read_wq);
+        if (pipe->count > 0)
+            mask |= POLLIN;
+        if (pipe->writers == 0)
+            mask |= POLLHUP;
+    } else {
+        poll_wait(pt, &pipe->write_wq);
+        if (!pipe_full(pipe))
+            mask |= POLLOUT;
+        if (pipe->readers == 0)
+            mask |= POLLERR;
+    }
+
+    return mask;
+}
+
+pipe_t *pipe_alloc() {
+    pipe_t *pipe = (pipe_t *)malloc(sizeof(pipe_t));
+    if (pipe == NULL) {
+        printkf_error("pipe_alloc(): failed to allocate pipe\n");
+        return NULL;
+    }
+    memset(pipe, 0, sizeof(pipe_t));
+
+    mutex_init(&pipe->lock);
+    wait_queue_init(&pipe->read_wq);
+    wait_queue_init(&pipe->write_wq);
+    vfs_node_init(&pipe->node, &pipe->inode, "pipe", VFS_PIPE);
+    pipe->readers = 1;
+    pipe->writers = 1;
+    pipe->ends = 2;
+
+    return pipe;
+}
+
+static int64_t pipe_read(vfs_file_t *file, void *buf, size_t size) {
+    return pipe_read_buffer((pipe_t *)file->private, buf, size, (file->flags & O_NONBLOCK) != 0);
+}
+
+static int64_t pipe_write(vfs_file_t *file, const void *buf, size_t size) {
+    return pipe_write_buffer((pipe_t *)file->private, buf, size, (file->flags & O_NONBLOCK) != 0);
+}
+
+static uint32_t pipe_poll(vfs_file_t *file, poll_table_t *pt) {
+    return pipe_poll_end((pipe_t *)file->private, file->fops == &pipe_read_fops, pt);
+}
+
+static void pipe_release(vfs_file_t *file) {
+    pipe_close_end((pipe_t *)file->private, file->fops == &pipe_read_fops);
+}
+
+int pipe_create(int fds[2], int flags) {
+    task_t *current = task_current();
+    if (current->fds == NULL)
+        return -1;
+
+    pipe_t *pipe = pipe_alloc();
+    if (pipe == NULL)
+        return -1;
+
+    int file_flags = flags & O_NONBLOCK;
+    bool cloexec = (flags & O_CLOEXEC) != 0;
+
+    vfs_file_t *reader = vfs_file_alloc(&pipe->node, O_RDONLY | file_flags, &pipe_read_fops, pipe);
+    if (reader == NULL) {
+        free(pipe);
+        return -1;
+    }
+
+    vfs_file_t *writer = vfs_file_alloc(&pipe->node, O_WRONLY | file_flags, &pipe_write_fops, pipe);
+    if (writer == NULL) {
+        vfs_file_put(reader);
+        pipe_close_end(pipe, false);
+        return -1;
+    }
+
+    int rfd = fd_install(current->fds, reader, cloexec);
+    if (rfd < 0) {
+        vfs_file_put(reader);
+        vfs_file_put(writer);
+        return -1;
+    }
+
+    int wfd = fd_install(current->fds, writer, cloexec);
+    if (wfd < 0) {
+        fd_close(current->fds, rfd);
+        vfs_file_put(writer);
+        return -1;
+    }
+
+    fds[0] = rfd;
+    fds[1] = wfd;
+    return 0;
+}
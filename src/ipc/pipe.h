@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PIPE_BUFFERS 16
+
+typedef struct pipe pipe_t;
+
+struct poll_table;
+
+pipe_t *pipe_alloc();
+int64_t pipe_read_buffer(pipe_t *pipe, void *buf, size_t size, bool nonblock);
+int64_t pipe_write_buffer(pipe_t *pipe, const void *buf, size_t size, bool nonblock);
+void pipe_close_end(pipe_t *pipe, bool reader);
+uint32_t pipe_poll_end(pipe_t *pipe, bool reader, struct poll_table *pt);
+
+int pipe_create(int fds[2], int flags);
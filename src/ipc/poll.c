@@ -0,0 +1,441 @@
+#include "poll.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../drivers/keyboard/keyboard.h"
+#include "../fs/vfs/fdtable.h"
+#include "../fs/vfs/vfs.h"
+#include "../io/terminal.h"
+#include "../mem/alloc/heap.h"
+#include "../std/string.h"
+#include "../sync/mutex.h"
+#include "../sync/spinlock.h"
+#include "../task/task.h"
+
+typedef struct {
+    poll_table_t pt;
+    wait_queue_t wq;
+    volatile bool triggered;
+    uint32_t count;
+    wait_queue_entry_t entries[POLL_MAX_FDS * POLL_MAX_QUEUES];
+    wait_queue_t *queues[POLL_MAX_FDS * POLL_MAX_QUEUES];
+    vfs_file_t *files[POLL_MAX_FDS];
+} poll_waiter_t;
+
+typedef struct epoll_item {
+    struct epoll *ep;
+    int fd;
+    vfs_file_t *file;
+    uint32_t events;
+    uint64_t data;
+
+    uint32_t queue_count;
+    wait_queue_entry_t entries[POLL_MAX_QUEUES];
+    wait_queue_t *queues[POLL_MAX_QUEUES];
+
+    bool ready;
+    struct epoll_item *next;
+    struct epoll_item *ready_next;
+} epoll_item_t;
+
+typedef struct epoll {
+    mutex_t lock;
+    spinlock_t ready_lock;
+    epoll_item_t *items;
+    epoll_item_t *ready_head;
+    epoll_item_t *ready_tail;
+    wait_queue_t wq;
+    vfs_node_t node;
+    vfs_inode_t inode;
+} epoll_t;
+
+typedef struct {
+    poll_table_t pt;
+    epoll_item_t *item;
+} epoll_table_t;
+
+static uint32_t epoll_poll(vfs_file_t *file, poll_table_t *pt);
+static void epoll_release(vfs_file_t *file);
+
+static const vfs_file_ops_t epoll_fops = {
+    .poll = epoll_poll,
+    .release = epoll_release,
+};
+
+static uint32_t poll_target(vfs_file_t *file, int fd, poll_table_t *pt) {
+    if (file != NULL)
+        return vfs_file_poll(file, pt);
+
+    if (fd == 0) {
+        poll_wait(pt, keyboard_wait_queue());
+        return keyboard_haschar() ? POLLIN : 0;
+    }
+    return POLLOUT;
+}
+
+static vfs_file_t *poll_get_file(int fd, bool *valid) {
+    task_t *current = task_current();
+    vfs_file_t *file = current->fds != NULL ? fd_get(current->fds, fd) : NULL;
+
+    *valid = file != NULL || (fd >= 0 && fd < FD_FIRST);
+    return file;
+}
+
+static void poll_waiter_wake(wait_queue_entry_t *entry) {
+    poll_waiter_t *waiter = (poll_waiter_t *)entry->private;
+    waiter->triggered = true;
+    wait_queue_wake_all(&waiter->wq);
+}
+
+static void poll_waiter_queue(poll_table_t *pt, wait_queue_t *wq) {
+    poll_waiter_t *waiter = (poll_waiter_t *)pt;
+    if (waiter->count >= POLL_MAX_FDS * POLL_MAX_QUEUES)
+        return;
+
+    wait_queue_entry_t *entry = &waiter->entries[waiter->count];
+    entry->func = poll_waiter_wake;
+    entry->private = waiter;
+    waiter->queues[waiter->count++] = wq;
+    wait_queue_add(wq, entry);
+}
+
+int poll_fds(pollfd_t *fds, uint32_t nfds, int64_t timeout_ms) {
+    if (nfds > POLL_MAX_FDS)
+        return -1;
+
+    poll_waiter_t *waiter = (poll_waiter_t *)malloc(sizeof(poll_waiter_t));
+    if (waiter == NULL) {
+        printkf_error("poll_fds(): failed to allocate waiter\n");
+        return -1;
+    }
+    memset(waiter, 0, sizeof(poll_waiter_t));
+    waiter->pt.queue = poll_waiter_queue;
+    wait_queue_init(&waiter->wq);
+
+    bool valid[POLL_MAX_FDS];
+    for (uint32_t i = 0; i < nfds; i++) {
+        waiter->files[i] = poll_get_file(fds[i].fd, &valid[i]);
+    }
+
+    uint64_t deadline = timeout_ms > 0 ? wait_queue_deadline(timeout_ms) : 0;
+    poll_table_t *pt = &waiter->pt;
+    bool expired = false;
+    int ready;
+
+    while (1) {
+        ready = 0;
+        for (uint32_t i = 0; i < nfds; i++) {
+            uint32_t mask = POLLNVAL;
+            if (valid[i])
+                mask = poll_target(waiter->files[i], fds[i].fd, pt) & ((uint16_t)fds[i].events | POLLERR | POLLHUP);
+
+            fds[i].revents = mask;
+            if (mask != 0)
+                ready++;
+        }
+        pt = NULL;
+
+        if (ready > 0 || timeout_ms == 0 || expired)
+            break;
+
+        expired = !wait_event_deadline(&waiter->wq, waiter->triggered, deadline);
+        waiter->triggered = false;
+    }
+
+    for (uint32_t i = 0; i < waiter->count; i++) {
+        wait_queue_remove(waiter->queues[i], &waiter->entries[i]);
+    }
+    for (uint32_t i = 0; i < nfds; i++) {
+        if (waiter->files[i] != NULL)
+            vfs_file_put(waiter->files[i]);
+    }
+    free(waiter);
+
+    return ready;
+}
+
+static void epoll_mark_ready(epoll_t *ep, epoll_item_t *item) {
+    uint64_t flags = spin_lock(&ep->ready_lock);
+
+    if (!item->ready) {
+        item->ready = true;
+        item->ready_next = NULL;
+        if (ep->ready_tail == NULL)
+            ep->ready_head = item;
+        else
+            ep->ready_tail->ready_next = item;
+        ep->ready_tail = item;
+    }
+
+    spin_unlock(&ep->ready_lock, flags);
+}
+
+static void epoll_unmark_ready(epoll_t *ep, epoll_item_t *item) {
+    uint64_t flags = spin_lock(&ep->ready_lock);
+
+    if (item->ready) {
+        epoll_item_t *prev = NULL;
+        epoll_item_t *curr = ep->ready_head;
+        while (curr != NULL && curr != item) {
+            prev = curr;
+            curr = curr->ready_next;
+        }
+        if (curr != NULL) {
+            if (prev == NULL)
+                ep->ready_head = item->ready_next;
+            else
+                prev->ready_next = item->ready_next;
+            if (ep->ready_tail == item)
+                ep->ready_tail = prev;
+        }
+        item->ready = false;
+        item->ready_next = NULL;
+    }
+
+    spin_unlock(&ep->ready_lock, flags);
+}
+
+static void epoll_item_wake(wait_queue_entry_t *entry) {
+    epoll_item_t *item = (epoll_item_t *)entry->private;
+    epoll_mark_ready(item->ep, item);
+    wait_queue_wake_all(&item->ep->wq);
+}
+
+static void epoll_item_queue(poll_table_t *pt, wait_queue_t *wq) {
+    epoll_item_t *item = ((epoll_table_t *)pt)->item;
+    if (item->queue_count >= POLL_MAX_QUEUES)
+        return;
+
+    wait_queue_entry_t *entry = &item->entries[item->queue_count];
+    entry->func = epoll_item_wake;
+    entry->private = item;
+    item->queues[item->queue_count++] = wq;
+    wait_queue_add(wq, entry);
+}
+
+static uint32_t epoll_item_poll(epoll_item_t *item, poll_table_t *pt) {
+    return poll_target(item->file, item->fd, pt) & ((item->events & ~EPOLLET) | POLLERR | POLLHUP);
+}
+
+static void epoll_item_free(epoll_t *ep, epoll_item_t *item) {
+    for (uint32_t i = 0; i < item->queue_count; i++) {
+        wait_queue_remove(item->queues[i], &item->entries[i]);
+    }
+    epoll_unmark_ready(ep, item);
+
+    if (item->file != NULL)
+        vfs_file_put(item->file);
+    free(item);
+}
+
+static epoll_t *epoll_get(int epfd, vfs_file_t **file_out) {
+    task_t *current = task_current();
+    if (current->fds == NULL)
+        return NULL;
+
+    vfs_file_t *file = fd_get(current->fds, epfd);
+    if (file == NULL)
+        return NULL;
+    if (file->fops != &epoll_fops) {
+        vfs_file_put(file);
+        return NULL;
+    }
+
+    *file_out = file;
+    return (epoll_t *)file->private;
+}
+
+int epoll_create_fd(int flags) {
+    task_t *current = task_current();
+    if (current->fds == NULL)
+        return -1;
+
+    epoll_t *ep = (epoll_t *)malloc(sizeof(epoll_t));
+    if (ep == NULL) {
+        printkf_error("epoll_create_fd(): failed to allocate epoll\n");
+        return -1;
+    }
+    memset(ep, 0, sizeof(epoll_t));
+
+    mutex_init(&ep->lock);
+    wait_queue_init(&ep->wq);
+    vfs_node_init(&ep->node, &ep->inode, "epoll", VFS_EPOLL);
+
+    vfs_file_t *file = vfs_file_alloc(&ep->node, O_RDONLY, &epoll_fops, ep);
+    if (file == NULL) {
+        free(ep);
+        return -1;
+    }
+
+    int fd = fd_install(current->fds, file, (flags & O_CLOEXEC) != 0);
+    if (fd < 0)
+        vfs_file_put(file);
+    return fd;
+}
+
+int epoll_control(int epfd, int op, int fd, const epoll_event_t *event) {
+    vfs_file_t *epfile;
+    epoll_t *ep = epoll_get(epfd, &epfile);
+    if (ep == NULL)
+        return -1;
+
+    if (op != EPOLL_CTL_DEL && event == NULL) {
+        vfs_file_put(epfile);
+        return -1;
+    }
+
+    int ret = -1;
+    mutex_lock(&ep->lock);
+
+    epoll_item_t **link = &ep->items;
+    while (*link != NULL && (*link)->fd != fd)
+        link = &(*link)->next;
+    epoll_item_t *item = *link;
+
+    switch (op) {
+    case EPOLL_CTL_ADD: {
+        if (item != NULL)
+            break;
+
+        bool valid;
+        vfs_file_t *file = poll_get_file(fd, &valid);
+        if (!valid)
+            break;
+        if (file != NULL && file->fops == &epoll_fops) {
+            vfs_file_put(file);
+            break;
+        }
+
+        item = (epoll_item_t *)malloc(sizeof(epoll_item_t));
+        if (item == NULL) {
+            if (file != NULL)
+                vfs_file_put(file);
+            break;
+        }
+        memset(item, 0, sizeof(epoll_item_t));
+        item->ep = ep;
+        item->fd = fd;
+        item->file = file;
+        item->events = event->events;
+        item->data = event->data;
+
+        item->next = ep->items;
+        ep->items = item;
+
+        epoll_table_t table = {{epoll_item_queue}, item};
+        if (epoll_item_poll(item, &table.pt) != 0) {
+            epoll_mark_ready(ep, item);
+            wait_queue_wake_all(&ep->wq);
+        }
+        ret = 0;
+        break;
+    }
+    case EPOLL_CTL_MOD:
+        if (item == NULL)
+            break;
+
+        item->events = event->events;
+        item->data = event->data;
+        if (epoll_item_poll(item, NULL) != 0) {
+            epoll_mark_ready(ep, item);
+            wait_queue_wake_all(&ep->wq);
+        }
+        ret = 0;
+        break;
+    case EPOLL_CTL_DEL:
+        if (item == NULL)
+            break;
+
+        *link = item->next;
+        epoll_item_free(ep, item);
+        ret = 0;
+        break;
+    }
+
+    mutex_unlock(&ep->lock);
+    vfs_file_put(epfile);
+    return ret;
+}
+
+static int epoll_harvest(epoll_t *ep, epoll_event_t *events, int maxevents) {
+    uint64_t flags = spin_lock(&ep->ready_lock);
+    epoll_item_t *list = ep->ready_head;
+    ep->ready_head = NULL;
+    ep->ready_tail = NULL;
+    spin_unlock(&ep->ready_lock, flags);
+
+    int count = 0;
+    while (list != NULL) {
+        epoll_item_t *item = list;
+
+        flags = spin_lock(&ep->ready_lock);
+        list = item->ready_next;
+        item->ready_next = NULL;
+        item->ready = false;
+        spin_unlock(&ep->ready_lock, flags);
+
+        if (count == maxevents) {
+            epoll_mark_ready(ep, item);
+            continue;
+        }
+
+        uint32_t mask = epoll_item_poll(item, NULL);
+        if (mask == 0)
+            continue;
+
+        events[count].events = mask;
+        events[count].data = item->data;
+        count++;
+
+        if (!(item->events & EPOLLET))
+            epoll_mark_ready(ep, item);
+    }
+
+    return count;
+}
+
+int epoll_wait_events(int epfd, epoll_event_t *events, int maxevents, int64_t timeout_ms) {
+    if (maxevents <= 0)
+        return -1;
+
+    vfs_file_t *epfile;
+    epoll_t *ep = epoll_get(epfd, &epfile);
+    if (ep == NULL)
+        return -1;
+
+    uint64_t deadline = timeout_ms > 0 ? wait_queue_deadline(timeout_ms) : 0;
+    bool expired = false;
+    int count;
+
+    while (1) {
+        mutex_lock(&ep->lock);
+        count = epoll_harvest(ep, events, maxevents);
+        mutex_unlock(&ep->lock);
+
+        if (count > 0 || timeout_ms == 0 || expired)
+            break;
+
+        expired = !wait_event_deadline(&ep->wq, ep->ready_head != NULL, deadline);
+    }
+
+    vfs_file_put(epfile);
+    return count;
+}
+
+static uint32_t epoll_poll(vfs_file_t *file, poll_table_t *pt) {
+    epoll_t *ep = (epoll_t *)file->private;
+    poll_wait(pt, &ep->wq);
+    return ep->ready_head != NULL ? POLLIN : 0;
+}
+
+static void epoll_release(vfs_file_t *file) {
+    epoll_t *ep = (epoll_t *)file->private;
+
+    while (ep->items != NULL) {
+        epoll_item_t *item = ep->items;
+        ep->items = item->next;
+        epoll_item_free(ep, item);
+    }
+    free(ep);
+}
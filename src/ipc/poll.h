@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../sync/waitqueue.h"
+
+#define POLLIN 0x001
+#define POLLOUT 0x004
+#define POLLERR 0x008
+#define POLLHUP 0x010
+#define POLLNVAL 0x020
+
+#define POLL_MAX_FDS 64
+#define POLL_MAX_QUEUES 2
+
+#define EPOLL_CTL_ADD 1
+#define EPOLL_CTL_DEL 2
+#define EPOLL_CTL_MOD 3
+
+#define EPOLLIN POLLIN
+#define EPOLLOUT POLLOUT
+#define EPOLLERR POLLERR
+#define EPOLLHUP POLLHUP
+#define EPOLLET (1U << 31)
+
+typedef struct {
+    int32_t fd;
+    int16_t events;
+    int16_t revents;
+} pollfd_t;
+
+typedef struct {
+    uint32_t events;
+    uint64_t data;
+} epoll_event_t;
+
+typedef struct poll_table {
+    void (*queue)(struct poll_table *pt, wait_queue_t *wq);
+} poll_table_t;
+
+static inline void poll_wait(poll_table_t *pt, wait_queue_t *wq) {
+    if (pt != NULL && pt->queue != NULL)
+        pt->queue(pt, wq);
+}
+
+int poll_fds(pollfd_t *fds, uint32_t nfds, int64_t timeout_ms);
+int epoll_create_fd(int flags);
+int epoll_control(int epfd, int op, int fd, const epoll_event_t *event);
+int epoll_wait_events(int epfd, epoll_event_t *events, int maxevents, int64_t timeout_ms);
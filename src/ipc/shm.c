@@ -0,0 +1,302 @@
+#include "shm.h"
+
+#include <stdbool.h>
+
+#include "../arch/x86_64/tlb/tlb.h"
+#include "../fs/vfs/fdtable.h"
+#include "../fs/vfs/vfs.h"
+#include "../io/terminal.h"
+#include "../mem/alloc/heap.h"
+#include "../mem/alloc/page_frame_alloc.h"
+#include "../mem/paging/paging.h"
+#include "../std/string.h"
+#include "../sync/mutex.h"
+#include "../task/task.h"
+
+#define USER_SPACE_END 0x800000000000ULL
+
+typedef struct shm_object {
+    char name[SHM_NAME_MAX];
+    void **pages;
+    uint32_t page_count;
+    volatile uint32_t refcount;
+    mutex_t lock;
+    vfs_node_t node;
+    vfs_inode_t inode;
+    struct shm_object *next;
+} shm_object_t;
+
+static shm_object_t *shm_objects = NULL;
+static mutex_t shm_lock = {0};
+
+static int shm_truncate(vfs_file_t *file, size_t size);
+static void shm_release(vfs_file_t *file);
+
+static const vfs_file_ops_t shm_fops = {
+    .truncate = shm_truncate,
+    .release = shm_release,
+};
+
+static void shm_put(shm_object_t *obj) {
+    if (__atomic_sub_fetch(&obj->refcount, 1, __ATOMIC_ACQ_REL) != 0)
+        return;
+
+    for (uint32_t i = 0; i < obj->page_count; i++) {
+        pfallocator_unref_page(obj->pages[i]);
+    }
+    if (obj->pages != NULL)
+        free(obj->pages);
+    free(obj);
+}
+
+static shm_object_t *shm_find(const char *name) {
+    for (shm_object_t *obj = shm_objects; obj != NULL; obj = obj->next) {
+        if (strcmp(obj->name, name) == 0)
+            return obj;
+    }
+    return NULL;
+}
+
+static shm_object_t *shm_create(const char *name) {
+    shm_object_t *obj = (shm_object_t *)malloc(sizeof(shm_object_t));
+    if (obj == NULL) {
+        printkf_error("shm_create(): failed to allocate object\n");
+        return NULL;
+    }
+    memset(obj, 0, sizeof(shm_object_t));
+
+    strcpy(obj->name, name);
+    mutex_init(&obj->lock);
+    vfs_node_init(&obj->node, &obj->inode, name, VFS_SHM);
+    obj->refcount = 1;
+
+    obj->next = shm_objects;
+    shm_objects = obj;
+    return obj;
+}
+
+int shm_open_object(const char *name, int flags) {
+    task_t *current = task_current();
+    if (current->fds == NULL)
+        return -1;
+
+    size_t len = strlen(name);
+    if (len == 0 || len >= SHM_NAME_MAX) {
+        printkf_error("shm_open_object(): invalid name\n");
+        return -1;
+    }
+
+    mutex_lock(&shm_lock);
+
+    shm_object_t *obj = shm_find(name);
+    if (obj == NULL && (flags & O_CREAT))
+        obj = shm_create(name);
+    if (obj == NULL) {
+        mutex_unlock(&shm_lock);
+        return -1;
+    }
+    __atomic_fetch_add(&obj->refcount, 1, __ATOMIC_RELAXED);
+
+    mutex_unlock(&shm_lock);
+
+    vfs_file_t *file = vfs_file_alloc(&obj->node, O_RDWR, &shm_fops, obj);
+    if (file == NULL) {
+        shm_put(obj);
+        return -1;
+    }
+
+    int fd = fd_install(current->fds, file, (flags & O_CLOEXEC) != 0);
+    if (fd < 0)
+        vfs_file_put(file);
+    return fd;
+}
+
+int shm_unlink_object(const char *name) {
+    mutex_lock(&shm_lock);
+
+    shm_object_t *obj = shm_find(name);
+    if (obj == NULL) {
+        mutex_unlock(&shm_lock);
+        return -1;
+    }
+
+    shm_object_t **link = &shm_objects;
+    while (*link != obj)
+        link = &(*link)->next;
+    *link = obj->next;
+
+    mutex_unlock(&shm_lock);
+
+    shm_put(obj);
+    return 0;
+}
+
+static int shm_truncate(vfs_file_t *file, size_t size) {
+    shm_object_t *obj = (shm_object_t *)file->private;
+
+    uint64_t count = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+    if (count > SHM_MAX_PAGES)
+        return -1;
+
+    mutex_lock(&obj->lock);
+
+    if (count != obj->page_count) {
+        void **pages = NULL;
+        if (count > 0) {
+            pages = (void **)malloc(count * sizeof(void *));
+            if (pages == NULL) {
+                mutex_unlock(&obj->lock);
+                printkf_error("shm_truncate(): failed to allocate page array\n");
+                return -1;
+            }
+        }
+
+        uint32_t keep = count < obj->page_count ? count : obj->page_count;
+        for (uint32_t i = 0; i < keep; i++) {
+            pages[i] = obj->pages[i];
+        }
+        for (uint32_t i = keep; i < count; i++) {
+            pages[i] = pfallocator_request_zeroed_page();
+            if (pages[i] == NULL) {
+                for (uint32_t j = keep; j < i; j++) {
+                    pfallocator_unref_page(pages[j]);
+                }
+                free(pages);
+                mutex_unlock(&obj->lock);
+                printkf_error("shm_truncate(): out of memory\n");
+                return -1;
+            }
+        }
+        for (uint32_t i = keep; i < obj->page_count; i++) {
+            pfallocator_unref_page(obj->pages[i]);
+        }
+
+        if (obj->pages != NULL)
+            free(obj->pages);
+        obj->pages = pages;
+        obj->page_count = count;
+    }
+    obj->inode.size = size;
+
+    mutex_unlock(&obj->lock);
+    return 0;
+}
+
+static void shm_release(vfs_file_t *file) {
+    shm_put((shm_object_t *)file->private);
+}
+
+static bool shm_range_free(page_table_t *pml4, uint64_t addr, uint64_t pages) {
+    for (uint64_t i = 0; i < pages; i++) {
+        if (page_table_get_physical_from(pml4, (void *)(addr + i * PAGE_SIZE)) != NULL)
+            return false;
+    }
+    return true;
+}
+
+static uint64_t shm_find_range(page_table_t *pml4, uint64_t pages) {
+    uint64_t addr = SHM_USER_BASE;
+    while (addr + pages * PAGE_SIZE <= SHM_USER_END) {
+        uint64_t run = 0;
+        while (run < pages && page_table_get_physical_from(pml4, (void *)(addr + run * PAGE_SIZE)) == NULL)
+            run++;
+        if (run == pages)
+            return addr;
+        addr += (run + 1) * PAGE_SIZE;
+    }
+    return 0;
+}
+
+uint64_t shm_map(void *addr, size_t size, int prot, int fd) {
+    task_t *current = task_current();
+    if (current->fds == NULL || size == 0)
+        return (uint64_t)-1;
+
+    vfs_file_t *file = fd_get(current->fds, fd);
+    if (file == NULL)
+        return (uint64_t)-1;
+    if (file->fops != &shm_fops) {
+        vfs_file_put(file);
+        return (uint64_t)-1;
+    }
+
+    shm_object_t *obj = (shm_object_t *)file->private;
+    uint64_t pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+    uint64_t base = (uint64_t)addr;
+    page_table_t *pml4 = current->page_table;
+
+    mutex_lock(&shm_lock);
+    mutex_lock(&obj->lock);
+
+    if (pages > obj->page_count) {
+        printkf_error("shm_map(): mapping exceeds object size\n");
+        base = (uint64_t)-1;
+        goto out;
+    }
+
+    if (base == 0) {
+        base = shm_find_range(pml4, pages);
+        if (base == 0) {
+            printkf_error("shm_map(): no free address range\n");
+            base = (uint64_t)-1;
+            goto out;
+        }
+    } else if ((base & (PAGE_SIZE - 1)) || base + pages * PAGE_SIZE > USER_SPACE_END ||
+               !shm_range_free(pml4, base, pages)) {
+        base = (uint64_t)-1;
+        goto out;
+    }
+
+    uint64_t hhdm_offset = page_get_offset();
+    for (uint64_t i = 0; i < pages; i++) {
+        void *virt = (void *)(base + i * PAGE_SIZE);
+        void *page = obj->pages[i];
+
+        pfallocator_ref_page(page);
+        page_map_memory_to(pml4, virt, (void *)((uint64_t)page - hhdm_offset));
+
+        page_direntry_t *pte = page_table_get_pte(pml4, virt);
+        page_direntry_set_flag(pte, PAGE_SHARED, true);
+        if (!(prot & PROT_WRITE))
+            page_direntry_set_flag(pte, PAGE_READ_WRITE, false);
+        __asm__ volatile("invlpg (%0)" : : "r"(virt) : "memory");
+    }
+
+out:
+    mutex_unlock(&obj->lock);
+    mutex_unlock(&shm_lock);
+    vfs_file_put(file);
+    return base;
+}
+
+int shm_unmap(void *addr, size_t size) {
+    task_t *current = task_current();
+    uint64_t base = (uint64_t)addr;
+    uint64_t pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+
+    if ((base & (PAGE_SIZE - 1)) || size == 0 || base + pages * PAGE_SIZE > USER_SPACE_END)
+        return -1;
+
+    uint64_t hhdm_offset = page_get_offset();
+    int unmapped = 0;
+
+    mutex_lock(&shm_lock);
+
+    for (uint64_t i = 0; i < pages; i++) {
+        void *virt = (void *)(base + i * PAGE_SIZE);
+        page_direntry_t *pte = page_table_get_pte(current->page_table, virt);
+        if (pte == NULL || !page_direntry_get_flag(pte, PAGE_PRESENT) || !page_direntry_get_flag(pte, PAGE_SHARED))
+            continue;
+
+        void *page = (void *)((page_direntry_get_address(pte) << 12) + hhdm_offset);
+        pte->value = 0;
+        tlb_shootdown(current->page_table, virt);
+
+        pfallocator_unref_page(page);
+        unmapped++;
+    }
+
+    mutex_unlock(&shm_lock);
+
+    return unmapped > 0 ? 0 : -1;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHM_NAME_MAX 32
+#define SHM_MAX_PAGES 4096
+#define SHM_USER_BASE 0x7F0000000000ULL
+#define SHM_USER_END 0x7FFE00000000ULL
+
+#define PROT_READ 0x1
+#define PROT_WRITE 0x2
+
+int shm_open_object(const char *name, int flags);
+int shm_unlink_object(const char *name);
+uint64_t shm_map(void *addr, size_t size, int prot, int fd);
+int shm_unmap(void *addr, size_t size);
@@ -0,0 +1,329 @@
+#include "socket.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../fs/vfs/fdtable.h"
+#include "../fs/vfs/vfs.h"
+#include "../io/terminal.h"
+#include "../mem/alloc/heap.h"
+#include "../std/string.h"
+#include "../sync/mutex.h"
+#include "../sync/waitqueue.h"
+#include "../task/task.h"
+#include "pipe.h"
+#include "poll.h"
+
+typedef enum {
+    SOCKET_UNBOUND,
+    SOCKET_BOUND,
+    SOCKET_LISTENING,
+    SOCKET_CONNECTED,
+} socket_state_t;
+
+typedef struct socket {
+    mutex_t lock;
+    volatile socket_state_t state;
+    uint64_t ino;
+
+    struct socket *backlog[SOCKET_BACKLOG_MAX];
+    uint32_t backlog_head;
+    volatile uint32_t backlog_count;
+    uint32_t backlog_max;
+    wait_queue_t accept_wq;
+
+    pipe_t *rx;
+    pipe_t *tx;
+
+    vfs_node_t node;
+    vfs_inode_t inode;
+    struct socket *next_listener;
+} socket_t;
+
+static socket_t *listeners = NULL;
+static mutex_t listeners_lock = {0};
+
+static int64_t socket_read(vfs_file_t *file, void *buf, size_t size);
+static int64_t socket_write(vfs_file_t *file, const void *buf, size_t size);
+static uint32_t socket_poll(vfs_file_t *file, poll_table_t *pt);
+static void socket_release(vfs_file_t *file);
+
+static const vfs_file_ops_t socket_fops = {
+    .read = socket_read,
+    .write = socket_write,
+    .poll = socket_poll,
+    .release = socket_release,
+};
+
+static socket_t *socket_alloc() {
+    socket_t *sock = (socket_t *)malloc(sizeof(socket_t));
+    if (sock == NULL) {
+        printkf_error("socket_alloc(): failed to allocate socket\n");
+        return NULL;
+    }
+    memset(sock, 0, sizeof(socket_t));
+
+    mutex_init(&sock->lock);
+    wait_queue_init(&sock->accept_wq);
+    vfs_node_init(&sock->node, &sock->inode, "socket", VFS_SOCKET);
+
+    return sock;
+}
+
+static void socket_destroy(socket_t *sock) {
+    if (sock->state == SOCKET_LISTENING) {
+        mutex_lock(&listeners_lock);
+        socket_t **link = &listeners;
+        while (*link != NULL && *link != sock)
+            link = &(*link)->next_listener;
+        if (*link != NULL)
+            *link = sock->next_listener;
+        mutex_unlock(&listeners_lock);
+
+        mutex_lock(&sock->lock);
+        while (sock->backlog_count > 0) {
+            socket_t *peer = sock->backlog[sock->backlog_head];
+            sock->backlog_head = (sock->backlog_head + 1) % SOCKET_BACKLOG_MAX;
+            sock->backlog_count--;
+            socket_destroy(peer);
+        }
+        mutex_unlock(&sock->lock);
+    } else if (sock->state == SOCKET_CONNECTED) {
+        pipe_close_end(sock->rx, true);
+        pipe_close_end(sock->tx, false);
+    }
+
+    free(sock);
+}
+
+static int socket_install(socket_t *sock, int flags) {
+    task_t *current = task_current();
+    vfs_file_t *file = NULL;
+    if (current->fds != NULL)
+        file = vfs_file_alloc(&sock->node, O_RDWR | (flags & O_NONBLOCK), &socket_fops, sock);
+    if (file == NULL) {
+        socket_destroy(sock);
+        return -1;
+    }
+
+    int fd = fd_install(current->fds, file, (flags & O_CLOEXEC) != 0);
+    if (fd < 0)
+        vfs_file_put(file);
+    return fd;
+}
+
+static vfs_file_t *socket_get_file(int fd) {
+    task_t *current = task_current();
+    if (current->fds == NULL)
+        return NULL;
+
+    vfs_file_t *file = fd_get(current->fds, fd);
+    if (file == NULL)
+        return NULL;
+    if (file->fops != &socket_fops) {
+        vfs_file_put(file);
+        return NULL;
+    }
+    return file;
+}
+
+static int64_t socket_read(vfs_file_t *file, void *buf, size_t size) {
+    socket_t *sock = (socket_t *)file->private;
+    if (sock->state != SOCKET_CONNECTED)
+        return -1;
+    return pipe_read_buffer(sock->rx, buf, size, (file->flags & O_NONBLOCK) != 0);
+}
+
+static int64_t socket_write(vfs_file_t *file, const void *buf, size_t size) {
+    socket_t *sock = (socket_t *)file->private;
+    if (sock->state != SOCKET_CONNECTED)
+        return -1;
+    return pipe_write_buffer(sock->tx, buf, size, (file->flags & O_NONBLOCK) != 0);
+}
+
+static uint32_t socket_poll(vfs_file_t *file, poll_table_t *pt) {
+    socket_t *sock = (socket_t *)file->private;
+
+    switch (sock->state) {
+    case SOCKET_LISTENING:
+        poll_wait(pt, &sock->accept_wq);
+        return sock->backlog_count > 0 ? POLLIN : 0;
+    case SOCKET_CONNECTED:
+        return pipe_poll_end(sock->rx, true, pt) | pipe_poll_end(sock->tx, false, pt);
+    default:
+        return 0;
+    }
+}
+
+static void socket_release(vfs_file_t *file) {
+    socket_destroy((socket_t *)file->private);
+}
+
+int socket_create(int flags) {
+    socket_t *sock = socket_alloc();
+    if (sock == NULL)
+        return -1;
+
+    return socket_install(sock, flags);
+}
+
+int socket_bind(int fd, const char *path) {
+    vfs_file_t *file = socket_get_file(fd);
+    if (file == NULL)
+        return -1;
+
+    socket_t *sock = (socket_t *)file->private;
+    int ret = -1;
+
+    mutex_lock(&sock->lock);
+
+    if (sock->state == SOCKET_UNBOUND && vfs_mknod(path, VFS_SOCKET, &sock->ino) == 0) {
+        sock->state = SOCKET_BOUND;
+        ret = 0;
+    }
+
+    mutex_unlock(&sock->lock);
+    vfs_file_put(file);
+    return ret;
+}
+
+int socket_listen(int fd, int backlog) {
+    vfs_file_t *file = socket_get_file(fd);
+    if (file == NULL)
+        return -1;
+
+    socket_t *sock = (socket_t *)file->private;
+    int ret = -1;
+
+    mutex_lock(&listeners_lock);
+    mutex_lock(&sock->lock);
+
+    if (sock->state == SOCKET_BOUND) {
+        if (backlog < 1)
+            backlog = 1;
+        if (backlog > SOCKET_BACKLOG_MAX)
+            backlog = SOCKET_BACKLOG_MAX;
+
+        sock->backlog_max = backlog;
+        sock->state = SOCKET_LISTENING;
+        sock->next_listener = listeners;
+        listeners = sock;
+        ret = 0;
+    } else if (sock->state == SOCKET_LISTENING) {
+        ret = 0;
+    }
+
+    mutex_unlock(&sock->lock);
+    mutex_unlock(&listeners_lock);
+    vfs_file_put(file);
+    return ret;
+}
+
+int socket_accept(int fd, int flags) {
+    vfs_file_t *file = socket_get_file(fd);
+    if (file == NULL)
+        return -1;
+
+    socket_t *sock = (socket_t *)file->private;
+    socket_t *peer = NULL;
+
+    while (sock->state == SOCKET_LISTENING) {
+        mutex_lock(&sock->lock);
+        if (sock->backlog_count > 0) {
+            peer = sock->backlog[sock->backlog_head];
+            sock->backlog_head = (sock->backlog_head + 1) % SOCKET_BACKLOG_MAX;
+            sock->backlog_count--;
+            mutex_unlock(&sock->lock);
+            break;
+        }
+        mutex_unlock(&sock->lock);
+
+        if (file->flags & O_NONBLOCK)
+            break;
+        wait_event(&sock->accept_wq, sock->backlog_count > 0);
+    }
+
+    vfs_file_put(file);
+
+    if (peer == NULL)
+        return -1;
+
+    return socket_install(peer, flags);
+}
+
+int socket_connect(int fd, const char *path) {
+    vfs_file_t *file = socket_get_file(fd);
+    if (file == NULL)
+        return -1;
+
+    socket_t *sock = (socket_t *)file->private;
+
+    vfs_stat_t stat;
+    if (sock->state != SOCKET_UNBOUND || vfs_stat(path, &stat) < 0 || stat.type != VFS_SOCKET) {
+        vfs_file_put(file);
+        return -1;
+    }
+
+    socket_t *peer = socket_alloc();
+    pipe_t *up = pipe_alloc();
+    pipe_t *down = pipe_alloc();
+    if (peer == NULL || up == NULL || down == NULL) {
+        if (up != NULL) {
+            pipe_close_end(up, true);
+            pipe_close_end(up, false);
+        }
+        if (down != NULL) {
+            pipe_close_end(down, true);
+            pipe_close_end(down, false);
+        }
+        if (peer != NULL)
+            free(peer);
+        vfs_file_put(file);
+        return -1;
+    }
+
+    peer->rx = up;
+    peer->tx = down;
+    peer->state = SOCKET_CONNECTED;
+
+    int ret = -1;
+    socket_t *listener = NULL;
+
+    mutex_lock(&listeners_lock);
+    for (listener = listeners; listener != NULL; listener = listener->next_listener) {
+        if (listener->ino == stat.ino)
+            break;
+    }
+
+    if (listener != NULL) {
+        mutex_lock(&listener->lock);
+        if (listener->backlog_count < listener->backlog_max) {
+            uint32_t slot = (listener->backlog_head + listener->backlog_count) % SOCKET_BACKLOG_MAX;
+            listener->backlog[slot] = peer;
+            listener->backlog_count++;
+            ret = 0;
+        }
+        mutex_unlock(&listener->lock);
+    }
+
+    if (ret == 0) {
+        mutex_lock(&sock->lock);
+        sock->rx = down;
+        sock->tx = up;
+        sock->state = SOCKET_CONNECTED;
+        mutex_unlock(&sock->lock);
+
+        wait_queue_wake_all(&listener->accept_wq);
+    }
+
+    mutex_unlock(&listeners_lock);
+
+    if (ret < 0) {
+        socket_destroy(peer);
+        pipe_close_end(up, false);
+        pipe_close_end(down, true);
+    }
+
+    vfs_file_put(file);
+    return ret;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <stdint.h>
+
+#define SOCKET_BACKLOG_MAX 32
+
+int socket_create(int flags);
+int socket_bind(int fd, const char *path);
+int socket_listen(int fd, int backlog);
+int socket_accept(int fd, int flags);
+int socket_connect(int fd, const char *path);
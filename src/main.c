@@ -2,18 +2,23 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "arch/x86_64/cpu/cpu.h"
 #include "arch/x86_64/gdt/gdt.h"
+#include "arch/x86_64/smp/smp.h"
 #include "drivers/acpi/acpi.h"
+#include "drivers/apic/lapic.h"
 #include "drivers/driver.h"
 #include "drivers/nvme/nvme.h"
 #include "drivers/pci/pci.h"
 #include "drivers/pic/pic.h"
 #include "drivers/timer/timer.h"
+#include "drivers/timer/tsc.h"
 #include "drivers/usb/keyboard.h"
 #include "drivers/usb/xhci.h"
 #include "elf/elf.h"
 #include "fs/mount/mount.h"
 #include "fs/tmpfs/tmpfs.h"
+#include "fs/vfs/page_cache.h"
 #include "fs/vfs/vfs.h"
 #include "interrupts/interrupts.h"
 #include "io/terminal.h"
@@ -26,6 +31,7 @@
 #include "syscall/syscall.h"
 #include "task/scheduler.h"
 #include "task/task.h"
+#include "task/workqueue.h"
 #include "usermode/usermode.h"
 
 extern uint8_t _kernel_start[];
@@ -47,6 +53,9 @@ __attribute__((used, section(".limine_requests"))) static volatile struct limine
 __attribute__((used, section(".limine_requests"))) static volatile struct limine_rsdp_request rsdp_request = {
     .id = LIMINE_RSDP_REQUEST_ID, .revision = 4};
 
+__attribute__((used, section(".limine_requests"))) static volatile struct limine_mp_request mp_request = {
+    .id = LIMINE_MP_REQUEST_ID, .revision = 0};
+
 __attribute__((used, section(".limine_requests_start"))) static volatile uint64_t limine_requests_start_marker[] =
     LIMINE_REQUESTS_START_MARKER;
 
@@ -86,7 +95,7 @@ void kmain() {
     rsdp2_t *rsdp = (rsdp2_t *)rsdp_request.response->address;
 
     printkf_info("Loading GDT...\n");
-    gdt_init();
+    cpu_init_bsp();
     printkf_ok("Loaded GDT\n");
 
     memmap_init(memmap_request.response->entries, memmap_request.response->entry_count);
@@ -100,6 +109,7 @@ void kmain() {
 
     interrupts_init();
     pic_remap();
+    lapic_init();
     sti();
 
     heap_init((void *)0xFFFF900000000000, 0x10, offset);
@@ -118,12 +128,17 @@ void kmain() {
     printkf_info("USED RAM: %k%llu%k\n", 0xcccc66, pfallocator_get_used_ram(), 0xffffff);
 
     timer_init(100);
+    tsc_calibrate();
     task_init();
     scheduler_init();
     timer_set_callback(scheduler_tick);
+    workqueue_init();
+    page_cache_init();
 
     syscall_init();
 
+    smp_init(mp_request.response);
+
     int result = mount("/dev/nvme0p3", "/", "fat32");
     if (result < 0) {
         printkf_error("main(): Failed to mount root\n");
@@ -134,6 +149,10 @@ void kmain() {
         printkf_error("main(): Failed to mount /boot\n");
     }
 
+    if (vfs_lookup("/run") == NULL && vfs_mkdir("/run") < 0) {
+        printkf_error("main(): Failed to create /run\n");
+    }
+
     printkf_info("Starting /system/cmd/sh\n");
     task_t *init = task_create_elf("/system/cmd/sh", 16384);
     if (init == NULL) {
@@ -143,12 +162,9 @@ void kmain() {
 
     scheduler_add_task(init);
 
-    task_t *kbd_task = task_create(usb_keyboard_task, 4096);
-    if (kbd_task) {
-        scheduler_add_task(kbd_task);
-    }
+    usb_keyboard_start();
 
     scheduler_enable();
 
-    hcf();
+    scheduler_idle();
 }
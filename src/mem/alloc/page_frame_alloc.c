@@ -1,6 +1,8 @@
 #include "page_frame_alloc.h"
 
 #include "../../io/terminal.h"
+#include "../../std/string.h"
+#include "../../sync/spinlock.h"
 #include "../memmap.h"
 
 uint64_t free_memory;
@@ -9,6 +11,14 @@ bool initialized = false;
 
 pfallocator_t _g_alloc = {0};
 
+static spinlock_t pfallocator_lock = {0};
+
+static void *zero_pool[PFALLOCATOR_ZERO_POOL_SIZE];
+static uint32_t zero_pool_count = 0;
+static spinlock_t zero_pool_lock = {0};
+
+static pfallocator_reclaim_t reclaim_hook = NULL;
+
 void pfallocator_init(size_t offset) {
     if (initialized)
         return;
@@ -71,16 +81,28 @@ void pfallocator_init(size_t offset) {
     pfallocator_lock_pages(largest_free_segment, refcount_pages);
 }
 
-void *pfallocator_request_page() {
+static void *pfallocator_take_page(uint64_t i) {
+    void *addr = (void *)(i * PAGE_SIZE + _g_alloc.offset);
+    _g_alloc.refcounts[i] = 1;
+    free_memory -= PAGE_SIZE;
+    used_memory += PAGE_SIZE;
+    _g_alloc.page_index = i + 1;
+    return addr;
+}
+
+void pfallocator_set_reclaim(pfallocator_reclaim_t reclaim) {
+    reclaim_hook = reclaim;
+}
+
+static void *pfallocator_take_free_page() {
+    uint64_t flags = spin_lock(&pfallocator_lock);
+
     for (uint64_t i = _g_alloc.page_index; i < _g_alloc.page_count; i++) {
         if (_g_alloc.refcounts[i] != 0)
             continue;
 
-        void *addr = (void *)(i * PAGE_SIZE + _g_alloc.offset);
-        _g_alloc.refcounts[i] = 1;
-        free_memory -= PAGE_SIZE;
-        used_memory += PAGE_SIZE;
-        _g_alloc.page_index = i + 1;
+        void *addr = pfallocator_take_page(i);
+        spin_unlock(&pfallocator_lock, flags);
         return addr;
     }
 
@@ -88,17 +110,69 @@ void *pfallocator_request_page() {
         if (_g_alloc.refcounts[i] != 0)
             continue;
 
-        void *addr = (void *)(i * PAGE_SIZE + _g_alloc.offset);
-        _g_alloc.refcounts[i] = 1;
-        free_memory -= PAGE_SIZE;
-        used_memory += PAGE_SIZE;
-        _g_alloc.page_index = i + 1;
+        void *addr = pfallocator_take_page(i);
+        spin_unlock(&pfallocator_lock, flags);
         return addr;
     }
 
+    spin_unlock(&pfallocator_lock, flags);
     return NULL;
 }
 
+void *pfallocator_request_page() {
+    void *addr = pfallocator_take_free_page();
+    if (addr != NULL)
+        return addr;
+
+    pfallocator_reclaim_t reclaim = reclaim_hook;
+    if (reclaim != NULL && reclaim(PFALLOCATOR_RECLAIM_BATCH) > 0) {
+        addr = pfallocator_take_free_page();
+        if (addr != NULL)
+            return addr;
+    }
+
+    uint64_t flags = spin_lock(&zero_pool_lock);
+    void *page = zero_pool_count > 0 ? zero_pool[--zero_pool_count] : NULL;
+    spin_unlock(&zero_pool_lock, flags);
+    return page;
+}
+
+void *pfallocator_request_zeroed_page() {
+    uint64_t flags = spin_lock(&zero_pool_lock);
+    if (zero_pool_count > 0) {
+        void *page = zero_pool[--zero_pool_count];
+        spin_unlock(&zero_pool_lock, flags);
+        return page;
+    }
+    spin_unlock(&zero_pool_lock, flags);
+
+    void *page = pfallocator_request_page();
+    if (page != NULL)
+        memset(page, 0, PAGE_SIZE);
+    return page;
+}
+
+bool pfallocator_zero_pool_refill() {
+    if (zero_pool_count >= PFALLOCATOR_ZERO_POOL_SIZE)
+        return false;
+
+    void *page = pfallocator_request_page();
+    if (page == NULL)
+        return false;
+    memset(page, 0, PAGE_SIZE);
+
+    uint64_t flags = spin_lock(&zero_pool_lock);
+    if (zero_pool_count < PFALLOCATOR_ZERO_POOL_SIZE) {
+        zero_pool[zero_pool_count++] = page;
+        spin_unlock(&zero_pool_lock, flags);
+        return true;
+    }
+    spin_unlock(&zero_pool_lock, flags);
+
+    pfallocator_free_page(page);
+    return false;
+}
+
 void pfallocator_ref_page(void *address) {
     if ((uint64_t)address < _g_alloc.offset)
         return;
@@ -109,14 +183,17 @@ void pfallocator_ref_page(void *address) {
         return;
     }
 
+    uint64_t flags = spin_lock(&pfallocator_lock);
+
     if (_g_alloc.refcounts[i] == 0) {
+        spin_unlock(&pfallocator_lock, flags);
         printkf_error("ref_page(): page %p (index %llu) has refcount 0!\n", address, i);
         return;
     }
-    if (_g_alloc.refcounts[i] == UINT16_MAX)
-        return;
+    if (_g_alloc.refcounts[i] != UINT16_MAX)
+        _g_alloc.refcounts[i]++;
 
-    _g_alloc.refcounts[i]++;
+    spin_unlock(&pfallocator_lock, flags);
 }
 
 uint16_t pfallocator_unref_page(void *address) {
@@ -129,19 +206,24 @@ uint16_t pfallocator_unref_page(void *address) {
         return UINT16_MAX;
     }
 
-    if (_g_alloc.refcounts[i] == 0)
+    uint64_t flags = spin_lock(&pfallocator_lock);
+
+    if (_g_alloc.refcounts[i] == 0) {
+        spin_unlock(&pfallocator_lock, flags);
         return 0;
+    }
 
-    _g_alloc.refcounts[i]--;
+    uint16_t refcount = --_g_alloc.refcounts[i];
 
-    if (_g_alloc.refcounts[i] == 0) {
+    if (refcount == 0) {
         free_memory += PAGE_SIZE;
         used_memory -= PAGE_SIZE;
         if (_g_alloc.page_index > i)
             _g_alloc.page_index = i;
     }
 
-    return _g_alloc.refcounts[i];
+    spin_unlock(&pfallocator_lock, flags);
+    return refcount;
 }
 
 uint16_t pfallocator_get_refcount(void *address) {
@@ -173,11 +255,15 @@ void pfallocator_lock_page(void *address) {
     if (i >= _g_alloc.page_count)
         return;
 
+    uint64_t flags = spin_lock(&pfallocator_lock);
+
     if (_g_alloc.refcounts[i] == 0) {
         _g_alloc.refcounts[i] = 1;
         free_memory -= PAGE_SIZE;
         used_memory += PAGE_SIZE;
     }
+
+    spin_unlock(&pfallocator_lock, flags);
 }
 
 void pfallocator_lock_pages(void *address, uint64_t count) {
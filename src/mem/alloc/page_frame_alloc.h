@@ -5,6 +5,10 @@
 #include <stdint.h>
 
 #define PAGE_SIZE 4096
+#define PFALLOCATOR_ZERO_POOL_SIZE 64
+#define PFALLOCATOR_RECLAIM_BATCH 32
+
+typedef uint64_t (*pfallocator_reclaim_t)(uint64_t pages);
 
 typedef struct {
     uint16_t *refcounts;
@@ -14,11 +18,14 @@ typedef struct {
 } pfallocator_t;
 
 void pfallocator_init(size_t offset);
+void pfallocator_set_reclaim(pfallocator_reclaim_t reclaim);
 
 uint64_t pfallocator_get_free_ram();
 uint64_t pfallocator_get_used_ram();
 
 void *pfallocator_request_page();
+void *pfallocator_request_zeroed_page();
+bool pfallocator_zero_pool_refill();
 void pfallocator_ref_page(void *address);
 uint16_t pfallocator_unref_page(void *address);
 uint16_t pfallocator_get_refcount(void *address);
@@ -12,10 +12,9 @@ bool page_table_map(page_table_manager_t *manager, void *virt, void *phys) {
     page_direntry_t pde = manager->pml4->entries[indexer.pdp];
     page_table_t *pdp;
     if (!page_direntry_get_flag(&pde, PAGE_PRESENT)) {
-        pdp = (page_table_t *)pfallocator_request_page();
+        pdp = (page_table_t *)pfallocator_request_zeroed_page();
         if (pdp == NULL)
             return false;
-        memset(pdp, 0, PAGE_SIZE);
 
         uint64_t pdp_phys = (uint64_t)pdp - manager->offset;
         page_direntry_set_address(&pde, pdp_phys >> 12);
@@ -31,10 +30,9 @@ bool page_table_map(page_table_manager_t *manager, void *virt, void *phys) {
     pde = pdp->entries[indexer.pd];
     page_table_t *pd;
     if (!page_direntry_get_flag(&pde, PAGE_PRESENT)) {
-        pd = (page_table_t *)pfallocator_request_page();
+        pd = (page_table_t *)pfallocator_request_zeroed_page();
         if (pd == NULL)
             return false;
-        memset(pd, 0, PAGE_SIZE);
 
         uint64_t pd_phys = (uint64_t)pd - manager->offset;
         page_direntry_set_address(&pde, pd_phys >> 12);
@@ -50,10 +48,9 @@ bool page_table_map(page_table_manager_t *manager, void *virt, void *phys) {
     pde = pd->entries[indexer.pt];
     page_table_t *pt;
     if (!page_direntry_get_flag(&pde, PAGE_PRESENT)) {
-        pt = (page_table_t *)pfallocator_request_page();
+        pt = (page_table_t *)pfallocator_request_zeroed_page();
         if (pt == NULL)
             return false;
-        memset(pt, 0, PAGE_SIZE);
 
         uint64_t pt_phys = (uint64_t)pt - manager->offset;
         page_direntry_set_address(&pde, pt_phys >> 12);
@@ -82,10 +79,9 @@ bool page_table_map_mmio(page_table_manager_t *manager, void *virt, void *phys)
     page_direntry_t pde = manager->pml4->entries[indexer.pdp];
     page_table_t *pdp;
     if (!page_direntry_get_flag(&pde, PAGE_PRESENT)) {
-        pdp = (page_table_t *)pfallocator_request_page();
+        pdp = (page_table_t *)pfallocator_request_zeroed_page();
         if (pdp == NULL)
             return false;
-        memset(pdp, 0, PAGE_SIZE);
 
         uint64_t pdp_phys = (uint64_t)pdp - manager->offset;
         page_direntry_set_address(&pde, pdp_phys >> 12);
@@ -101,10 +97,9 @@ bool page_table_map_mmio(page_table_manager_t *manager, void *virt, void *phys)
     pde = pdp->entries[indexer.pd];
     page_table_t *pd;
     if (!page_direntry_get_flag(&pde, PAGE_PRESENT)) {
-        pd = (page_table_t *)pfallocator_request_page();
+        pd = (page_table_t *)pfallocator_request_zeroed_page();
         if (pd == NULL)
             return false;
-        memset(pd, 0, PAGE_SIZE);
 
         uint64_t pd_phys = (uint64_t)pd - manager->offset;
         page_direntry_set_address(&pde, pd_phys >> 12);
@@ -120,10 +115,9 @@ bool page_table_map_mmio(page_table_manager_t *manager, void *virt, void *phys)
     pde = pd->entries[indexer.pt];
     page_table_t *pt;
     if (!page_direntry_get_flag(&pde, PAGE_PRESENT)) {
-        pt = (page_table_t *)pfallocator_request_page();
+        pt = (page_table_t *)pfallocator_request_zeroed_page();
         if (pt == NULL)
             return false;
-        memset(pt, 0, PAGE_SIZE);
 
         uint64_t pt_phys = (uint64_t)pt - manager->offset;
         page_direntry_set_address(&pde, pt_phys >> 12);
@@ -117,10 +117,9 @@ size_t page_get_offset() {
 static page_table_t *deep_copy_page_table(page_table_t *src, int level) {
     uint64_t offset = _g_page_table_manager.offset;
 
-    page_table_t *dst = (page_table_t *)pfallocator_request_page();
+    page_table_t *dst = (page_table_t *)pfallocator_request_zeroed_page();
     if (dst == NULL)
         return NULL;
-    memset(dst, 0, 0x1000);
 
     for (int i = 0; i < 512; i++) {
         if (!page_direntry_get_flag(&src->entries[i], PAGE_PRESENT)) {
@@ -128,7 +127,8 @@ static page_table_t *deep_copy_page_table(page_table_t *src, int level) {
         }
 
         if (level == 1) {
-            if (page_direntry_get_flag(&src->entries[i], PAGE_READ_WRITE)) {
+            if (page_direntry_get_flag(&src->entries[i], PAGE_READ_WRITE) &&
+                !page_direntry_get_flag(&src->entries[i], PAGE_SHARED)) {
                 page_direntry_set_flag(&src->entries[i], PAGE_READ_WRITE, false);
                 page_direntry_set_flag(&src->entries[i], PAGE_COW, true);
             }
@@ -156,12 +156,10 @@ static page_table_t *deep_copy_page_table(page_table_t *src, int level) {
 }
 
 page_table_t *page_table_clone_for_user() {
-    page_table_t *new_pml4 = (page_table_t *)pfallocator_request_page();
+    page_table_t *new_pml4 = (page_table_t *)pfallocator_request_zeroed_page();
     if (new_pml4 == NULL)
         return NULL;
 
-    memset(new_pml4, 0, 0x1000);
-
     uint64_t cr3;
     __asm__ volatile("mov %%cr3, %0" : "=r"(cr3));
     page_table_t *current_pml4 = (page_table_t *)(cr3 + _g_page_table_manager.offset);
@@ -194,12 +192,10 @@ page_table_t *page_table_clone_for_user() {
 }
 
 page_table_t *page_table_create_user() {
-    page_table_t *new_pml4 = (page_table_t *)pfallocator_request_page();
+    page_table_t *new_pml4 = (page_table_t *)pfallocator_request_zeroed_page();
     if (new_pml4 == NULL)
         return NULL;
 
-    memset(new_pml4, 0, 0x1000);
-
     page_table_t *kernel_pml4 = _g_page_table_manager.pml4;
 
     for (int i = 256; i < 512; i++) {
@@ -13,6 +13,7 @@ typedef enum {
     PAGE_ACCESSED = 5,
     PAGE_LARGER_PAGES = 6,
     PAGE_COW = 9,
+    PAGE_SHARED = 10,
     PAGE_NX = 63,
 } page_direntry_flag_t;
 
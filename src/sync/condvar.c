@@ -0,0 +1,34 @@
+#include "condvar.h"
+
+void condvar_init(condvar_t *cv) {
+    cv->seq = 0;
+    wait_queue_init(&cv->wq);
+}
+
+void condvar_wait(condvar_t *cv, mutex_t *mutex) {
+    uint64_t seq = __atomic_load_n(&cv->seq, __ATOMIC_ACQUIRE);
+
+    mutex_unlock(mutex);
+    wait_event(&cv->wq, __atomic_load_n(&cv->seq, __ATOMIC_ACQUIRE) != seq);
+    mutex_lock(mutex);
+}
+
+bool condvar_wait_timeout(condvar_t *cv, mutex_t *mutex, uint64_t ms) {
+    uint64_t seq = __atomic_load_n(&cv->seq, __ATOMIC_ACQUIRE);
+
+    mutex_unlock(mutex);
+    bool signaled = wait_event_timeout(&cv->wq, __atomic_load_n(&cv->seq, __ATOMIC_ACQUIRE) != seq, ms);
+    mutex_lock(mutex);
+
+    return signaled;
+}
+
+void condvar_signal(condvar_t *cv) {
+    __atomic_fetch_add(&cv->seq, 1, __ATOMIC_RELEASE);
+    wait_queue_wake_one(&cv->wq);
+}
+
+void condvar_broadcast(condvar_t *cv) {
+    __atomic_fetch_add(&cv->seq, 1, __ATOMIC_RELEASE);
+    wait_queue_wake_all(&cv->wq);
+}
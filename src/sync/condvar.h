@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mutex.h"
+#include "waitqueue.h"
+
+typedef struct {
+    volatile uint64_t seq;
+    wait_queue_t wq;
+} condvar_t;
+
+void condvar_init(condvar_t *cv);
+void condvar_wait(condvar_t *cv, mutex_t *mutex);
+bool condvar_wait_timeout(condvar_t *cv, mutex_t *mutex, uint64_t ms);
+void condvar_signal(condvar_t *cv);
+void condvar_broadcast(condvar_t *cv);
@@ -0,0 +1,116 @@
+#include "futex.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../mem/paging/paging.h"
+#include "../task/task.h"
+#include "spinlock.h"
+#include "waitqueue.h"
+
+#define USER_SPACE_END 0x0000800000000000ULL
+
+typedef struct futex_waiter {
+    uint64_t key;
+    volatile bool woken;
+    struct futex_waiter *next;
+} futex_waiter_t;
+
+typedef struct {
+    spinlock_t lock;
+    futex_waiter_t *head;
+    wait_queue_t wq;
+} futex_bucket_t;
+
+static futex_bucket_t buckets[FUTEX_BUCKETS] = {0};
+
+static uint64_t futex_key(uint32_t *uaddr) {
+    uint64_t addr = (uint64_t)uaddr;
+    if (addr == 0 || addr >= USER_SPACE_END || (addr & 0x3)) {
+        return 0;
+    }
+
+    task_t *current = task_current();
+    if (current == NULL) {
+        return 0;
+    }
+
+    void *phys = page_table_get_physical_from(current->page_table, uaddr);
+    if (phys == NULL) {
+        return 0;
+    }
+
+    return (uint64_t)phys | (addr & 0xFFF);
+}
+
+static futex_bucket_t *futex_bucket(uint64_t key) {
+    uint64_t hash = (key >> 2) * 0x9E3779B97F4A7C15ULL;
+    return &buckets[(hash >> 32) % FUTEX_BUCKETS];
+}
+
+static void futex_unlink(futex_bucket_t *bucket, futex_waiter_t *waiter) {
+    futex_waiter_t **link = &bucket->head;
+    while (*link != NULL) {
+        if (*link == waiter) {
+            *link = waiter->next;
+            return;
+        }
+        link = &(*link)->next;
+    }
+}
+
+int64_t futex_wait(uint32_t *uaddr, uint32_t val) {
+    uint64_t key = futex_key(uaddr);
+    if (key == 0) {
+        return -1;
+    }
+
+    futex_bucket_t *bucket = futex_bucket(key);
+    volatile uint32_t *word = (volatile uint32_t *)(key + page_get_offset());
+
+    futex_waiter_t waiter = {.key = key, .woken = false, .next = NULL};
+
+    uint64_t flags = spin_lock(&bucket->lock);
+    if (*word != val) {
+        spin_unlock(&bucket->lock, flags);
+        return -1;
+    }
+    waiter.next = bucket->head;
+    bucket->head = &waiter;
+    spin_unlock(&bucket->lock, flags);
+
+    wait_event(&bucket->wq, waiter.woken);
+
+    return 0;
+}
+
+int64_t futex_wake(uint32_t *uaddr, uint32_t count) {
+    uint64_t key = futex_key(uaddr);
+    if (key == 0) {
+        return -1;
+    }
+
+    futex_bucket_t *bucket = futex_bucket(key);
+    int64_t woken = 0;
+
+    uint64_t flags = spin_lock(&bucket->lock);
+
+    futex_waiter_t *waiter = bucket->head;
+    while (waiter != NULL && (uint32_t)woken < count) {
+        futex_waiter_t *next = waiter->next;
+        if (waiter->key == key) {
+            futex_unlink(bucket, waiter);
+            waiter->woken = true;
+            woken++;
+        }
+        waiter = next;
+    }
+
+    spin_unlock(&bucket->lock, flags);
+
+    if (woken > 0) {
+        wait_queue_wake_all(&bucket->wq);
+    }
+
+    return woken;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <stdint.h>
+
+#define FUTEX_WAIT 0
+#define FUTEX_WAKE 1
+
+#define FUTEX_BUCKETS 64
+
+int64_t futex_wait(uint32_t *uaddr, uint32_t val);
+int64_t futex_wake(uint32_t *uaddr, uint32_t count);
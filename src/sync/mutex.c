@@ -0,0 +1,38 @@
+#include "mutex.h"
+
+#include <stddef.h>
+
+#include "../task/task.h"
+
+void mutex_init(mutex_t *mutex) {
+    mutex->locked = 0;
+    mutex->owner = NULL;
+    wait_queue_init(&mutex->wq);
+}
+
+bool mutex_trylock(mutex_t *mutex) {
+    if (__atomic_exchange_n(&mutex->locked, 1, __ATOMIC_ACQUIRE) != 0) {
+        return false;
+    }
+
+    mutex->owner = task_current();
+    return true;
+}
+
+void mutex_lock(mutex_t *mutex) {
+    if (mutex_trylock(mutex)) {
+        return;
+    }
+
+    wait_event(&mutex->wq, mutex_trylock(mutex));
+}
+
+void mutex_unlock(mutex_t *mutex) {
+    mutex->owner = NULL;
+    __atomic_store_n(&mutex->locked, 0, __ATOMIC_RELEASE);
+    wait_queue_wake_one(&mutex->wq);
+}
+
+bool mutex_is_locked(mutex_t *mutex) {
+    return __atomic_load_n(&mutex->locked, __ATOMIC_RELAXED) != 0;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "waitqueue.h"
+
+typedef struct {
+    volatile uint32_t locked;
+    struct task *owner;
+    wait_queue_t wq;
+} mutex_t;
+
+void mutex_init(mutex_t *mutex);
+void mutex_lock(mutex_t *mutex);
+bool mutex_trylock(mutex_t *mutex);
+void mutex_unlock(mutex_t *mutex);
+bool mutex_is_locked(mutex_t *mutex);
@@ -0,0 +1,64 @@
+#include "rwlock.h"
+
+void rwlock_init(rwlock_t *rw) {
+    rw->lock.locked = 0;
+    rw->readers = 0;
+    rw->writers_waiting = 0;
+    wait_queue_init(&rw->wq);
+}
+
+static bool rwlock_try_read(rwlock_t *rw) {
+    bool acquired = false;
+
+    uint64_t flags = spin_lock(&rw->lock);
+    if (rw->readers >= 0 && rw->writers_waiting == 0) {
+        rw->readers++;
+        acquired = true;
+    }
+    spin_unlock(&rw->lock, flags);
+
+    return acquired;
+}
+
+static bool rwlock_try_write(rwlock_t *rw) {
+    bool acquired = false;
+
+    uint64_t flags = spin_lock(&rw->lock);
+    if (rw->readers == 0) {
+        rw->readers = -1;
+        rw->writers_waiting--;
+        acquired = true;
+    }
+    spin_unlock(&rw->lock, flags);
+
+    return acquired;
+}
+
+void rwlock_read_lock(rwlock_t *rw) {
+    wait_event(&rw->wq, rwlock_try_read(rw));
+}
+
+void rwlock_read_unlock(rwlock_t *rw) {
+    uint64_t flags = spin_lock(&rw->lock);
+    bool last = --rw->readers == 0;
+    spin_unlock(&rw->lock, flags);
+
+    if (last)
+        wait_queue_wake_all(&rw->wq);
+}
+
+void rwlock_write_lock(rwlock_t *rw) {
+    uint64_t flags = spin_lock(&rw->lock);
+    rw->writers_waiting++;
+    spin_unlock(&rw->lock, flags);
+
+    wait_event(&rw->wq, rwlock_try_write(rw));
+}
+
+void rwlock_write_unlock(rwlock_t *rw) {
+    uint64_t flags = spin_lock(&rw->lock);
+    rw->readers = 0;
+    spin_unlock(&rw->lock, flags);
+
+    wait_queue_wake_all(&rw->wq);
+}
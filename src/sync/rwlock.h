@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "spinlock.h"
+#include "waitqueue.h"
+
+typedef struct {
+    spinlock_t lock;
+    int32_t readers;
+    uint32_t writers_waiting;
+    wait_queue_t wq;
+} rwlock_t;
+
+void rwlock_init(rwlock_t *rw);
+void rwlock_read_lock(rwlock_t *rw);
+void rwlock_read_unlock(rwlock_t *rw);
+void rwlock_write_lock(rwlock_t *rw);
+void rwlock_write_unlock(rwlock_t *rw);
@@ -0,0 +1,36 @@
+#include "semaphore.h"
+
+void semaphore_init(semaphore_t *sem, int64_t count) {
+    sem->lock.locked = 0;
+    sem->count = count;
+    wait_queue_init(&sem->wq);
+}
+
+bool semaphore_trydown(semaphore_t *sem) {
+    bool acquired = false;
+
+    uint64_t flags = spin_lock(&sem->lock);
+    if (sem->count > 0) {
+        sem->count--;
+        acquired = true;
+    }
+    spin_unlock(&sem->lock, flags);
+
+    return acquired;
+}
+
+void semaphore_down(semaphore_t *sem) {
+    wait_event(&sem->wq, semaphore_trydown(sem));
+}
+
+bool semaphore_down_timeout(semaphore_t *sem, uint64_t ms) {
+    return wait_event_timeout(&sem->wq, semaphore_trydown(sem), ms);
+}
+
+void semaphore_up(semaphore_t *sem) {
+    uint64_t flags = spin_lock(&sem->lock);
+    sem->count++;
+    spin_unlock(&sem->lock, flags);
+
+    wait_queue_wake_one(&sem->wq);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "spinlock.h"
+#include "waitqueue.h"
+
+typedef struct {
+    spinlock_t lock;
+    int64_t count;
+    wait_queue_t wq;
+} semaphore_t;
+
+void semaphore_init(semaphore_t *sem, int64_t count);
+void semaphore_down(semaphore_t *sem);
+bool semaphore_down_timeout(semaphore_t *sem, uint64_t ms);
+bool semaphore_trydown(semaphore_t *sem);
+void semaphore_up(semaphore_t *sem);
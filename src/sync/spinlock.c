@@ -1,5 +1,7 @@
 #include "spinlock.h"
 
+#include "../task/scheduler.h"
+
 static inline uint32_t atomic_exchange(volatile uint32_t *target, uint32_t new) {
     uint32_t old;
     __asm__ volatile("lock xchg %0, %1" : "=r"(old), "+m"(*target) : "0"(new) : "memory");
@@ -37,6 +39,8 @@ uint64_t spin_lock(spinlock_t *lock) {
 
     cli_no_reorder();
 
+    preempt_disable();
+
     while (atomic_exchange(&lock->locked, 1) == 1) {
         cpu_pause();
     }
@@ -47,7 +51,12 @@ uint64_t spin_lock(spinlock_t *lock) {
 void spin_unlock(spinlock_t *lock, uint64_t flags) {
     __asm__ volatile("" ::: "memory");
     lock->locked = 0;
+    preempt_enable_no_resched();
     write_rflags(flags);
+
+    if (flags & RFLAGS_IF) {
+        preempt_check_resched();
+    }
 }
 
 uint64_t spin_trylock(spinlock_t *lock, int *acquired) {
@@ -55,6 +64,7 @@ uint64_t spin_trylock(spinlock_t *lock, int *acquired) {
     cli_no_reorder();
 
     if (atomic_exchange(&lock->locked, 1) == 0) {
+        preempt_disable();
         *acquired = 1;
         return flags;
     } else {
@@ -0,0 +1,196 @@
+#include "waitqueue.h"
+
+#include <stddef.h>
+
+#include "../drivers/timer/timer.h"
+#include "../task/scheduler.h"
+#include "../task/task.h"
+
+static inline uint64_t irq_save() {
+    uint64_t flags;
+    __asm__ volatile("pushfq\n\t"
+                     "pop %0\n\t"
+                     "cli"
+                     : "=r"(flags)
+                     :
+                     : "memory");
+    return flags;
+}
+
+static inline void irq_restore(uint64_t flags) {
+    __asm__ volatile("push %0\n\t"
+                     "popfq"
+                     :
+                     : "r"(flags)
+                     : "memory", "cc");
+}
+
+void wait_queue_init(wait_queue_t *wq) {
+    wq->lock.locked = 0;
+    wq->head = NULL;
+    wq->tail = NULL;
+}
+
+static void wait_queue_unlink(wait_queue_t *wq, wait_queue_entry_t *entry) {
+    wait_queue_entry_t *prev = NULL;
+    for (wait_queue_entry_t *curr = wq->head; curr != NULL; prev = curr, curr = curr->next) {
+        if (curr != entry) {
+            continue;
+        }
+
+        if (prev == NULL) {
+            wq->head = curr->next;
+        } else {
+            prev->next = curr->next;
+        }
+        if (wq->tail == curr) {
+            wq->tail = prev;
+        }
+        break;
+    }
+
+    entry->next = NULL;
+    entry->queued = false;
+}
+
+void wait_queue_prepare(wait_queue_t *wq, wait_queue_entry_t *entry, uint64_t deadline) {
+    uint64_t flags = irq_save();
+
+    if (!entry->prepared) {
+        entry->task = task_current();
+        entry->flags = flags;
+        entry->prepared = true;
+    }
+
+    if (entry->task == NULL) {
+        return;
+    }
+
+    uint64_t lock_flags = spin_lock(&wq->lock);
+
+    if (!entry->queued) {
+        entry->next = NULL;
+        if (wq->tail == NULL) {
+            wq->head = entry;
+        } else {
+            wq->tail->next = entry;
+        }
+        wq->tail = entry;
+        entry->queued = true;
+    }
+
+    entry->task->wake_tick = deadline;
+    entry->task->state = TASK_BLOCKED;
+
+    spin_unlock(&wq->lock, lock_flags);
+}
+
+void wait_queue_sleep(wait_queue_entry_t *entry) {
+    if (entry->task != NULL) {
+        scheduler_schedule();
+    }
+    irq_restore(entry->flags);
+}
+
+void wait_queue_finish(wait_queue_t *wq, wait_queue_entry_t *entry) {
+    if (entry->task == NULL) {
+        irq_restore(entry->flags);
+        return;
+    }
+
+    uint64_t flags = spin_lock(&wq->lock);
+
+    if (entry->queued) {
+        wait_queue_unlink(wq, entry);
+    }
+
+    entry->task->wake_tick = 0;
+    entry->task->state = TASK_RUNNING;
+
+    spin_unlock(&wq->lock, flags);
+    irq_restore(entry->flags);
+}
+
+uint64_t wait_queue_deadline(uint64_t ms) {
+    if (ms == 0)
+        return 0;
+
+    uint64_t ticks = (ms + 9) / 10;
+    return timer_get_ticks() + ticks;
+}
+
+bool wait_queue_expired(uint64_t deadline) {
+    return deadline != 0 && timer_get_ticks() >= deadline;
+}
+
+void wait_queue_add(wait_queue_t *wq, wait_queue_entry_t *entry) {
+    uint64_t flags = spin_lock(&wq->lock);
+
+    if (!entry->queued) {
+        entry->next = NULL;
+        if (wq->tail == NULL) {
+            wq->head = entry;
+        } else {
+            wq->tail->next = entry;
+        }
+        wq->tail = entry;
+        entry->queued = true;
+    }
+
+    spin_unlock(&wq->lock, flags);
+}
+
+void wait_queue_remove(wait_queue_t *wq, wait_queue_entry_t *entry) {
+    uint64_t flags = spin_lock(&wq->lock);
+
+    if (entry->queued) {
+        wait_queue_unlink(wq, entry);
+    }
+
+    spin_unlock(&wq->lock, flags);
+}
+
+static void wait_queue_wake(wait_queue_t *wq, bool all) {
+    uint64_t flags = spin_lock(&wq->lock);
+
+    wait_queue_entry_t *prev = NULL;
+    wait_queue_entry_t *entry = wq->head;
+    bool woken = false;
+
+    while (entry != NULL) {
+        wait_queue_entry_t *next = entry->next;
+
+        if (entry->func != NULL) {
+            entry->func(entry);
+            prev = entry;
+        } else if (all || !woken) {
+            if (prev == NULL) {
+                wq->head = next;
+            } else {
+                prev->next = next;
+            }
+            if (wq->tail == entry) {
+                wq->tail = prev;
+            }
+            entry->next = NULL;
+            entry->queued = false;
+
+            scheduler_wake(entry->task);
+            woken = true;
+        } else {
+            prev = entry;
+        }
+
+        entry = next;
+    }
+
+    spin_unlock(&wq->lock, flags);
+}
+
+void wait_queue_wake_one(wait_queue_t *wq) {
+    wait_queue_wake(wq, false);
+}
+
+void wait_queue_wake_all(wait_queue_t *wq) {
+    wait_queue_wake(wq, true);
+}
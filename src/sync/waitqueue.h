@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "spinlock.h"
+
+struct task;
+
+typedef struct wait_queue_entry {
+    struct task *task;
+    struct wait_queue_entry *next;
+    bool queued;
+    bool prepared;
+    uint64_t flags;
+    void (*func)(struct wait_queue_entry *entry);
+    void *private;
+} wait_queue_entry_t;
+
+typedef struct {
+    spinlock_t lock;
+    wait_queue_entry_t *head;
+    wait_queue_entry_t *tail;
+} wait_queue_t;
+
+void wait_queue_init(wait_queue_t *wq);
+
+void wait_queue_prepare(wait_queue_t *wq, wait_queue_entry_t *entry, uint64_t deadline);
+void wait_queue_sleep(wait_queue_entry_t *entry);
+void wait_queue_finish(wait_queue_t *wq, wait_queue_entry_t *entry);
+
+void wait_queue_add(wait_queue_t *wq, wait_queue_entry_t *entry);
+void wait_queue_remove(wait_queue_t *wq, wait_queue_entry_t *entry);
+
+uint64_t wait_queue_deadline(uint64_t ms);
+bool wait_queue_expired(uint64_t deadline);
+
+void wait_queue_wake_one(wait_queue_t *wq);
+void wait_queue_wake_all(wait_queue_t *wq);
+
+#define wait_event_deadline(wq, cond, deadline)                                                                        \
+    ({                                                                                                                 \
+        wait_queue_entry_t __entry = {0};                                                                              \
+        uint64_t __deadline = (deadline);                                                                              \
+        bool __done;                                                                                                   \
+        while (1) {                                                                                                    \
+            wait_queue_prepare((wq), &__entry, __deadline);                                                            \
+            if ((__done = (cond)) || wait_queue_expired(__deadline))                                                   \
+                break;                                                                                                 \
+            wait_queue_sleep(&__entry);                                                                                \
+        }                                                                                                              \
+        wait_queue_finish((wq), &__entry);                                                                             \
+        __done;                                                                                                        \
+    })
+
+#define wait_event_timeout(wq, cond, ms) wait_event_deadline(wq, cond, wait_queue_deadline(ms))
+
+#define wait_event(wq, cond) ((void)wait_event_timeout(wq, cond, 0))
@@ -0,0 +1,281 @@
+#include "ring.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../drivers/timer/timer.h"
+#include "../fs/vfs/fdtable.h"
+#include "../fs/vfs/vfs.h"
+#include "../interrupts/interrupts.h"
+#include "../io/terminal.h"
+#include "../mem/alloc/heap.h"
+#include "../mem/alloc/page_frame_alloc.h"
+#include "../mem/paging/paging.h"
+#include "../std/string.h"
+#include "../sync/mutex.h"
+#include "../sync/waitqueue.h"
+#include "../task/scheduler.h"
+#include "../task/task.h"
+#include "syscall.h"
+
+#define RING_POLLER_STACK_SIZE 8192
+#define RING_MAX_PAGES 8
+
+typedef struct ring {
+    ring_shared_t *shared;
+    ring_sqe_t *sqes;
+    ring_cqe_t *cqes;
+
+    uint32_t sq_head;
+    uint32_t sq_mask;
+    uint32_t cq_tail;
+    uint32_t cq_mask;
+    uint32_t cq_entries;
+    uint32_t flags;
+
+    mutex_t submit_lock;
+    wait_queue_t sq_wq;
+    wait_queue_t cq_wq;
+
+    task_t *poller;
+    volatile bool stopping;
+    volatile bool poller_done;
+} ring_t;
+
+static int64_t ring_execute(ring_sqe_t *sqe) {
+    switch (sqe->opcode) {
+    case RING_OP_NOP:
+        return 0;
+    case RING_OP_READ:
+        return syscall_read(sqe->fd, (void *)sqe->addr, sqe->len);
+    case RING_OP_WRITE:
+        return syscall_write(sqe->fd, (const void *)sqe->addr, sqe->len);
+    case RING_OP_OPEN:
+        return vfs_open((const char *)sqe->addr, (int)sqe->len);
+    case RING_OP_CLOSE:
+        return vfs_close(sqe->fd);
+    case RING_OP_SEEK:
+        return vfs_seek(sqe->fd, sqe->off, (int)sqe->len);
+    case RING_OP_READDIR:
+        return vfs_readdir(sqe->fd, (char *)sqe->addr, sqe->len);
+    case RING_OP_STAT:
+        return vfs_stat((const char *)sqe->addr, (vfs_stat_t *)sqe->addr2);
+    default:
+        return -1;
+    }
+}
+
+static bool ring_sq_pending(ring_t *ring) {
+    return __atomic_load_n(&ring->shared->sq_tail, __ATOMIC_ACQUIRE) != ring->sq_head;
+}
+
+static uint32_t ring_cq_ready(ring_t *ring) {
+    return ring->cq_tail - __atomic_load_n(&ring->shared->cq_head, __ATOMIC_ACQUIRE);
+}
+
+static uint32_t ring_submit(ring_t *ring, uint32_t max) {
+    uint32_t submitted = 0;
+
+    mutex_lock(&ring->submit_lock);
+
+    uint32_t tail = __atomic_load_n(&ring->shared->sq_tail, __ATOMIC_ACQUIRE);
+    while (ring->sq_head != tail && submitted < max) {
+        if (ring_cq_ready(ring) >= ring->cq_entries)
+            break;
+
+        ring_sqe_t sqe = ring->sqes[ring->sq_head & ring->sq_mask];
+        ring->sq_head++;
+        __atomic_store_n(&ring->shared->sq_head, ring->sq_head, __ATOMIC_RELEASE);
+
+        int64_t res = ring_execute(&sqe);
+
+        ring_cqe_t *cqe = &ring->cqes[ring->cq_tail & ring->cq_mask];
+        cqe->user_data = sqe.user_data;
+        cqe->res = res;
+        ring->cq_tail++;
+        __atomic_store_n(&ring->shared->cq_tail, ring->cq_tail, __ATOMIC_RELEASE);
+
+        submitted++;
+    }
+
+    mutex_unlock(&ring->submit_lock);
+
+    if (submitted > 0)
+        wait_queue_wake_all(&ring->cq_wq);
+
+    return submitted;
+}
+
+static void ring_poller() {
+    ring_t *ring = (ring_t *)task_current()->thread_arg;
+
+    uint64_t idle_ticks = (RING_SQPOLL_IDLE_MS * timer_get_frequency()) / 1000;
+    if (idle_ticks == 0)
+        idle_ticks = 1;
+    uint64_t last_work = timer_get_ticks();
+
+    while (!ring->stopping) {
+        if (ring_submit(ring, UINT32_MAX) > 0) {
+            last_work = timer_get_ticks();
+            continue;
+        }
+
+        if (timer_get_ticks() - last_work < idle_ticks) {
+            task_yield();
+            continue;
+        }
+
+        __atomic_or_fetch(&ring->shared->sq_flags, RING_SQ_NEED_WAKEUP, __ATOMIC_SEQ_CST);
+        wait_event(&ring->sq_wq, ring->stopping || ring_sq_pending(ring));
+        __atomic_and_fetch(&ring->shared->sq_flags, ~RING_SQ_NEED_WAKEUP, __ATOMIC_SEQ_CST);
+
+        last_work = timer_get_ticks();
+    }
+
+    page_table_t *kernel_pml4 = page_get_pml4();
+    uint64_t kernel_cr3 = (uint64_t)kernel_pml4 - page_get_offset();
+
+    cli();
+    task_current()->page_table = kernel_pml4;
+    __asm__ volatile("mov %0, %%cr3" : : "r"(kernel_cr3) : "memory");
+    sti();
+
+    wait_queue_wake_all(&ring->cq_wq);
+    __atomic_store_n(&ring->poller_done, true, __ATOMIC_RELEASE);
+
+    task_exit(0);
+}
+
+uint64_t ring_create(uint32_t entries, uint32_t flags) {
+    task_t *current = task_current();
+
+    if (current->ring != NULL) {
+        printkf_error("ring_create(): ring already set up\n");
+        return (uint64_t)-1;
+    }
+    if (task_has_threads(current)) {
+        printkf_error("ring_create(): not supported from a multi-threaded process\n");
+        return (uint64_t)-1;
+    }
+    if (entries == 0 || entries > RING_MAX_ENTRIES) {
+        printkf_error("ring_create(): invalid entry count %u\n", entries);
+        return (uint64_t)-1;
+    }
+
+    uint32_t sq_entries = 1;
+    while (sq_entries < entries)
+        sq_entries <<= 1;
+    uint32_t cq_entries = sq_entries * 2;
+
+    uint64_t sqes_offset = PAGE_SIZE;
+    uint64_t cqes_offset = sqes_offset + ((sq_entries * sizeof(ring_sqe_t) + PAGE_SIZE - 1) & ~(uint64_t)(PAGE_SIZE - 1));
+    uint64_t size = cqes_offset + ((cq_entries * sizeof(ring_cqe_t) + PAGE_SIZE - 1) & ~(uint64_t)(PAGE_SIZE - 1));
+    uint32_t page_count = size / PAGE_SIZE;
+
+    ring_t *ring = (ring_t *)malloc(sizeof(ring_t));
+    if (ring == NULL) {
+        printkf_error("ring_create(): failed to allocate ring\n");
+        return (uint64_t)-1;
+    }
+    memset(ring, 0, sizeof(ring_t));
+
+    void *pages[RING_MAX_PAGES] = {0};
+    for (uint32_t i = 0; i < page_count; i++) {
+        pages[i] = pfallocator_request_zeroed_page();
+        if (pages[i] == NULL) {
+            printkf_error("ring_create(): out of memory\n");
+            for (uint32_t j = 0; j < i; j++) {
+                pfallocator_free_page(pages[j]);
+            }
+            free(ring);
+            return (uint64_t)-1;
+        }
+    }
+
+    uint64_t hhdm_offset = page_get_offset();
+    for (uint32_t i = 0; i < page_count; i++) {
+        void *virt = (void *)(RING_USER_BASE + (uint64_t)i * PAGE_SIZE);
+        page_map_memory_to(current->page_table, virt, (void *)((uint64_t)pages[i] - hhdm_offset));
+    }
+
+    ring_shared_t *shared = (ring_shared_t *)pages[0];
+    shared->sq_mask = sq_entries - 1;
+    shared->sq_entries = sq_entries;
+    shared->cq_mask = cq_entries - 1;
+    shared->cq_entries = cq_entries;
+    shared->sqes_offset = sqes_offset;
+    shared->cqes_offset = cqes_offset;
+    shared->size = size;
+
+    ring->shared = (ring_shared_t *)RING_USER_BASE;
+    ring->sqes = (ring_sqe_t *)(RING_USER_BASE + sqes_offset);
+    ring->cqes = (ring_cqe_t *)(RING_USER_BASE + cqes_offset);
+    ring->sq_mask = sq_entries - 1;
+    ring->cq_mask = cq_entries - 1;
+    ring->cq_entries = cq_entries;
+    ring->flags = flags;
+    mutex_init(&ring->submit_lock);
+    wait_queue_init(&ring->sq_wq);
+    wait_queue_init(&ring->cq_wq);
+
+    if (flags & RING_SETUP_SQPOLL) {
+        task_t *poller = task_create(ring_poller, RING_POLLER_STACK_SIZE);
+        if (poller == NULL) {
+            printkf_error("ring_create(): failed to create SQ poller\n");
+            free(ring);
+            return (uint64_t)-1;
+        }
+
+        poller->page_table = current->page_table;
+        poller->thread_arg = (uint64_t)ring;
+        poller->fds = current->fds;
+        if (poller->fds != NULL)
+            fd_table_get(poller->fds);
+        ring->poller = poller;
+    }
+
+    current->ring = ring;
+    if (ring->poller != NULL)
+        scheduler_add_task(ring->poller);
+
+    return RING_USER_BASE;
+}
+
+int64_t ring_submit_and_wait(uint32_t to_submit, uint32_t min_complete, uint32_t flags) {
+    ring_t *ring = task_current()->ring;
+    if (ring == NULL)
+        return -1;
+
+    int64_t submitted = 0;
+    if (ring->poller != NULL) {
+        if (flags & RING_ENTER_SQ_WAKEUP)
+            wait_queue_wake_all(&ring->sq_wq);
+    } else if (to_submit > 0) {
+        submitted = ring_submit(ring, to_submit);
+    }
+
+    if ((flags & RING_ENTER_GETEVENTS) && min_complete > 0) {
+        if (min_complete > ring->cq_entries)
+            min_complete = ring->cq_entries;
+        wait_event(&ring->cq_wq, ring_cq_ready(ring) >= min_complete);
+    }
+
+    return submitted;
+}
+
+void ring_destroy(task_t *task) {
+    ring_t *ring = task->ring;
+    if (ring == NULL)
+        return;
+
+    if (ring->poller != NULL) {
+        ring->stopping = true;
+        wait_queue_wake_all(&ring->sq_wq);
+        while (!__atomic_load_n(&ring->poller_done, __ATOMIC_ACQUIRE)) {
+            wait_event_timeout(&ring->cq_wq, ring->poller_done, 10);
+        }
+    }
+
+    task->ring = NULL;
+    free(ring);
+}
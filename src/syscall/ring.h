@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+
+#define RING_MAX_ENTRIES 256
+#define RING_USER_BASE 0x7FFE00000000ULL
+
+#define RING_SETUP_SQPOLL (1 << 0)
+
+#define RING_ENTER_GETEVENTS (1 << 0)
+#define RING_ENTER_SQ_WAKEUP (1 << 1)
+
+#define RING_SQ_NEED_WAKEUP (1 << 0)
+
+#define RING_SQPOLL_IDLE_MS 20
+
+typedef enum {
+    RING_OP_NOP,
+    RING_OP_READ,
+    RING_OP_WRITE,
+    RING_OP_OPEN,
+    RING_OP_CLOSE,
+    RING_OP_SEEK,
+    RING_OP_READDIR,
+    RING_OP_STAT,
+} ring_op_t;
+
+typedef struct {
+    uint8_t opcode;
+    uint8_t flags;
+    uint16_t reserved;
+    int32_t fd;
+    uint64_t addr;
+    uint64_t addr2;
+    uint64_t len;
+    int64_t off;
+    uint64_t user_data;
+} ring_sqe_t;
+
+typedef struct {
+    uint64_t user_data;
+    int64_t res;
+} ring_cqe_t;
+
+typedef struct {
+    volatile uint32_t sq_head;
+    volatile uint32_t sq_tail;
+    uint32_t sq_mask;
+    uint32_t sq_entries;
+    volatile uint32_t sq_flags;
+    uint32_t reserved;
+
+    volatile uint32_t cq_head;
+    volatile uint32_t cq_tail;
+    uint32_t cq_mask;
+    uint32_t cq_entries;
+
+    uint64_t sqes_offset;
+    uint64_t cqes_offset;
+    uint64_t size;
+} ring_shared_t;
+
+struct task;
+
+uint64_t ring_create(uint32_t entries, uint32_t flags);
+int64_t ring_submit_and_wait(uint32_t to_submit, uint32_t min_complete, uint32_t flags);
+void ring_destroy(struct task *task);
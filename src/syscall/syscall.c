@@ -1,39 +1,42 @@
 #include "syscall.h"
 
+#include "../arch/x86_64/cpu/cpu.h"
+#include "../arch/x86_64/fpu/fpu.h"
 #include "../drivers/keyboard/keyboard.h"
+#include "../drivers/timer/tsc.h"
 #include "../elf/elf.h"
+#include "../fs/vfs/fdtable.h"
+#include "../fs/vfs/page_cache.h"
 #include "../fs/vfs/vfs.h"
 #include "../io/terminal.h"
+#include "../ipc/pipe.h"
+#include "../ipc/poll.h"
+#include "../ipc/shm.h"
+#include "../ipc/socket.h"
 #include "../mem/alloc/heap.h"
+#include "../mem/alloc/page_frame_alloc.h"
 #include "../mem/paging/page_table_manager.h"
 #include "../mem/paging/paging.h"
 #include "../std/string.h"
+#include "../sync/futex.h"
+#include "../task/idle.h"
+#include "../task/scheduler.h"
 #include "../task/task.h"
 #include "../usermode/usermode.h"
-
-#define MSR_EFER 0xC0000080
-#define MSR_STAR 0xC0000081
-#define MSR_LSTAR 0xC0000082
-#define MSR_SFMASK 0xC0000084
+#include "ring.h"
+#include "trace.h"
 
 #define EFER_SCE (1 << 0)
 
 extern void syscall_entry();
 
-static inline void wrmsr(uint32_t msr, uint64_t value) {
-    uint32_t low = value & 0xffffffff;
-    uint32_t high = value >> 32;
-    __asm__ volatile("wrmsr" : : "c"(msr), "a"(low), "d"(high));
-}
-
-static inline uint64_t rdmsr(uint32_t msr) {
-    uint32_t low, high;
-    __asm__ volatile("rdmsr" : "=a"(low), "=d"(high) : "c"(msr));
-    return ((uint64_t)high << 32) | low;
-}
-
 void syscall_init() {
     printkf_info("Enabling syscalls...\n");
+    syscall_init_cpu();
+    printkf_ok("Syscalls enabled\n");
+}
+
+void syscall_init_cpu() {
     uint64_t efer = rdmsr(MSR_EFER);
     efer |= EFER_SCE;
     wrmsr(MSR_EFER, efer);
@@ -46,34 +49,99 @@ void syscall_init() {
     wrmsr(MSR_LSTAR, (uint64_t)syscall_entry);
 
     wrmsr(MSR_SFMASK, 0x200);
+}
 
-    printkf_ok("Syscalls enabled\n");
+#define SYSCALL_DEFINE(name)                                                                                           \
+    static uint64_t sys_##name(__attribute__((unused)) uint64_t arg1, __attribute__((unused)) uint64_t arg2,           \
+                               __attribute__((unused)) uint64_t arg3, __attribute__((unused)) uint64_t arg4)
+
+typedef uint64_t (*syscall_fn_t)(uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4);
+
+typedef struct {
+    const char *name;
+    syscall_fn_t fn;
+    uint8_t nargs;
+    uint8_t args[SYSCALL_MAX_ARGS];
+} syscall_desc_t;
+
+typedef struct {
+    volatile uint64_t calls;
+    volatile uint64_t errors;
+    volatile uint64_t total_ns;
+    volatile uint64_t max_ns;
+} syscall_counters_t;
+
+static syscall_counters_t syscall_counters[SYSCALL_COUNT];
+
+static bool syscall_console_fd(int fd) {
+    if (fd < 0 || fd >= FD_FIRST)
+        return false;
+
+    task_t *current = task_current();
+    if (current->fds == NULL)
+        return true;
+
+    vfs_file_t *file = fd_get(current->fds, fd);
+    if (file == NULL)
+        return true;
+
+    vfs_file_put(file);
+    return false;
+}
+
+int64_t syscall_write(int fd, const void *buf, size_t size) {
+    if ((fd == 1 || fd == 2) && syscall_console_fd(fd)) {
+        const char *chars = (const char *)buf;
+        for (size_t i = 0; i < size; i++) {
+            putkc(chars[i]);
+        }
+        return size;
+    }
+
+    return vfs_write(fd, buf, size);
+}
+
+int64_t syscall_read(int fd, void *buf, size_t size) {
+    if (fd == 0 && syscall_console_fd(fd)) {
+        char *chars = (char *)buf;
+        size_t i = 0;
+        while (i < size) {
+            char c = keyboard_getchar();
+            chars[i++] = c;
+            if (c == '\n')
+                break;
+        }
+        return i;
+    }
+
+    return vfs_read(fd, buf, size);
 }
 
-static int sys_exec(const char *path) {
-    int fd = vfs_open(path, O_RDONLY);
-    if (fd < 0) {
+SYSCALL_DEFINE(exec) {
+    const char *path = (const char *)arg1;
+
+    vfs_file_t *file = vfs_file_open(path, O_RDONLY);
+    if (file == NULL) {
         printkf_error("exec: failed to open '%s'\n", path);
         return -1;
     }
 
-    int64_t size = vfs_seek(fd, 0, SEEK_END);
+    int64_t size = file->node->inode->size;
     if (size <= 0) {
-        vfs_close(fd);
+        vfs_file_put(file);
         printkf_error("exec: failed to get size of '%s'\n", path);
         return -1;
     }
-    vfs_seek(fd, 0, SEEK_SET);
 
     void *elf_data = malloc(size);
     if (elf_data == NULL) {
-        vfs_close(fd);
+        vfs_file_put(file);
         printkf_error("exec: out of memory\n");
         return -1;
     }
 
-    int64_t bytes_read = vfs_read(fd, elf_data, size);
-    vfs_close(fd);
+    int64_t bytes_read = vfs_file_pread(file, elf_data, size, 0);
+    vfs_file_put(file);
 
     if (bytes_read != size) {
         free(elf_data);
@@ -88,6 +156,13 @@ static int sys_exec(const char *path) {
         return -1;
     }
 
+    if (task_has_threads(current)) {
+        free(elf_data);
+        printkf_error("exec: not supported from a multi-threaded process\n");
+        return -1;
+    }
+    thread_group_collapse(current);
+
     page_table_t *new_page_table = page_table_create_user();
     if (new_page_table == NULL) {
         free(elf_data);
@@ -104,20 +179,30 @@ static int sys_exec(const char *path) {
 
     free(elf_data);
 
+    ring_destroy(current);
+    if (current->fds != NULL)
+        fd_table_close_on_exec(current->fds);
+
     page_table_t *old_page_table = current->page_table;
     current->page_table = new_page_table;
     current->entry_point = (void (*)())entry_point;
 
     uint64_t hhdm_offset = page_get_offset();
     void *phys_page = (void *)((uint64_t)current->user_stack - hhdm_offset);
+    pfallocator_ref_page(current->user_stack);
     page_map_memory_to(new_page_table, (void *)current->user_stack_virt, phys_page);
     memset(current->user_stack, 0, 0x1000);
 
     uint64_t new_cr3_phys = (uint64_t)new_page_table - hhdm_offset;
+    cli();
+    __atomic_store_n(&cpu_current()->page_table, new_page_table, __ATOMIC_SEQ_CST);
     __asm__ volatile("mov %0, %%cr3" : : "r"(new_cr3_phys) : "memory");
+    sti();
 
     page_table_destroy_user(old_page_table);
 
+    fpu_release(current);
+
     uint64_t user_rsp = current->user_stack_virt + current->user_stack_size;
     user_rsp &= ~0xFULL;
 
@@ -126,103 +211,577 @@ static int sys_exec(const char *path) {
     return 0;
 }
 
-uint64_t syscall_handler(uint64_t syscall, uint64_t arg1, uint64_t arg2, uint64_t arg3) {
-    switch (syscall) {
-    case SYS_EXIT: {
-        task_exit(arg1);
-        return 0;
-    }
-    case SYS_YIELD: {
-        task_yield();
-        return 0;
-    }
-    case SYS_SLEEP: {
-        sleep_ms(arg1);
-        return 0;
+static task_t *syscall_owned_task(uint32_t pid, const char *func) {
+    task_t *current = task_current();
+    task_t *target = task_get(pid == 0 ? current->pid : pid);
+    if (target == NULL)
+        return NULL;
+
+    if (!task_owned_by(target, current)) {
+        printkf_error("%s(): pid %u is not owned by the caller\n", func, pid);
+        task_put(target);
+        return NULL;
     }
-    case SYS_GETPID: {
-        task_t *current = task_current();
-        return current ? current->pid : 0;
-    }
-    case SYS_EXEC: {
-        const char *path = (const char *)arg1;
-        return sys_exec(path);
-    }
-    case SYS_FORK: {
-        task_t *child = task_fork();
-        return child ? child->pid : (uint64_t)-1;
-    }
-    case SYS_WAITPID: {
-        uint32_t pid = (uint32_t)arg1;
-        int result = task_waitpid(pid);
-        return result;
-    }
-    case SYS_WRITE: {
-        int fd = (int)arg1;
-        const char *buf = (const char *)arg2;
-        size_t size = (size_t)arg3;
-
-        if (fd == 1 || fd == 2) {
-            for (size_t i = 0; i < size; i++) {
-                putkc(buf[i]);
-            }
-            return size;
-        }
 
-        return vfs_write(fd, buf, size);
-    }
-    case SYS_READ: {
-        int fd = (int)arg1;
-        char *buf = (char *)arg2;
-        size_t size = (size_t)arg3;
-        
-        if (fd == 0) {
-            size_t i = 0;
-            while (i < size) {
-                char c = keyboard_getchar();
-                buf[i++] = c;
-                if (c == '\n')
-                    break;
-            }
-            return i;
-        }
+    return target;
+}
 
-        return vfs_read(fd, buf, size);
-    }
-    case SYS_OPEN: {
-        const char *path = (const char *)arg1;
-        int flags = (int)arg2;
-        return vfs_open(path, flags);
+SYSCALL_DEFINE(exit) {
+    task_exit(arg1);
+    return 0;
+}
+
+SYSCALL_DEFINE(yield) {
+    task_yield();
+    return 0;
+}
+
+SYSCALL_DEFINE(sleep) {
+    sleep_ms(arg1);
+    return 0;
+}
+
+SYSCALL_DEFINE(getpid) {
+    task_t *current = task_current();
+    return current ? current->pid : 0;
+}
+
+SYSCALL_DEFINE(fork) {
+    task_t *child = task_fork();
+    return child ? child->pid : (uint64_t)-1;
+}
+
+SYSCALL_DEFINE(waitpid) {
+    uint32_t pid = (uint32_t)arg1;
+    return task_waitpid(pid);
+}
+
+SYSCALL_DEFINE(write) {
+    int fd = (int)arg1;
+    const char *buf = (const char *)arg2;
+    size_t size = (size_t)arg3;
+    return syscall_write(fd, buf, size);
+}
+
+SYSCALL_DEFINE(read) {
+    int fd = (int)arg1;
+    char *buf = (char *)arg2;
+    size_t size = (size_t)arg3;
+    return syscall_read(fd, buf, size);
+}
+
+SYSCALL_DEFINE(open) {
+    const char *path = (const char *)arg1;
+    int flags = (int)arg2;
+    return vfs_open(path, flags);
+}
+
+SYSCALL_DEFINE(close) {
+    int fd = (int)arg1;
+    return vfs_close(fd);
+}
+
+SYSCALL_DEFINE(seek) {
+    int fd = (int)arg1;
+    int64_t offset = (int64_t)arg2;
+    int whence = (int)arg3;
+    return vfs_seek(fd, offset, whence);
+}
+
+SYSCALL_DEFINE(stat) {
+    const char *path = (const char *)arg1;
+    vfs_stat_t *stat = (vfs_stat_t *)arg2;
+    return vfs_stat(path, stat);
+}
+
+SYSCALL_DEFINE(pread) {
+    int fd = (int)arg1;
+    void *buf = (void *)arg2;
+    size_t size = (size_t)arg3;
+    size_t offset = (size_t)arg4;
+    return vfs_pread(fd, buf, size, offset);
+}
+
+SYSCALL_DEFINE(pwrite) {
+    int fd = (int)arg1;
+    const void *buf = (const void *)arg2;
+    size_t size = (size_t)arg3;
+    size_t offset = (size_t)arg4;
+    return vfs_pwrite(fd, buf, size, offset);
+}
+
+SYSCALL_DEFINE(readv) {
+    int fd = (int)arg1;
+    const vfs_iovec_t *iov = (const vfs_iovec_t *)arg2;
+    int iovcnt = (int)arg3;
+
+    if (fd != 0 || !syscall_console_fd(fd))
+        return vfs_readv(fd, iov, iovcnt);
+
+    if (iovcnt <= 0 || iovcnt > VFS_IOV_MAX)
+        return -1;
+
+    int64_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        int64_t bytes = syscall_read(fd, iov[i].base, iov[i].len);
+        total += bytes;
+        if ((size_t)bytes < iov[i].len)
+            break;
     }
-    case SYS_CLOSE: {
-        int fd = (int)arg1;
-        return vfs_close(fd);
+    return total;
+}
+
+SYSCALL_DEFINE(writev) {
+    int fd = (int)arg1;
+    const vfs_iovec_t *iov = (const vfs_iovec_t *)arg2;
+    int iovcnt = (int)arg3;
+
+    if ((fd != 1 && fd != 2) || !syscall_console_fd(fd))
+        return vfs_writev(fd, iov, iovcnt);
+
+    if (iovcnt <= 0 || iovcnt > VFS_IOV_MAX)
+        return -1;
+
+    int64_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        total += syscall_write(fd, iov[i].base, iov[i].len);
     }
-    case SYS_SEEK: {
-        int fd = (int)arg1;
-        int64_t offset = (int64_t)arg2;
-        int whence = (int)arg3;
-        return vfs_seek(fd, offset, whence);
+    return total;
+}
+
+SYSCALL_DEFINE(fstat) {
+    int fd = (int)arg1;
+    vfs_stat_t *stat = (vfs_stat_t *)arg2;
+    return vfs_fstat(fd, stat);
+}
+
+SYSCALL_DEFINE(getdents) {
+    int fd = (int)arg1;
+    void *buf = (void *)arg2;
+    size_t size = (size_t)arg3;
+    return vfs_getdents(fd, buf, size);
+}
+
+SYSCALL_DEFINE(fcntl) {
+    int fd = (int)arg1;
+    int cmd = (int)arg2;
+    int arg = (int)arg3;
+
+    task_t *current = task_current();
+    if (current->fds == NULL)
+        return -1;
+    return fd_fcntl(current->fds, fd, cmd, arg);
+}
+
+SYSCALL_DEFINE(pipe) {
+    int *fds = (int *)arg1;
+    int flags = (int)arg2;
+    return pipe_create(fds, flags);
+}
+
+SYSCALL_DEFINE(dup2) {
+    int oldfd = (int)arg1;
+    int newfd = (int)arg2;
+
+    task_t *current = task_current();
+    if (current->fds == NULL)
+        return -1;
+    return fd_dup2(current->fds, oldfd, newfd);
+}
+
+SYSCALL_DEFINE(shm_open) {
+    const char *name = (const char *)arg1;
+    int flags = (int)arg2;
+    return shm_open_object(name, flags);
+}
+
+SYSCALL_DEFINE(shm_unlink) {
+    const char *name = (const char *)arg1;
+    return shm_unlink_object(name);
+}
+
+SYSCALL_DEFINE(ftruncate) {
+    int fd = (int)arg1;
+    size_t size = (size_t)arg2;
+    return vfs_ftruncate(fd, size);
+}
+
+SYSCALL_DEFINE(mmap) {
+    void *addr = (void *)arg1;
+    size_t size = (size_t)arg2;
+    int prot = (int)arg3;
+    int fd = (int)arg4;
+    return shm_map(addr, size, prot, fd);
+}
+
+SYSCALL_DEFINE(munmap) {
+    void *addr = (void *)arg1;
+    size_t size = (size_t)arg2;
+    return shm_unmap(addr, size);
+}
+
+SYSCALL_DEFINE(socket) {
+    int flags = (int)arg1;
+    return socket_create(flags);
+}
+
+SYSCALL_DEFINE(bind) {
+    int fd = (int)arg1;
+    const char *path = (const char *)arg2;
+    return socket_bind(fd, path);
+}
+
+SYSCALL_DEFINE(listen) {
+    int fd = (int)arg1;
+    int backlog = (int)arg2;
+    return socket_listen(fd, backlog);
+}
+
+SYSCALL_DEFINE(accept) {
+    int fd = (int)arg1;
+    int flags = (int)arg2;
+    return socket_accept(fd, flags);
+}
+
+SYSCALL_DEFINE(connect) {
+    int fd = (int)arg1;
+    const char *path = (const char *)arg2;
+    return socket_connect(fd, path);
+}
+
+SYSCALL_DEFINE(poll) {
+    pollfd_t *fds = (pollfd_t *)arg1;
+    uint32_t nfds = (uint32_t)arg2;
+    int64_t timeout_ms = (int64_t)arg3;
+    return poll_fds(fds, nfds, timeout_ms);
+}
+
+SYSCALL_DEFINE(epoll_create) {
+    int flags = (int)arg1;
+    return epoll_create_fd(flags);
+}
+
+SYSCALL_DEFINE(epoll_ctl) {
+    int epfd = (int)arg1;
+    int op = (int)arg2;
+    int fd = (int)arg3;
+    const epoll_event_t *event = (const epoll_event_t *)arg4;
+    return epoll_control(epfd, op, fd, event);
+}
+
+SYSCALL_DEFINE(epoll_wait) {
+    int epfd = (int)arg1;
+    epoll_event_t *events = (epoll_event_t *)arg2;
+    int maxevents = (int)arg3;
+    int64_t timeout_ms = (int64_t)arg4;
+    return epoll_wait_events(epfd, events, maxevents, timeout_ms);
+}
+
+SYSCALL_DEFINE(copy_file_range) {
+    int fd_in = (int)arg1;
+    int fd_out = (int)arg2;
+    vfs_copy_range_t *range = (vfs_copy_range_t *)arg3;
+    if (range == NULL)
+        return -1;
+
+    int64_t *off_in = range->off_in >= 0 ? &range->off_in : NULL;
+    int64_t *off_out = range->off_out >= 0 ? &range->off_out : NULL;
+    return vfs_copy_file_range(fd_in, off_in, fd_out, off_out, range->len);
+}
+
+SYSCALL_DEFINE(sendfile) {
+    int out_fd = (int)arg1;
+    int in_fd = (int)arg2;
+    int64_t *offset = (int64_t *)arg3;
+    size_t count = (size_t)arg4;
+    return vfs_sendfile(out_fd, in_fd, offset, count);
+}
+
+SYSCALL_DEFINE(cachestat) {
+    page_cache_stats_t *stats = (page_cache_stats_t *)arg1;
+    if (stats == NULL)
+        return -1;
+
+    page_cache_get_stats(stats);
+    return 0;
+}
+
+SYSCALL_DEFINE(mkdir) {
+    const char *path = (const char *)arg1;
+    return vfs_mkdir(path);
+}
+
+SYSCALL_DEFINE(readdir) {
+    int fd = (int)arg1;
+    char *name = (char *)arg2;
+    size_t size = (size_t)arg3;
+    return vfs_readdir(fd, name, size);
+}
+
+SYSCALL_DEFINE(unlink) {
+    const char *path = (const char *)arg1;
+    bool recursive = (bool)arg2;
+    return vfs_unlink(path, recursive);
+}
+
+SYSCALL_DEFINE(thread_create) {
+    void (*entry)() = (void (*)())arg1;
+    uint64_t arg = arg2;
+    uint64_t tls = arg3;
+
+    task_t *thread = task_create_thread(entry, arg, tls);
+    return thread ? thread->pid : (uint64_t)-1;
+}
+
+SYSCALL_DEFINE(thread_join) {
+    uint32_t tid = (uint32_t)arg1;
+    return task_join(tid);
+}
+
+SYSCALL_DEFINE(set_tls) {
+    task_set_fs_base(arg1);
+    return 0;
+}
+
+SYSCALL_DEFINE(sched_setscheduler) {
+    uint32_t pid = (uint32_t)arg1;
+    int policy = (int)arg2;
+    int priority = (int)arg3;
+
+    task_t *target = syscall_owned_task(pid, "sched_setscheduler");
+    if (target == NULL)
+        return -1;
+
+    int ret = scheduler_set_policy(target, policy, priority);
+    task_put(target);
+    return ret;
+}
+
+SYSCALL_DEFINE(futex) {
+    uint32_t *uaddr = (uint32_t *)arg1;
+    int op = (int)arg2;
+    uint32_t val = (uint32_t)arg3;
+
+    switch (op) {
+    case FUTEX_WAIT:
+        return futex_wait(uaddr, val);
+    case FUTEX_WAKE:
+        return futex_wake(uaddr, val);
+    default:
+        return -1;
     }
-    case SYS_MKDIR: {
-        const char *path = (const char *)arg1;
-        return vfs_mkdir(path);
+}
+
+SYSCALL_DEFINE(getrusage) {
+    uint32_t pid = (uint32_t)arg1;
+    rusage_t *usage = (rusage_t *)arg2;
+    int flags = (int)arg3;
+    if (usage == NULL)
+        return -1;
+
+    task_t *target;
+    if (flags & RUSAGE_NEXT) {
+        target = task_get_next(pid);
+    } else {
+        target = task_get(pid == 0 ? task_current()->pid : pid);
     }
-    case SYS_READDIR: {
-        int fd = (int)arg1;
-        char *name = (char *)arg2;
-        size_t size = (size_t)arg3;
-        return vfs_readdir(fd, name, size);
+    if (target == NULL)
+        return -1;
+
+    rusage_t snapshot;
+    int ret = scheduler_get_rusage(target, &snapshot);
+    task_put(target);
+    if (ret < 0)
+        return -1;
+
+    *usage = snapshot;
+    return snapshot.pid;
+}
+
+SYSCALL_DEFINE(cpustat) {
+    uint32_t id = (uint32_t)arg1;
+    cpustat_t *stat = (cpustat_t *)arg2;
+    return idle_get_cpustat(id, stat);
+}
+
+SYSCALL_DEFINE(ring_setup) {
+    uint32_t entries = (uint32_t)arg1;
+    uint32_t flags = (uint32_t)arg2;
+    return ring_create(entries, flags);
+}
+
+SYSCALL_DEFINE(ring_enter) {
+    uint32_t to_submit = (uint32_t)arg1;
+    uint32_t min_complete = (uint32_t)arg2;
+    uint32_t flags = (uint32_t)arg3;
+    return ring_submit_and_wait(to_submit, min_complete, flags);
+}
+
+SYSCALL_DEFINE(syscall_stat);
+
+SYSCALL_DEFINE(trace) {
+    uint32_t pid = (uint32_t)arg1;
+    int mode = (int)arg2;
+
+    task_t *target = syscall_owned_task(pid, "trace");
+    if (target == NULL)
+        return -1;
+
+    int ret = trace_set(target, mode);
+    task_put(target);
+    return ret;
+}
+
+SYSCALL_DEFINE(trace_read) {
+    uint32_t pid = (uint32_t)arg1;
+    trace_record_t *records = (trace_record_t *)arg2;
+    uint32_t count = (uint32_t)arg3;
+
+    task_t *target = syscall_owned_task(pid, "trace_read");
+    if (target == NULL)
+        return -1;
+
+    int copied = trace_read(target, records, count);
+    if (copied == 0 && target->state == TASK_TERMINATED)
+        copied = -1;
+    task_put(target);
+    return copied;
+}
+
+static const syscall_desc_t syscall_table[SYSCALL_COUNT] = {
+    [SYS_EXIT] = {"exit", sys_exit, 1, {SYSCALL_ARG_INT}},
+    [SYS_WRITE] = {"write", sys_write, 3, {SYSCALL_ARG_FD, SYSCALL_ARG_PTR, SYSCALL_ARG_UINT}},
+    [SYS_READ] = {"read", sys_read, 3, {SYSCALL_ARG_FD, SYSCALL_ARG_PTR, SYSCALL_ARG_UINT}},
+    [SYS_YIELD] = {"yield", sys_yield, 0, {0}},
+    [SYS_SLEEP] = {"sleep", sys_sleep, 1, {SYSCALL_ARG_UINT}},
+    [SYS_GETPID] = {"getpid", sys_getpid, 0, {0}},
+    [SYS_EXEC] = {"exec", sys_exec, 1, {SYSCALL_ARG_STR}},
+    [SYS_FORK] = {"fork", sys_fork, 0, {0}},
+    [SYS_WAITPID] = {"waitpid", sys_waitpid, 1, {SYSCALL_ARG_INT}},
+    [SYS_OPEN] = {"open", sys_open, 2, {SYSCALL_ARG_STR, SYSCALL_ARG_HEX}},
+    [SYS_CLOSE] = {"close", sys_close, 1, {SYSCALL_ARG_FD}},
+    [SYS_SEEK] = {"seek", sys_seek, 3, {SYSCALL_ARG_FD, SYSCALL_ARG_INT, SYSCALL_ARG_INT}},
+    [SYS_MKDIR] = {"mkdir", sys_mkdir, 1, {SYSCALL_ARG_STR}},
+    [SYS_READDIR] = {"readdir", sys_readdir, 3, {SYSCALL_ARG_FD, SYSCALL_ARG_PTR, SYSCALL_ARG_UINT}},
+    [SYS_STAT] = {"stat", sys_stat, 2, {SYSCALL_ARG_STR, SYSCALL_ARG_PTR}},
+    [SYS_UNLINK] = {"unlink", sys_unlink, 2, {SYSCALL_ARG_STR, SYSCALL_ARG_INT}},
+    [SYS_FUTEX] = {"futex", sys_futex, 3, {SYSCALL_ARG_PTR, SYSCALL_ARG_INT, SYSCALL_ARG_UINT}},
+    [SYS_THREAD_CREATE] = {"thread_create", sys_thread_create, 3, {SYSCALL_ARG_PTR, SYSCALL_ARG_HEX, SYSCALL_ARG_PTR}},
+    [SYS_THREAD_EXIT] = {"thread_exit", sys_exit, 1, {SYSCALL_ARG_INT}},
+    [SYS_THREAD_JOIN] = {"thread_join", sys_thread_join, 1, {SYSCALL_ARG_UINT}},
+    [SYS_SET_TLS] = {"set_tls", sys_set_tls, 1, {SYSCALL_ARG_PTR}},
+    [SYS_SCHED_SETSCHEDULER] = {"sched_setscheduler", sys_sched_setscheduler, 3,
+                                {SYSCALL_ARG_UINT, SYSCALL_ARG_INT, SYSCALL_ARG_INT}},
+    [SYS_GETRUSAGE] = {"getrusage", sys_getrusage, 3, {SYSCALL_ARG_UINT, SYSCALL_ARG_PTR, SYSCALL_ARG_HEX}},
+    [SYS_CPUSTAT] = {"cpustat", sys_cpustat, 2, {SYSCALL_ARG_UINT, SYSCALL_ARG_PTR}},
+    [SYS_RING_SETUP] = {"ring_setup", sys_ring_setup, 2, {SYSCALL_ARG_UINT, SYSCALL_ARG_HEX}},
+    [SYS_RING_ENTER] = {"ring_enter", sys_ring_enter, 3, {SYSCALL_ARG_UINT, SYSCALL_ARG_UINT, SYSCALL_ARG_HEX}},
+    [SYS_SYSCALL_STAT] = {"syscall_stat", sys_syscall_stat, 2, {SYSCALL_ARG_UINT, SYSCALL_ARG_PTR}},
+    [SYS_TRACE] = {"trace", sys_trace, 2, {SYSCALL_ARG_UINT, SYSCALL_ARG_INT}},
+    [SYS_TRACE_READ] = {"trace_read", sys_trace_read, 3, {SYSCALL_ARG_UINT, SYSCALL_ARG_PTR, SYSCALL_ARG_UINT}},
+    [SYS_PREAD] = {"pread", sys_pread, 4, {SYSCALL_ARG_FD, SYSCALL_ARG_PTR, SYSCALL_ARG_UINT, SYSCALL_ARG_UINT}},
+    [SYS_PWRITE] = {"pwrite", sys_pwrite, 4, {SYSCALL_ARG_FD, SYSCALL_ARG_PTR, SYSCALL_ARG_UINT, SYSCALL_ARG_UINT}},
+    [SYS_READV] = {"readv", sys_readv, 3, {SYSCALL_ARG_FD, SYSCALL_ARG_PTR, SYSCALL_ARG_INT}},
+    [SYS_WRITEV] = {"writev", sys_writev, 3, {SYSCALL_ARG_FD, SYSCALL_ARG_PTR, SYSCALL_ARG_INT}},
+    [SYS_FSTAT] = {"fstat", sys_fstat, 2, {SYSCALL_ARG_FD, SYSCALL_ARG_PTR}},
+    [SYS_GETDENTS] = {"getdents", sys_getdents, 3, {SYSCALL_ARG_FD, SYSCALL_ARG_PTR, SYSCALL_ARG_UINT}},
+    [SYS_FCNTL] = {"fcntl", sys_fcntl, 3, {SYSCALL_ARG_FD, SYSCALL_ARG_INT, SYSCALL_ARG_HEX}},
+    [SYS_PIPE] = {"pipe", sys_pipe, 2, {SYSCALL_ARG_PTR, SYSCALL_ARG_HEX}},
+    [SYS_DUP2] = {"dup2", sys_dup2, 2, {SYSCALL_ARG_FD, SYSCALL_ARG_FD}},
+    [SYS_SHM_OPEN] = {"shm_open", sys_shm_open, 2, {SYSCALL_ARG_STR, SYSCALL_ARG_HEX}},
+    [SYS_SHM_UNLINK] = {"shm_unlink", sys_shm_unlink, 1, {SYSCALL_ARG_STR}},
+    [SYS_FTRUNCATE] = {"ftruncate", sys_ftruncate, 2, {SYSCALL_ARG_FD, SYSCALL_ARG_UINT}},
+    [SYS_MMAP] = {"mmap", sys_mmap, 4, {SYSCALL_ARG_PTR, SYSCALL_ARG_UINT, SYSCALL_ARG_HEX, SYSCALL_ARG_FD}},
+    [SYS_MUNMAP] = {"munmap", sys_munmap, 2, {SYSCALL_ARG_PTR, SYSCALL_ARG_UINT}},
+    [SYS_SOCKET] = {"socket", sys_socket, 1, {SYSCALL_ARG_HEX}},
+    [SYS_BIND] = {"bind", sys_bind, 2, {SYSCALL_ARG_FD, SYSCALL_ARG_STR}},
+    [SYS_LISTEN] = {"listen", sys_listen, 2, {SYSCALL_ARG_FD, SYSCALL_ARG_INT}},
+    [SYS_ACCEPT] = {"accept", sys_accept, 2, {SYSCALL_ARG_FD, SYSCALL_ARG_HEX}},
+    [SYS_CONNECT] = {"connect", sys_connect, 2, {SYSCALL_ARG_FD, SYSCALL_ARG_STR}},
+    [SYS_POLL] = {"poll", sys_poll, 3, {SYSCALL_ARG_PTR, SYSCALL_ARG_UINT, SYSCALL_ARG_INT}},
+    [SYS_EPOLL_CREATE] = {"epoll_create", sys_epoll_create, 1, {SYSCALL_ARG_HEX}},
+    [SYS_EPOLL_CTL] = {"epoll_ctl", sys_epoll_ctl, 4, {SYSCALL_ARG_FD, SYSCALL_ARG_INT, SYSCALL_ARG_FD, SYSCALL_ARG_PTR}},
+    [SYS_EPOLL_WAIT] = {"epoll_wait", sys_epoll_wait, 4,
+                        {SYSCALL_ARG_FD, SYSCALL_ARG_PTR, SYSCALL_ARG_INT, SYSCALL_ARG_INT}},
+    [SYS_COPY_FILE_RANGE] = {"copy_file_range", sys_copy_file_range, 3, {SYSCALL_ARG_FD, SYSCALL_ARG_FD, SYSCALL_ARG_PTR}},
+    [SYS_SENDFILE] = {"sendfile", sys_sendfile, 4, {SYSCALL_ARG_FD, SYSCALL_ARG_FD, SYSCALL_ARG_PTR, SYSCALL_ARG_UINT}},
+    [SYS_CACHESTAT] = {"cachestat", sys_cachestat, 1, {SYSCALL_ARG_PTR}},
+};
+
+SYSCALL_DEFINE(syscall_stat) {
+    uint32_t nr = (uint32_t)arg1;
+    syscall_stat_t *stat = (syscall_stat_t *)arg2;
+
+    if (nr >= SYSCALL_COUNT)
+        return -1;
+
+    const syscall_desc_t *desc = &syscall_table[nr];
+    syscall_counters_t *counters = &syscall_counters[nr];
+
+    memset(stat, 0, sizeof(syscall_stat_t));
+    if (desc->fn == NULL)
+        return 0;
+
+    strncpy(stat->name, desc->name, SYSCALL_NAME_MAX - 1);
+    stat->nargs = desc->nargs;
+    for (int i = 0; i < SYSCALL_MAX_ARGS; i++) {
+        stat->args[i] = desc->args[i];
     }
-    case SYS_UNLINK: {
-        const char *path = (const char *)arg1;
-        bool recursive = (bool)arg2;
+    stat->calls = counters->calls;
+    stat->errors = counters->errors;
+    stat->total_ns = counters->total_ns;
+    stat->max_ns = counters->max_ns;
+    return 0;
+}
 
-        return vfs_unlink(path, recursive);
+static void syscall_account(uint64_t nr, uint64_t elapsed_ns, uint64_t ret) {
+    syscall_counters_t *counters = &syscall_counters[nr];
+
+    __atomic_fetch_add(&counters->calls, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&counters->total_ns, elapsed_ns, __ATOMIC_RELAXED);
+    if (ret == (uint64_t)-1)
+        __atomic_fetch_add(&counters->errors, 1, __ATOMIC_RELAXED);
+
+    uint64_t max = __atomic_load_n(&counters->max_ns, __ATOMIC_RELAXED);
+    while (elapsed_ns > max &&
+           !__atomic_compare_exchange_n(&counters->max_ns, &max, elapsed_ns, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+static int syscall_str_arg(const syscall_desc_t *desc) {
+    for (int i = 0; i < desc->nargs; i++) {
+        if (desc->args[i] == SYSCALL_ARG_STR)
+            return i;
     }
-    default: {
+    return -1;
+}
+
+uint64_t syscall_handler(uint64_t syscall, uint64_t arg1, uint64_t arg2, uint64_t arg3, syscall_frame_t *frame) {
+    task_t *current = task_current();
+    current->syscall_frame = frame;
+
+    if (syscall >= SYSCALL_COUNT || syscall_table[syscall].fn == NULL) {
         printkf_error("syscall_handler(): unknown syscall: %llu\n", syscall);
         return -1;
     }
+
+    const syscall_desc_t *desc = &syscall_table[syscall];
+
+    uint64_t arg4 = frame->r10;
+
+    if (current->trace != NULL) {
+        uint64_t args[SYSCALL_MAX_ARGS] = {arg1, arg2, arg3, arg4};
+        trace_syscall_enter(current, syscall, args, syscall_str_arg(desc));
     }
+
+    uint64_t start = tsc_read();
+    uint64_t ret = desc->fn(arg1, arg2, arg3, arg4);
+    uint64_t elapsed_ns = tsc_to_ns(tsc_read() - start);
+
+    syscall_account(syscall, elapsed_ns, ret);
+
+    if (current->trace != NULL)
+        trace_syscall_exit(current, syscall, ret, elapsed_ns);
+
+    return ret;
 }
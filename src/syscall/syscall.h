@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 #define SYS_EXIT 0
@@ -19,7 +20,82 @@
 #define SYS_READDIR 14
 #define SYS_STAT 15
 #define SYS_UNLINK 16
+#define SYS_FUTEX 17
+#define SYS_THREAD_CREATE 18
+#define SYS_THREAD_EXIT 19
+#define SYS_THREAD_JOIN 20
+#define SYS_SET_TLS 21
+#define SYS_SCHED_SETSCHEDULER 22
+#define SYS_GETRUSAGE 23
+#define SYS_CPUSTAT 24
+#define SYS_RING_SETUP 25
+#define SYS_RING_ENTER 26
+#define SYS_SYSCALL_STAT 27
+#define SYS_TRACE 28
+#define SYS_TRACE_READ 29
+#define SYS_PREAD 30
+#define SYS_PWRITE 31
+#define SYS_READV 32
+#define SYS_WRITEV 33
+#define SYS_FSTAT 34
+#define SYS_GETDENTS 35
+#define SYS_FCNTL 36
+#define SYS_PIPE 37
+#define SYS_DUP2 38
+#define SYS_SHM_OPEN 39
+#define SYS_SHM_UNLINK 40
+#define SYS_FTRUNCATE 41
+#define SYS_MMAP 42
+#define SYS_MUNMAP 43
+#define SYS_SOCKET 44
+#define SYS_BIND 45
+#define SYS_LISTEN 46
+#define SYS_ACCEPT 47
+#define SYS_CONNECT 48
+#define SYS_POLL 49
+#define SYS_EPOLL_CREATE 50
+#define SYS_EPOLL_CTL 51
+#define SYS_EPOLL_WAIT 52
+#define SYS_COPY_FILE_RANGE 53
+#define SYS_SENDFILE 54
+#define SYS_CACHESTAT 55
+
+#define SYSCALL_COUNT 56
+#define SYSCALL_MAX_ARGS 4
+#define SYSCALL_NAME_MAX 24
+
+typedef enum {
+    SYSCALL_ARG_NONE,
+    SYSCALL_ARG_INT,
+    SYSCALL_ARG_UINT,
+    SYSCALL_ARG_HEX,
+    SYSCALL_ARG_PTR,
+    SYSCALL_ARG_STR,
+    SYSCALL_ARG_FD,
+} syscall_arg_type_t;
+
+typedef struct {
+    char name[SYSCALL_NAME_MAX];
+    uint8_t nargs;
+    uint8_t args[SYSCALL_MAX_ARGS];
+    uint64_t calls;
+    uint64_t errors;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} syscall_stat_t;
+
+typedef struct syscall_frame {
+    uint64_t r9, r8, r10;
+    uint64_t rdx, rsi, rdi;
+    uint64_t r15, r14, r13, r12, rbx, rbp;
+    uint64_t r11, rcx;
+    uint64_t user_rsp;
+} syscall_frame_t;
 
 void syscall_init();
+void syscall_init_cpu();
+
+int64_t syscall_read(int fd, void *buf, size_t size);
+int64_t syscall_write(int fd, const void *buf, size_t size);
 
-uint64_t syscall_handler(uint64_t syscall, uint64_t arg1, uint64_t arg2, uint64_t arg3);
+uint64_t syscall_handler(uint64_t syscall, uint64_t arg1, uint64_t arg2, uint64_t arg3, syscall_frame_t *frame);
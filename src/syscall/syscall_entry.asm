@@ -1,23 +1,17 @@
-section .data
-global in_syscall
-in_syscall: dq 0
-global saved_syscall_rsp
-saved_syscall_rsp: dq 0
-global saved_user_rsp
-saved_user_rsp: dq 0
-global current_kernel_stack
-current_kernel_stack: dq 0
+%define CPU_KERNEL_STACK 8
+%define CPU_USER_RSP 16
 
 section .text
 global syscall_entry
 extern syscall_handler
+extern task_switch_finish
 
 syscall_entry:
-    mov qword [rel in_syscall], 1
-    mov [rel saved_user_rsp], rsp
-    mov rsp, [rel current_kernel_stack]
+    swapgs
+    mov [gs:CPU_USER_RSP], rsp
+    mov rsp, [gs:CPU_KERNEL_STACK]
 
-    push qword [rel saved_user_rsp]
+    push qword [gs:CPU_USER_RSP]
     push rcx
     push r11
     push rbp
@@ -33,7 +27,7 @@ syscall_entry:
     push r8
     push r9
 
-    mov [rel saved_syscall_rsp], rsp
+    mov r8, rsp
 
     mov rcx, rdx
     mov rdx, rsi
@@ -64,13 +58,15 @@ syscall_entry:
     pop rcx
     pop rsp
 
-    mov qword [rel in_syscall], 0
+    swapgs
     o64 sysret
 
 global fork_child_return
 fork_child_return:
     cli
 
+    call task_switch_finish
+
     pop r9
     pop r8
     pop r10
@@ -91,5 +87,5 @@ fork_child_return:
 
     xor rax, rax
 
-    mov qword [rel in_syscall], 0
+    swapgs
     o64 sysret
@@ -0,0 +1,139 @@
+#include "trace.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../drivers/timer/tsc.h"
+#include "../io/terminal.h"
+#include "../mem/alloc/heap.h"
+#include "../std/string.h"
+#include "../sync/spinlock.h"
+#include "../task/task.h"
+
+typedef struct syscall_trace {
+    spinlock_t lock;
+    volatile bool enabled;
+    uint32_t head;
+    uint32_t tail;
+    bool dropped;
+    trace_record_t records[TRACE_RING_RECORDS];
+} syscall_trace_t;
+
+int trace_set(task_t *task, int mode) {
+    if (mode != TRACE_OFF && mode != TRACE_ON) {
+        printkf_error("trace_set(): invalid mode %d\n", mode);
+        return -1;
+    }
+
+    if (mode == TRACE_OFF) {
+        if (task->trace != NULL)
+            task->trace->enabled = false;
+        return 0;
+    }
+
+    if (task->trace == NULL) {
+        syscall_trace_t *trace = (syscall_trace_t *)malloc(sizeof(syscall_trace_t));
+        if (trace == NULL) {
+            printkf_error("trace_set(): failed to allocate trace ring\n");
+            return -1;
+        }
+        memset(trace, 0, sizeof(syscall_trace_t));
+
+        syscall_trace_t *expected = NULL;
+        if (!__atomic_compare_exchange_n(&task->trace, &expected, trace, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            free(trace);
+        }
+    }
+
+    task->trace->enabled = true;
+    return 0;
+}
+
+static void trace_push(syscall_trace_t *trace, trace_record_t *record) {
+    uint64_t flags = spin_lock(&trace->lock);
+
+    if (trace->head - trace->tail >= TRACE_RING_RECORDS) {
+        trace->tail++;
+        trace->dropped = true;
+    }
+
+    record->dropped = trace->dropped;
+    trace->dropped = false;
+    trace->records[trace->head % TRACE_RING_RECORDS] = *record;
+    trace->head++;
+
+    spin_unlock(&trace->lock, flags);
+}
+
+void trace_syscall_enter(task_t *task, uint32_t nr, const uint64_t *args, int str_arg) {
+    syscall_trace_t *trace = task->trace;
+    if (trace == NULL || !trace->enabled)
+        return;
+
+    trace_record_t record = {0};
+    record.timestamp_ns = tsc_now_ns();
+    for (int i = 0; i < TRACE_MAX_ARGS; i++) {
+        record.args[i] = args[i];
+    }
+    record.pid = task->pid;
+    record.nr = nr;
+    record.kind = TRACE_ENTER;
+
+    if (str_arg >= 0 && record.args[str_arg] != 0) {
+        const char *str = (const char *)record.args[str_arg];
+        size_t len = 0;
+        while (len < TRACE_STR_MAX - 1 && str[len] != '\0') {
+            record.str[len] = str[len];
+            len++;
+        }
+    }
+
+    trace_push(trace, &record);
+}
+
+void trace_syscall_exit(task_t *task, uint32_t nr, int64_t ret, uint64_t duration_ns) {
+    syscall_trace_t *trace = task->trace;
+    if (trace == NULL || !trace->enabled)
+        return;
+
+    trace_record_t record = {0};
+    record.timestamp_ns = tsc_now_ns();
+    record.duration_ns = duration_ns;
+    record.ret = ret;
+    record.pid = task->pid;
+    record.nr = nr;
+    record.kind = TRACE_EXIT;
+
+    trace_push(trace, &record);
+}
+
+int trace_read(task_t *task, trace_record_t *records, uint32_t count) {
+    syscall_trace_t *trace = task->trace;
+    if (trace == NULL)
+        return 0;
+
+    uint32_t copied = 0;
+    while (copied < count) {
+        uint64_t flags = spin_lock(&trace->lock);
+        if (trace->tail == trace->head) {
+            spin_unlock(&trace->lock, flags);
+            break;
+        }
+
+        trace_record_t record = trace->records[trace->tail % TRACE_RING_RECORDS];
+        trace->tail++;
+        spin_unlock(&trace->lock, flags);
+
+        records[copied++] = record;
+    }
+
+    return copied;
+}
+
+void trace_release(task_t *task) {
+    // Runs from the final task_put, so no trace_set/trace_read holds the task.
+    if (task->trace != NULL) {
+        free(task->trace);
+        task->trace = NULL;
+    }
+}
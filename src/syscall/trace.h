@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+
+#define TRACE_RING_RECORDS 256
+#define TRACE_STR_MAX 32
+#define TRACE_MAX_ARGS 4
+
+#define TRACE_OFF 0
+#define TRACE_ON 1
+
+#define TRACE_ENTER 0
+#define TRACE_EXIT 1
+
+typedef struct {
+    uint64_t timestamp_ns;
+    uint64_t duration_ns;
+    uint64_t args[TRACE_MAX_ARGS];
+    int64_t ret;
+    uint32_t pid;
+    uint16_t nr;
+    uint8_t kind;
+    uint8_t dropped;
+    char str[TRACE_STR_MAX];
+} trace_record_t;
+
+struct task;
+
+int trace_set(struct task *task, int mode);
+void trace_syscall_enter(struct task *task, uint32_t nr, const uint64_t *args, int str_arg);
+void trace_syscall_exit(struct task *task, uint32_t nr, int64_t ret, uint64_t duration_ns);
+int trace_read(struct task *task, trace_record_t *records, uint32_t count);
+void trace_release(struct task *task);
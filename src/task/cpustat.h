@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+
+#define CPUSTAT_IDLE_STATES 3
+
+#define CPUSTAT_IDLE_HLT 0
+#define CPUSTAT_IDLE_MWAIT 1
+
+typedef struct {
+    uint32_t cpu;
+    uint32_t online;
+    uint32_t idle_method;
+    uint32_t nr_states;
+    uint64_t now_ns;
+    uint64_t idle_ns;
+    uint64_t residency_ns[CPUSTAT_IDLE_STATES];
+    uint64_t entries[CPUSTAT_IDLE_STATES];
+} cpustat_t;
@@ -0,0 +1,159 @@
+#include "idle.h"
+
+#include <stddef.h>
+
+#include "../arch/x86_64/cpu/cpu.h"
+#include "../drivers/timer/tsc.h"
+#include "../io/terminal.h"
+#include "../mem/alloc/page_frame_alloc.h"
+#include "../std/string.h"
+#include "scheduler.h"
+
+static bool idle_mwait = false;
+static uint32_t idle_nr_states = 1;
+static uint32_t idle_hints[CPUSTAT_IDLE_STATES] = {0x00, 0x10, 0x20};
+static const uint64_t idle_target_residency_ns[CPUSTAT_IDLE_STATES] = {0, 20000, 500000};
+
+static inline void monitor(const volatile void *addr) {
+    __asm__ volatile("monitor" : : "a"(addr), "c"(0), "d"(0));
+}
+
+static inline void mwait_sti(uint32_t hint) {
+    __asm__ volatile("sti; mwait" : : "a"(hint), "c"(0) : "memory");
+}
+
+void idle_init() {
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+
+    if (!(ecx & (1 << 3))) {
+        printkf_info("Idle: using HLT\n");
+        return;
+    }
+
+    cpuid(5, 0, &eax, &ebx, &ecx, &edx);
+
+    idle_mwait = true;
+    idle_nr_states = 1;
+
+    for (uint32_t cstate = 2; cstate <= CPUSTAT_IDLE_STATES; cstate++) {
+        uint32_t substates = (edx >> (cstate * 4)) & 0xF;
+        if (substates == 0)
+            break;
+        idle_hints[idle_nr_states++] = (cstate - 1) << 4;
+    }
+
+    printkf_info("Idle: using MWAIT with %u C-state(s)\n", idle_nr_states);
+}
+
+static uint32_t idle_select_state(cpu_t *cpu) {
+    uint32_t state = 0;
+    for (uint32_t i = 1; i < idle_nr_states; i++) {
+        if (cpu->idle_stats.predicted_ns >= idle_target_residency_ns[i])
+            state = i;
+    }
+    return state;
+}
+
+void idle_account_exit(cpu_t *cpu) {
+    idle_stats_t *stats = &cpu->idle_stats;
+    if (stats->start == 0)
+        return;
+
+    uint64_t elapsed = tsc_to_ns(tsc_read() - stats->start);
+    stats->start = 0;
+
+    stats->idle_ns += elapsed;
+    stats->residency_ns[stats->state] += elapsed;
+    stats->predicted_ns = (stats->predicted_ns * 7 + elapsed) / 8;
+}
+
+static void idle_enter(cpu_t *cpu) {
+    idle_stats_t *stats = &cpu->idle_stats;
+
+    __asm__ volatile("cli");
+
+    if (cpu->need_resched) {
+        __asm__ volatile("sti");
+        return;
+    }
+
+    uint32_t state = idle_select_state(cpu);
+    stats->state = state;
+    stats->entries[state]++;
+    stats->start = tsc_read();
+
+    if (idle_mwait) {
+        stats->polling = true;
+        monitor(&cpu->need_resched);
+        if (!cpu->need_resched) {
+            mwait_sti(idle_hints[state]);
+        } else {
+            __asm__ volatile("sti");
+        }
+        stats->polling = false;
+    } else {
+        __asm__ volatile("sti; hlt");
+    }
+
+    __asm__ volatile("cli");
+    idle_account_exit(cpu);
+    __asm__ volatile("sti");
+}
+
+static void idle_background(cpu_t *cpu) {
+    for (uint32_t i = 0; i < IDLE_ZERO_BATCH && !cpu->need_resched; i++) {
+        if (!pfallocator_zero_pool_refill())
+            break;
+    }
+}
+
+void idle_loop() {
+    cpu_t *cpu = cpu_current();
+
+    while (1) {
+        idle_background(cpu);
+        idle_enter(cpu);
+        scheduler_schedule();
+    }
+}
+
+bool idle_kick(cpu_t *cpu) {
+    if (!cpu->idle_stats.polling)
+        return false;
+
+    cpu->need_resched = true;
+    return true;
+}
+
+int idle_get_cpustat(uint32_t id, cpustat_t *stat) {
+    cpu_t *cpu = cpu_get(id);
+    if (cpu == NULL || stat == NULL)
+        return -1;
+
+    memset(stat, 0, sizeof(cpustat_t));
+
+    idle_stats_t *stats = &cpu->idle_stats;
+    uint64_t now = tsc_read();
+
+    stat->cpu = cpu->id;
+    stat->online = cpu->online;
+    stat->idle_method = idle_mwait ? CPUSTAT_IDLE_MWAIT : CPUSTAT_IDLE_HLT;
+    stat->nr_states = idle_nr_states;
+    stat->now_ns = tsc_to_ns(now);
+    stat->idle_ns = stats->idle_ns;
+
+    for (uint32_t i = 0; i < CPUSTAT_IDLE_STATES; i++) {
+        stat->residency_ns[i] = stats->residency_ns[i];
+        stat->entries[i] = stats->entries[i];
+    }
+
+    uint64_t start = stats->start;
+    if (start != 0 && now > start) {
+        uint64_t current = tsc_to_ns(now - start);
+        stat->idle_ns += current;
+        stat->residency_ns[stats->state] += current;
+    }
+
+    return 0;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cpustat.h"
+
+#define IDLE_ZERO_BATCH 8
+
+typedef struct {
+    volatile bool polling;
+    uint32_t state;
+    uint64_t start;
+    uint64_t predicted_ns;
+    uint64_t idle_ns;
+    uint64_t residency_ns[CPUSTAT_IDLE_STATES];
+    uint64_t entries[CPUSTAT_IDLE_STATES];
+} idle_stats_t;
+
+struct cpu;
+
+void idle_init();
+void idle_loop();
+void idle_account_exit(struct cpu *cpu);
+bool idle_kick(struct cpu *cpu);
+int idle_get_cpustat(uint32_t id, cpustat_t *stat);
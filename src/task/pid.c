@@ -0,0 +1,135 @@
+#include "pid.h"
+
+#include <stddef.h>
+
+#include "../std/string.h"
+#include "../sync/spinlock.h"
+#include "task.h"
+
+static uint64_t pid_bitmap[PID_MAX / 64];
+static uint32_t pid_last = 0;
+static task_t *pid_hash[PID_HASH_BUCKETS];
+
+static spinlock_t pid_lock = {0};
+
+static inline uint32_t pid_hash_index(uint32_t pid) {
+    return (pid * 2654435761u) >> 24;
+}
+
+void pid_init() {
+    memset(pid_bitmap, 0, sizeof(pid_bitmap));
+    memset(pid_hash, 0, sizeof(pid_hash));
+    pid_bitmap[0] = 1;
+    pid_last = 0;
+}
+
+uint32_t pid_alloc() {
+    uint64_t flags = spin_lock(&pid_lock);
+
+    uint32_t pid = pid_last;
+    for (uint32_t scanned = 0; scanned < PID_MAX; scanned++) {
+        pid = (pid + 1) % PID_MAX;
+
+        uint64_t word = pid_bitmap[pid / 64];
+        if (word == UINT64_MAX) {
+            uint32_t skip = 63 - (pid % 64);
+            pid += skip;
+            scanned += skip;
+            continue;
+        }
+
+        if (!(word & (1ULL << (pid % 64)))) {
+            pid_bitmap[pid / 64] |= 1ULL << (pid % 64);
+            pid_last = pid;
+            spin_unlock(&pid_lock, flags);
+            return pid;
+        }
+    }
+
+    spin_unlock(&pid_lock, flags);
+    return 0;
+}
+
+void pid_free(uint32_t pid) {
+    if (pid == 0 || pid >= PID_MAX)
+        return;
+
+    uint64_t flags = spin_lock(&pid_lock);
+    pid_bitmap[pid / 64] &= ~(1ULL << (pid % 64));
+    spin_unlock(&pid_lock, flags);
+}
+
+uint32_t pid_next_used(uint32_t pid) {
+    uint64_t flags = spin_lock(&pid_lock);
+
+    for (; pid < PID_MAX; pid++) {
+        uint64_t word = pid_bitmap[pid / 64] >> (pid % 64);
+        if (word == 0) {
+            pid |= 63;
+            continue;
+        }
+
+        pid += __builtin_ctzll(word);
+        spin_unlock(&pid_lock, flags);
+        return pid;
+    }
+
+    spin_unlock(&pid_lock, flags);
+    return 0;
+}
+
+void pid_hash_insert(task_t *task) {
+    uint32_t index = pid_hash_index(task->pid);
+
+    uint64_t flags = spin_lock(&pid_lock);
+    task->pid_next = pid_hash[index];
+    pid_hash[index] = task;
+    spin_unlock(&pid_lock, flags);
+}
+
+void pid_hash_remove(task_t *task) {
+    uint32_t index = pid_hash_index(task->pid);
+
+    uint64_t flags = spin_lock(&pid_lock);
+
+    task_t **link = &pid_hash[index];
+    while (*link != NULL && *link != task) {
+        link = &(*link)->pid_next;
+    }
+    if (*link == task) {
+        *link = task->pid_next;
+    }
+    task->pid_next = NULL;
+
+    spin_unlock(&pid_lock, flags);
+}
+
+task_t *pid_hash_find(uint32_t pid) {
+    uint32_t index = pid_hash_index(pid);
+
+    uint64_t flags = spin_lock(&pid_lock);
+
+    task_t *task = pid_hash[index];
+    while (task != NULL && task->pid != pid) {
+        task = task->pid_next;
+    }
+
+    spin_unlock(&pid_lock, flags);
+    return task;
+}
+
+task_t *pid_hash_get(uint32_t pid) {
+    uint32_t index = pid_hash_index(pid);
+
+    uint64_t flags = spin_lock(&pid_lock);
+
+    task_t *task = pid_hash[index];
+    while (task != NULL && task->pid != pid) {
+        task = task->pid_next;
+    }
+    if (task != NULL)
+        __atomic_add_fetch(&task->refcount, 1, __ATOMIC_RELAXED);
+
+    spin_unlock(&pid_lock, flags);
+    return task;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+
+#define PID_MAX 32768
+#define PID_HASH_BUCKETS 256
+
+struct task;
+
+void pid_init();
+uint32_t pid_alloc();
+void pid_free(uint32_t pid);
+uint32_t pid_next_used(uint32_t pid);
+
+void pid_hash_insert(struct task *task);
+void pid_hash_remove(struct task *task);
+struct task *pid_hash_find(uint32_t pid);
+struct task *pid_hash_get(uint32_t pid);
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+
+#define RUSAGE_LATENCY_BUCKETS 16
+#define RUSAGE_NEXT 1
+
+typedef struct {
+    uint32_t pid;
+    uint32_t parent_pid;
+    uint8_t state;
+    uint8_t policy;
+    uint8_t rt_priority;
+    uint8_t cpu;
+    uint32_t reserved;
+    uint64_t now_ns;
+    uint64_t runtime_ns;
+    uint64_t user_ns;
+    uint64_t system_ns;
+    uint64_t wait_ns;
+    uint64_t sleep_ns;
+    uint64_t nvcsw;
+    uint64_t nivcsw;
+    uint64_t wakeups;
+    uint64_t max_wakeup_latency_ns;
+    uint64_t wakeup_latency_hist[RUSAGE_LATENCY_BUCKETS];
+} rusage_t;
@@ -2,166 +2,681 @@
 
 #include <stddef.h>
 
+#include "../arch/x86_64/cpu/cpu.h"
+#include "../drivers/apic/lapic.h"
 #include "../drivers/timer/timer.h"
+#include "../drivers/timer/tsc.h"
 #include "../io/terminal.h"
+#include "../std/string.h"
 #include "../sync/spinlock.h"
+#include "idle.h"
 #include "task.h"
 
-static task_t *ready_queue_head = NULL;
-static task_t *ready_queue_tail = NULL;
-static int scheduler_enabled = 0;
+static volatile int scheduler_enabled = 0;
+
+static void run_queue_init(run_queue_t *rq) {
+    rq->lock.locked = 0;
+    rq->normal.head = NULL;
+    rq->normal.tail = NULL;
+    rq->rt.head = NULL;
+    rq->rt.tail = NULL;
+    rq->sleeping.head = NULL;
+    rq->sleeping.tail = NULL;
+    rq->nr_tasks = 0;
+    rq->nr_rt = 0;
+    rq->rt_period_ticks = 0;
+    rq->rt_runtime_ticks = 0;
+    rq->rt_throttled = false;
+}
+
+static inline bool task_is_rt(task_t *task) {
+    return task->policy != SCHED_NORMAL;
+}
+
+static void task_queue_append(task_queue_t *queue, task_t *task) {
+    task->next = NULL;
+
+    if (queue->tail == NULL) {
+        queue->head = task;
+        queue->tail = task;
+    } else {
+        queue->tail->next = task;
+        queue->tail = task;
+    }
+}
+
+static void task_queue_unlink(task_queue_t *queue, task_t *task, task_t *prev) {
+    if (prev == NULL) {
+        queue->head = task->next;
+    } else {
+        prev->next = task->next;
+    }
+
+    if (queue->tail == task) {
+        queue->tail = prev;
+    }
+
+    task->next = NULL;
+}
+
+static bool task_queue_remove(task_queue_t *queue, task_t *task) {
+    task_t *prev = NULL;
+    for (task_t *curr = queue->head; curr != NULL; prev = curr, curr = curr->next) {
+        if (curr == task) {
+            task_queue_unlink(queue, curr, prev);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void rt_queue_insert(task_queue_t *queue, task_t *task) {
+    task_t *prev = NULL;
+    task_t *curr = queue->head;
+
+    while (curr != NULL && curr->rt_priority >= task->rt_priority) {
+        prev = curr;
+        curr = curr->next;
+    }
+
+    task->next = curr;
+    if (prev == NULL) {
+        queue->head = task;
+    } else {
+        prev->next = task;
+    }
+    if (curr == NULL) {
+        queue->tail = task;
+    }
+}
+
+static void run_queue_append(run_queue_t *rq, task_t *task) {
+    if (task_is_rt(task)) {
+        rt_queue_insert(&rq->rt, task);
+        rq->nr_rt++;
+    } else {
+        task_queue_append(&rq->normal, task);
+    }
+
+    task->on_rq = 1;
+    rq->nr_tasks++;
+}
+
+static bool run_queue_remove(run_queue_t *rq, task_t *task) {
+    if (task_is_rt(task)) {
+        if (!task_queue_remove(&rq->rt, task))
+            return false;
+        rq->nr_rt--;
+    } else {
+        if (!task_queue_remove(&rq->normal, task))
+            return false;
+    }
+
+    task->on_rq = 0;
+    rq->nr_tasks--;
+    return true;
+}
+
+static void rt_requeue(run_queue_t *rq, task_t *task) {
+    if (task_queue_remove(&rq->rt, task)) {
+        rt_queue_insert(&rq->rt, task);
+    }
+}
+
+static void sleep_queue_insert(task_queue_t *queue, task_t *task) {
+    task_t *prev = NULL;
+    task_t *curr = queue->head;
+
+    while (curr != NULL && curr->wake_tick <= task->wake_tick) {
+        prev = curr;
+        curr = curr->next;
+    }
+
+    task->next = curr;
+    if (prev == NULL) {
+        queue->head = task;
+    } else {
+        prev->next = task;
+    }
+    if (curr == NULL) {
+        queue->tail = task;
+    }
+}
+
+static void run_queue_block(run_queue_t *rq, task_t *task) {
+    if (task->on_rq) {
+        run_queue_remove(rq, task);
+    }
+
+    if (task->wake_tick != 0 && !task->on_sleep_queue) {
+        sleep_queue_insert(&rq->sleeping, task);
+        task->on_sleep_queue = 1;
+    }
+}
 
-static spinlock_t scheduler_lock = {0};
+static task_t *run_queue_take_ready(run_queue_t *rq) {
+    task_t *prev = NULL;
+    for (task_t *t = rq->normal.head; t != NULL; prev = t, t = t->next) {
+        if (t->state == TASK_READY && !t->on_cpu) {
+            task_queue_unlink(&rq->normal, t, prev);
+            t->on_rq = 0;
+            rq->nr_tasks--;
+            return t;
+        }
+    }
+    return NULL;
+}
 
-extern volatile int in_syscall;
+static task_t *rt_pick(run_queue_t *rq, task_t *current) {
+    bool preempting = current != NULL && task_is_rt(current) && current->state == TASK_RUNNING;
+    bool seen_current = false;
+
+    for (task_t *t = rq->rt.head; t != NULL; t = t->next) {
+        if (t == current) {
+            seen_current = true;
+            continue;
+        }
+
+        if (preempting) {
+            if (t->rt_priority < current->rt_priority)
+                return NULL;
+            if (t->rt_priority == current->rt_priority && seen_current)
+                return NULL;
+        }
+
+        if (t->state == TASK_READY && !t->on_cpu) {
+            return t;
+        }
+    }
+
+    return NULL;
+}
+
+static void account_wake(task_t *task) {
+    task_stats_t *stats = &task->stats;
+    uint64_t now = tsc_read();
+
+    if (stats->sleep_stamp != 0) {
+        stats->sleep_ns += tsc_to_ns(now - stats->sleep_stamp);
+        stats->sleep_stamp = 0;
+    }
+
+    stats->enqueue_stamp = now;
+    stats->woken = true;
+    stats->wakeups++;
+}
+
+static void account_latency(task_stats_t *stats, uint64_t latency_ns) {
+    uint64_t us = latency_ns / 1000;
+    uint32_t bucket = 0;
+    if (us != 0) {
+        bucket = 64 - __builtin_clzll(us);
+        if (bucket >= RUSAGE_LATENCY_BUCKETS) {
+            bucket = RUSAGE_LATENCY_BUCKETS - 1;
+        }
+    }
+
+    stats->wakeup_latency_hist[bucket]++;
+    if (latency_ns > stats->max_wakeup_latency_ns) {
+        stats->max_wakeup_latency_ns = latency_ns;
+    }
+}
+
+void scheduler_account_switch(task_t *prev, task_t *next) {
+    cpu_t *cpu = cpu_current();
+    if (prev != NULL && prev == cpu->idle) {
+        idle_account_exit(cpu);
+    }
+
+    uint64_t now = tsc_read();
+
+    if (prev != NULL) {
+        task_stats_t *stats = &prev->stats;
+
+        if (stats->exec_start != 0) {
+            stats->runtime_ns += tsc_to_ns(now - stats->exec_start);
+            stats->exec_start = 0;
+        }
+
+        if (prev->state == TASK_BLOCKED) {
+            stats->nvcsw++;
+            stats->sleep_stamp = now;
+        } else if (prev->state == TASK_RUNNING || prev->state == TASK_READY) {
+            stats->nivcsw++;
+            stats->enqueue_stamp = now;
+            stats->woken = false;
+        }
+    }
+
+    task_stats_t *stats = &next->stats;
+
+    if (stats->enqueue_stamp != 0) {
+        uint64_t waited = tsc_to_ns(now - stats->enqueue_stamp);
+        stats->wait_ns += waited;
+        if (stats->woken) {
+            account_latency(stats, waited);
+            stats->woken = false;
+        }
+        stats->enqueue_stamp = 0;
+    }
+
+    stats->exec_start = now;
+}
+
+int scheduler_get_rusage(task_t *task, rusage_t *usage) {
+    if (task == NULL || usage == NULL) {
+        return -1;
+    }
+
+    memset(usage, 0, sizeof(rusage_t));
+
+    uint64_t flags;
+    __asm__ volatile("pushfq; pop %0; cli" : "=r"(flags) : : "memory");
+
+    task_stats_t *stats = &task->stats;
+    uint64_t now = tsc_read();
+
+    uint64_t runtime = stats->runtime_ns;
+    if (stats->exec_start != 0) {
+        runtime += tsc_to_ns(now - stats->exec_start);
+    }
+
+    uint64_t wait = stats->wait_ns;
+    if (stats->enqueue_stamp != 0) {
+        wait += tsc_to_ns(now - stats->enqueue_stamp);
+    }
+
+    uint64_t sleep = stats->sleep_ns;
+    if (stats->sleep_stamp != 0) {
+        sleep += tsc_to_ns(now - stats->sleep_stamp);
+    }
+
+    uint64_t ticks = stats->user_ticks + stats->system_ticks;
+    uint64_t user = 0;
+    if (ticks != 0) {
+        user = (runtime / ticks) * stats->user_ticks + ((runtime % ticks) * stats->user_ticks) / ticks;
+    }
+
+    usage->pid = task->pid;
+    usage->parent_pid = task->parent_pid;
+    usage->state = task->state;
+    usage->policy = task->policy;
+    usage->rt_priority = task->rt_priority;
+    usage->cpu = task->cpu;
+    usage->now_ns = tsc_to_ns(now);
+    usage->runtime_ns = runtime;
+    usage->user_ns = user;
+    usage->system_ns = runtime - user;
+    usage->wait_ns = wait;
+    usage->sleep_ns = sleep;
+    usage->nvcsw = stats->nvcsw;
+    usage->nivcsw = stats->nivcsw;
+    usage->wakeups = stats->wakeups;
+    usage->max_wakeup_latency_ns = stats->max_wakeup_latency_ns;
+    memcpy(usage->wakeup_latency_hist, stats->wakeup_latency_hist, sizeof(usage->wakeup_latency_hist));
+
+    __asm__ volatile("push %0; popfq" : : "r"(flags) : "memory", "cc");
+
+    return 0;
+}
+
+static bool rt_should_preempt(cpu_t *cpu, task_t *task) {
+    task_t *current = cpu->current;
+
+    if (!task_is_rt(task) || cpu->rq.rt_throttled || current == NULL)
+        return false;
+
+    if (!task_is_rt(current))
+        return true;
+
+    return task->rt_priority > current->rt_priority;
+}
 
 void scheduler_init() {
-    ready_queue_head = NULL;
-    ready_queue_tail = NULL;
+    idle_init();
+    scheduler_init_cpu();
     scheduler_enabled = 0;
 }
 
+void scheduler_init_cpu() {
+    cpu_t *cpu = cpu_current();
+
+    run_queue_init(&cpu->rq);
+
+    cpu->idle = task_create_idle();
+    if (cpu->idle == NULL) {
+        panic("scheduler_init_cpu(): failed to create idle task");
+    }
+    cpu->current = cpu->idle;
+}
+
+static cpu_t *scheduler_pick_cpu() {
+    cpu_t *best = cpu_current();
+
+    for (uint32_t i = 0; i < cpu_count(); i++) {
+        cpu_t *cpu = cpu_get(i);
+        if (cpu == NULL || !cpu->online) {
+            continue;
+        }
+        if (cpu->rq.nr_tasks < best->rq.nr_tasks) {
+            best = cpu;
+        }
+    }
+
+    return best;
+}
+
 void scheduler_add_task(task_t *task) {
     if (task == NULL) {
         return;
     }
 
-    uint64_t flags = spin_lock(&scheduler_lock);
+    cpu_t *cpu = scheduler_pick_cpu();
 
-    task->next = NULL;
+    uint64_t flags = spin_lock(&cpu->rq.lock);
 
-    if (ready_queue_tail == NULL) {
-        ready_queue_head = task;
-        ready_queue_tail = task;
-    } else {
-        ready_queue_tail->next = task;
-        ready_queue_tail = task;
+    task->cpu = cpu->id;
+    task->stats.enqueue_stamp = tsc_read();
+    run_queue_append(&cpu->rq, task);
+
+    if (cpu != cpu_current() && cpu->current == cpu->idle && !idle_kick(cpu)) {
+        lapic_send_ipi(cpu->lapic_id, LAPIC_IPI_VECTOR);
     }
 
-    spin_unlock(&scheduler_lock, flags);
+    spin_unlock(&cpu->rq.lock, flags);
 }
 
 void scheduler_remove_task(task_t *task) {
-    if (task == NULL || ready_queue_head == NULL) {
+    if (task == NULL) {
         return;
     }
 
-    uint64_t flags = spin_lock(&scheduler_lock);
+    while (1) {
+        cpu_t *cpu = cpu_get(task->cpu);
+        if (cpu == NULL) {
+            return;
+        }
+
+        uint64_t flags = spin_lock(&cpu->rq.lock);
+
+        if (task->cpu != cpu->id) {
+            spin_unlock(&cpu->rq.lock, flags);
+            continue;
+        }
 
-    if (ready_queue_head == NULL) {
-        spin_unlock(&scheduler_lock, flags);
+        run_queue_remove(&cpu->rq, task);
+        if (task->on_sleep_queue) {
+            task_queue_remove(&cpu->rq.sleeping, task);
+            task->on_sleep_queue = 0;
+        }
+        spin_unlock(&cpu->rq.lock, flags);
         return;
     }
+}
 
-    task_t *prev = NULL;
-    task_t *curr = ready_queue_head;
+static void scheduler_wake_locked(cpu_t *cpu, task_t *task) {
+    run_queue_t *rq = &cpu->rq;
 
-    while (curr != NULL) {
-        if (curr == task) {
-            if (prev == NULL) {
-                ready_queue_head = curr->next;
-            } else {
-                prev->next = curr->next;
-            }
+    task->state = TASK_READY;
+    task->wake_tick = 0;
+    account_wake(task);
 
-            if (curr == ready_queue_tail) {
-                ready_queue_tail = prev;
-            }
+    if (task->on_sleep_queue) {
+        task_queue_remove(&rq->sleeping, task);
+        task->on_sleep_queue = 0;
+    }
 
-            task->next = NULL;
-            spin_unlock(&scheduler_lock, flags);
-            return;
-        }
-        prev = curr;
-        curr = curr->next;
+    if (!task->on_rq) {
+        run_queue_append(rq, task);
+    } else if (task_is_rt(task)) {
+        rt_requeue(rq, task);
     }
-    spin_unlock(&scheduler_lock, flags);
 }
 
-static void wake_sleeping_tasks() {
-    uint64_t current_tick = timer_get_ticks();
-    task_t *task = ready_queue_head;
+void scheduler_wake(task_t *task) {
+    if (task == NULL || task->state != TASK_BLOCKED) {
+        return;
+    }
+
+    while (1) {
+        cpu_t *cpu = cpu_get(task->cpu);
+        if (cpu == NULL) {
+            return;
+        }
+
+        uint64_t flags = spin_lock(&cpu->rq.lock);
 
-    while (task != NULL) {
-        if (task->state == TASK_BLOCKED && task->wake_tick != 0) {
-            if (current_tick >= task->wake_tick) {
-                task->state = TASK_READY;
-                task->wake_tick = 0;
+        if (task->cpu != cpu->id) {
+            spin_unlock(&cpu->rq.lock, flags);
+            continue;
+        }
+
+        if (task->state != TASK_BLOCKED) {
+            spin_unlock(&cpu->rq.lock, flags);
+            return;
+        }
+
+        scheduler_wake_locked(cpu, task);
+
+        bool preempt = rt_should_preempt(cpu, task);
+        if (preempt) {
+            cpu->need_resched = true;
+        }
+
+        bool kick = cpu != cpu_current() && cpu->current == cpu->idle;
+
+        spin_unlock(&cpu->rq.lock, flags);
+
+        if (preempt) {
+            if (!cpu->idle_stats.polling) {
+                lapic_send_ipi(cpu->lapic_id, LAPIC_IPI_VECTOR);
             }
+        } else if (kick && !idle_kick(cpu)) {
+            lapic_send_ipi(cpu->lapic_id, LAPIC_IPI_VECTOR);
         }
-        task = task->next;
+        return;
     }
 }
 
-void scheduler_schedule() {
-    if (!scheduler_enabled) {
-        return;
+static void wake_sleeping_tasks(cpu_t *cpu) {
+    task_queue_t *queue = &cpu->rq.sleeping;
+    uint64_t current_tick = timer_get_ticks();
+
+    while (queue->head != NULL && queue->head->wake_tick <= current_tick) {
+        task_t *task = queue->head;
+        task_queue_unlink(queue, task, NULL);
+        task->on_sleep_queue = 0;
+
+        if (task->state == TASK_BLOCKED) {
+            scheduler_wake_locked(cpu, task);
+        }
     }
+}
 
-restart:;
-    uint64_t flags = spin_lock(&scheduler_lock);
+static void rt_tick(cpu_t *cpu) {
+    run_queue_t *rq = &cpu->rq;
+    task_t *current = cpu->current;
 
-    task_t *current = task_current();
-    task_t *next = NULL;
+    if (current != NULL && task_is_rt(current) && current->state == TASK_RUNNING) {
+        rq->rt_runtime_ticks++;
 
-    uint64_t current_tick = timer_get_ticks();
-    for (task_t *t = ready_queue_head; t != NULL; t = t->next) {
-        if (t->state == TASK_BLOCKED && t->wake_tick != 0) {
-            if (current_tick >= t->wake_tick) {
-                t->state = TASK_READY;
-                t->wake_tick = 0;
-            }
+        if (current->policy == SCHED_RR && (current->rt_slice == 0 || --current->rt_slice == 0)) {
+            current->rt_slice = SCHED_RR_TIMESLICE;
+            rt_requeue(rq, current);
         }
     }
 
-    task_t *start;
-    if (current != NULL && current->next != NULL) {
-        start = current->next;
+    if (++rq->rt_period_ticks >= SCHED_RT_PERIOD) {
+        rq->rt_period_ticks = 0;
+        rq->rt_runtime_ticks = 0;
+        rq->rt_throttled = false;
+    } else if (rq->rt_runtime_ticks >= SCHED_RT_RUNTIME) {
+        rq->rt_throttled = true;
+    }
+}
+
+int scheduler_set_policy(task_t *task, int policy, int priority) {
+    if (task == NULL) {
+        return -1;
+    }
+
+    if (policy == SCHED_NORMAL) {
+        if (priority != 0) {
+            printkf_error("scheduler_set_policy(): SCHED_NORMAL takes no priority\n");
+            return -1;
+        }
+    } else if (policy == SCHED_FIFO || policy == SCHED_RR) {
+        if (priority < SCHED_RT_PRIO_MIN || priority > SCHED_RT_PRIO_MAX) {
+            printkf_error("scheduler_set_policy(): invalid real-time priority %d\n", priority);
+            return -1;
+        }
     } else {
-        start = ready_queue_head;
+        printkf_error("scheduler_set_policy(): unknown policy %d\n", policy);
+        return -1;
     }
 
-    task_t *candidate = start;
-    int checked = 0;
-    int total_tasks = 0;
+    while (1) {
+        cpu_t *cpu = cpu_get(task->cpu);
+        if (cpu == NULL) {
+            return -1;
+        }
+
+        if (task == cpu->idle) {
+            printkf_error("scheduler_set_policy(): cannot change the idle task\n");
+            return -1;
+        }
+
+        uint64_t flags = spin_lock(&cpu->rq.lock);
+
+        if (task->cpu != cpu->id) {
+            spin_unlock(&cpu->rq.lock, flags);
+            continue;
+        }
 
-    for (task_t *t = ready_queue_head; t != NULL; t = t->next) {
-        total_tasks++;
+        bool queued = run_queue_remove(&cpu->rq, task);
+
+        task->policy = policy;
+        task->rt_priority = priority;
+        task->rt_slice = SCHED_RR_TIMESLICE;
+
+        if (queued) {
+            run_queue_append(&cpu->rq, task);
+        }
+
+        bool preempt = task == cpu->current || (task->state == TASK_READY && rt_should_preempt(cpu, task));
+        if (preempt) {
+            cpu->need_resched = true;
+        }
+
+        spin_unlock(&cpu->rq.lock, flags);
+
+        if (preempt && cpu != cpu_current() && !cpu->idle_stats.polling) {
+            lapic_send_ipi(cpu->lapic_id, LAPIC_IPI_VECTOR);
+        }
+
+        return 0;
     }
+}
+
+static task_t *scheduler_steal(cpu_t *self) {
+    uint32_t count = cpu_count();
 
-    while (checked < total_tasks) {
-        if (candidate == NULL) {
-            candidate = ready_queue_head;
+    for (uint32_t i = 1; i < count; i++) {
+        cpu_t *victim = cpu_get((self->id + i) % count);
+        if (victim == NULL || !victim->online || victim->rq.nr_tasks == victim->rq.nr_rt) {
+            continue;
         }
 
-        if (candidate == NULL) {
-            break;
+        uint64_t flags = spin_lock(&victim->rq.lock);
+        task_t *task = run_queue_take_ready(&victim->rq);
+        if (task != NULL) {
+            task->cpu = self->id;
         }
+        spin_unlock(&victim->rq.lock, flags);
 
-        if (candidate->state == TASK_READY) {
-            next = candidate;
-            break;
+        if (task != NULL) {
+            flags = spin_lock(&self->rq.lock);
+            run_queue_append(&self->rq, task);
+            spin_unlock(&self->rq.lock, flags);
+            return task;
+        }
+    }
+
+    return NULL;
+}
+
+void scheduler_schedule() {
+    if (!scheduler_enabled) {
+        return;
+    }
+
+    __asm__ volatile("cli");
+
+    cpu_t *cpu = cpu_current();
+    task_t *current = cpu->current;
+
+    cpu->need_resched = false;
+
+    uint64_t flags = spin_lock(&cpu->rq.lock);
+
+    if (current != NULL && current != cpu->idle && current->state == TASK_BLOCKED) {
+        run_queue_block(&cpu->rq, current);
+    }
+
+    wake_sleeping_tasks(cpu);
+
+    bool rt_running = current != NULL && task_is_rt(current) && current->state == TASK_RUNNING &&
+                      !cpu->rq.rt_throttled;
+
+    task_t *next = NULL;
+    if (!cpu->rq.rt_throttled) {
+        next = rt_pick(&cpu->rq, current);
+    }
+
+    if (next == NULL && !rt_running) {
+        next = run_queue_take_ready(&cpu->rq);
+        if (next != NULL) {
+            run_queue_append(&cpu->rq, next);
         }
+    }
 
-        candidate = candidate->next;
-        if (candidate == NULL) {
-            candidate = ready_queue_head;
+    spin_unlock(&cpu->rq.lock, flags);
+
+    if (next == NULL && !rt_running) {
+        next = scheduler_steal(cpu);
+    }
+
+    if (next == NULL) {
+        if (current != NULL && (current->state == TASK_RUNNING || current->state == TASK_READY)) {
+            current->state = TASK_RUNNING;
+            __asm__ volatile("sti");
+            return;
         }
-        checked++;
+        next = cpu->idle;
     }
 
-    spin_unlock(&scheduler_lock, flags);
+    task_switch(next);
+    __asm__ volatile("sti");
+}
 
-    if (next != NULL) {
-        task_switch(next);
-        __asm__ volatile("sti");
-    } else if (current != NULL && current->state == TASK_RUNNING) {
-        __asm__ volatile("sti");
-    } else {
-        __asm__ volatile("sti");
-        __asm__ volatile("hlt");
-        goto restart;
+void scheduler_yield() {
+    __asm__ volatile("cli");
+
+    cpu_t *cpu = cpu_current();
+    task_t *current = cpu->current;
+
+    if (current != NULL && task_is_rt(current)) {
+        uint64_t flags = spin_lock(&cpu->rq.lock);
+        current->rt_slice = SCHED_RR_TIMESLICE;
+        rt_requeue(&cpu->rq, current);
+        spin_unlock(&cpu->rq.lock, flags);
     }
+
+    scheduler_schedule();
+}
+
+void scheduler_idle() {
+    idle_loop();
 }
 
 void scheduler_enable() {
@@ -182,25 +697,84 @@ void scheduler_tick() {
         return;
     }
 
-    uint64_t flags = spin_lock(&scheduler_lock);
-    wake_sleeping_tasks();
-    spin_unlock(&scheduler_lock, flags);
+    cpu_t *cpu = cpu_current();
 
-    if (in_syscall)
+    uint64_t flags = spin_lock(&cpu->rq.lock);
+    wake_sleeping_tasks(cpu);
+    rt_tick(cpu);
+    spin_unlock(&cpu->rq.lock, flags);
+
+    if (cpu->current != NULL) {
+        if (cpu->tick_from_user) {
+            cpu->current->stats.user_ticks++;
+        } else {
+            cpu->current->stats.system_ticks++;
+        }
+    }
+
+    if (cpu->current != NULL && cpu->current->preempt_count > 0) {
+        cpu->need_resched = true;
         return;
+    }
 
     scheduler_schedule();
 }
 
-void scheduler_print_tasks() {
-    uint64_t flags = spin_lock(&scheduler_lock);
-    task_t *cur = ready_queue_head;
-    if (cur == NULL) {
-        spin_unlock(&scheduler_lock, flags);
+void preempt_disable() {
+    if (!scheduler_enabled) {
         return;
     }
 
-    while (cur) {
+    task_t *current = cpu_current_task();
+    if (current != NULL) {
+        current->preempt_count++;
+    }
+    __asm__ volatile("" ::: "memory");
+}
+
+void preempt_enable_no_resched() {
+    __asm__ volatile("" ::: "memory");
+    if (!scheduler_enabled) {
+        return;
+    }
+
+    task_t *current = cpu_current_task();
+    if (current != NULL && current->preempt_count > 0) {
+        current->preempt_count--;
+    }
+}
+
+void preempt_enable() {
+    preempt_enable_no_resched();
+
+    uint64_t flags;
+    __asm__ volatile("pushfq; pop %0" : "=r"(flags) : : "memory");
+
+    if (flags & RFLAGS_IF) {
+        preempt_check_resched();
+    }
+}
+
+void preempt_check_resched() {
+    if (!scheduler_enabled) {
+        return;
+    }
+
+    __asm__ volatile("cli");
+
+    cpu_t *cpu = cpu_current();
+    task_t *current = cpu->current;
+
+    if (cpu->need_resched && current != NULL && current->preempt_count == 0) {
+        scheduler_schedule();
+        return;
+    }
+
+    __asm__ volatile("sti");
+}
+
+static void scheduler_print_queue(cpu_t *cpu, task_queue_t *queue) {
+    for (task_t *cur = queue->head; cur != NULL; cur = cur->next) {
         const char *state = "UNKNOWN";
         switch (cur->state) {
         case TASK_READY:
@@ -217,10 +791,33 @@ void scheduler_print_tasks() {
             break;
         }
 
-        printkf("%d: task=%p state=%s stack=%llu entry=%p\n", cur->pid, (void *)cur, state, cur->stack_size,
-                (void *)cur->entry_point);
+        const char *policy = "NORMAL";
+        if (cur->policy == SCHED_FIFO) {
+            policy = "FIFO";
+        } else if (cur->policy == SCHED_RR) {
+            policy = "RR";
+        }
+
+        rusage_t usage;
+        scheduler_get_rusage(cur, &usage);
+
+        printkf("%d: cpu=%u task=%p state=%s policy=%s/%u run=%llums wait=%llums csw=%llu/%llu stack=%llu entry=%p\n",
+                cur->pid, cpu->id, (void *)cur, state, policy, cur->rt_priority, usage.runtime_ns / 1000000,
+                usage.wait_ns / 1000000, usage.nvcsw, usage.nivcsw, cur->stack_size, (void *)cur->entry_point);
+    }
+}
+
+void scheduler_print_tasks() {
+    for (uint32_t i = 0; i < cpu_count(); i++) {
+        cpu_t *cpu = cpu_get(i);
+        if (cpu == NULL || !cpu->online) {
+            continue;
+        }
 
-        cur = cur->next;
+        uint64_t flags = spin_lock(&cpu->rq.lock);
+        scheduler_print_queue(cpu, &cpu->rq.rt);
+        scheduler_print_queue(cpu, &cpu->rq.normal);
+        scheduler_print_queue(cpu, &cpu->rq.sleeping);
+        spin_unlock(&cpu->rq.lock, flags);
     }
-    spin_unlock(&scheduler_lock, flags);
 }
@@ -1,14 +1,59 @@
 #ifndef SCHEDULER_H
 #define SCHEDULER_H
 
+#include "../sync/spinlock.h"
 #include "task.h"
 
+#define RFLAGS_IF (1 << 9)
+
+#define SCHED_NORMAL 0
+#define SCHED_FIFO 1
+#define SCHED_RR 2
+
+#define SCHED_RT_PRIO_MIN 1
+#define SCHED_RT_PRIO_MAX 99
+
+#define SCHED_RR_TIMESLICE 10
+#define SCHED_RT_PERIOD 100
+#define SCHED_RT_RUNTIME 95
+
+typedef struct {
+    task_t *head;
+    task_t *tail;
+} task_queue_t;
+
+typedef struct {
+    spinlock_t lock;
+    task_queue_t normal;
+    task_queue_t rt;
+    task_queue_t sleeping;
+    uint32_t nr_tasks;
+    uint32_t nr_rt;
+    uint32_t rt_period_ticks;
+    uint32_t rt_runtime_ticks;
+    bool rt_throttled;
+} run_queue_t;
+
 void scheduler_init();
+void scheduler_init_cpu();
 void scheduler_schedule();
 void scheduler_add_task(task_t *task);
 void scheduler_remove_task(task_t *task);
+void scheduler_wake(task_t *task);
+int scheduler_set_policy(task_t *task, int policy, int priority);
+void scheduler_yield();
 void scheduler_enable();
+void scheduler_disable();
+int scheduler_is_enabled();
 void scheduler_tick();
+void scheduler_account_switch(task_t *prev, task_t *next);
+int scheduler_get_rusage(task_t *task, rusage_t *usage);
+void scheduler_idle();
 void scheduler_print_tasks();
 
+void preempt_disable();
+void preempt_enable();
+void preempt_enable_no_resched();
+void preempt_check_resched();
+
 #endif
@@ -2,29 +2,244 @@
 
 #include <stddef.h>
 
+#include "../arch/x86_64/cpu/cpu.h"
+#include "../arch/x86_64/fpu/fpu.h"
 #include "../arch/x86_64/gdt/gdt.h"
+#include "../arch/x86_64/tlb/tlb.h"
 #include "../drivers/timer/timer.h"
 #include "../elf/elf.h"
+#include "../fs/vfs/fdtable.h"
 #include "../fs/vfs/vfs.h"
 #include "../io/terminal.h"
 #include "../mem/alloc/heap.h"
 #include "../mem/alloc/page_frame_alloc.h"
 #include "../mem/paging/paging.h"
 #include "../std/string.h"
+#include "../syscall/ring.h"
+#include "../syscall/trace.h"
 #include "../sync/spinlock.h"
 #include "../usermode/usermode.h"
+#include "pid.h"
 #include "scheduler.h"
 
-static task_t *current_task = NULL;
-static task_t *task_list = NULL;
-static uint32_t next_pid = 1;
-
 static spinlock_t task_lock = {0};
 
 extern void scheduler_schedule();
 extern void task_switch_impl(cpu_state_t **old_context, cpu_state_t *new_context);
 
+static int task_register(task_t *task, task_t *parent) {
+    task->refcount = 1;
+    task->pid = pid_alloc();
+    if (task->pid == 0) {
+        printkf_error("task_register(): out of pids\n");
+        return -1;
+    }
+
+    if (parent != NULL) {
+        uint64_t flags = spin_lock(&task_lock);
+        if (task->is_thread && parent->is_thread)
+            parent = parent->parent;
+        if (parent != NULL) {
+            task->parent = parent;
+            task->parent_pid = parent->pid;
+            task->sibling = parent->children;
+            parent->children = task;
+        }
+        spin_unlock(&task_lock, flags);
+    }
+
+    pid_hash_insert(task);
+    return 0;
+}
+
+static bool task_release_group(task_t *task) {
+    thread_group_t *group = task->group;
+    if (group == NULL)
+        return true;
+
+    uint64_t flags = spin_lock(&group->lock);
+    uint32_t refcount = --group->refcount;
+    spin_unlock(&group->lock, flags);
+
+    task->group = NULL;
+    if (refcount > 0)
+        return false;
+
+    free(group);
+    return true;
+}
+
+bool task_has_threads(task_t *task) {
+    thread_group_t *group = task->group;
+    if (group == NULL)
+        return false;
+
+    uint64_t flags = spin_lock(&group->lock);
+    uint32_t refcount = group->refcount;
+    spin_unlock(&group->lock, flags);
+
+    return refcount > 1;
+}
+
+void thread_group_collapse(task_t *task) {
+    if (task->group == NULL || task_has_threads(task))
+        return;
+
+    free(task->group);
+    task->group = NULL;
+}
+
+static uint32_t task_stack_slot(task_t *task) {
+    return (USER_STACK_TOP - task->user_stack_virt - task->user_stack_size) / USER_THREAD_STACK_GAP;
+}
+
+static int thread_group_alloc_slot(thread_group_t *group) {
+    uint64_t flags = spin_lock(&group->lock);
+
+    for (uint32_t slot = 0; slot < THREAD_GROUP_MAX_STACKS; slot++) {
+        uint64_t bit = 1ULL << (slot % 64);
+        if (!(group->stack_slots[slot / 64] & bit)) {
+            group->stack_slots[slot / 64] |= bit;
+            spin_unlock(&group->lock, flags);
+            return slot;
+        }
+    }
+
+    spin_unlock(&group->lock, flags);
+    return -1;
+}
+
+static void thread_group_free_slot(thread_group_t *group, uint32_t slot) {
+    if (slot >= THREAD_GROUP_MAX_STACKS)
+        return;
+
+    uint64_t flags = spin_lock(&group->lock);
+    group->stack_slots[slot / 64] &= ~(1ULL << (slot % 64));
+    spin_unlock(&group->lock, flags);
+}
+
+static void task_release_thread_stack(task_t *task, page_table_t *page_table) {
+    void *virt = (void *)task->user_stack_virt;
+
+    page_direntry_t *pte = page_table_get_pte(page_table, virt);
+    if (pte != NULL && page_direntry_get_flag(pte, PAGE_PRESENT)) {
+        void *page = (void *)((page_direntry_get_address(pte) << 12) + page_get_offset());
+        pte->value = 0;
+        tlb_shootdown(page_table, virt);
+        pfallocator_unref_page(page);
+    }
+
+    thread_group_free_slot(task->group, task_stack_slot(task));
+}
+
+static void task_release_address_space(task_t *task) {
+    page_table_t *kernel_pml4 = page_get_pml4();
+    page_table_t *page_table = task->page_table;
+
+    if (page_table == NULL || page_table == kernel_pml4)
+        return;
+
+    uint64_t flags;
+    __asm__ volatile("pushfq; pop %0; cli" : "=r"(flags) : : "memory");
+
+    task->page_table = kernel_pml4;
+    if (task == task_current()) {
+        __atomic_store_n(&cpu_current()->page_table, kernel_pml4, __ATOMIC_SEQ_CST);
+        uint64_t kernel_cr3 = (uint64_t)kernel_pml4 - page_get_offset();
+        __asm__ volatile("mov %0, %%cr3" : : "r"(kernel_cr3) : "memory");
+    }
+
+    __asm__ volatile("push %0; popfq" : : "r"(flags) : "memory", "cc");
+
+    if (task->is_thread && task->group != NULL && task->user_stack != NULL)
+        task_release_thread_stack(task, page_table);
+
+    task->user_stack = NULL;
+    if (task_release_group(task))
+        page_table_destroy_user(page_table);
+}
+
+static void task_release_files(task_t *task) {
+    fd_table_t *fds = task->fds;
+    if (fds != NULL) {
+        task->fds = NULL;
+        fd_table_put(fds);
+    }
+}
+
+static void task_free(task_t *task) {
+    if (task->pid != 0) {
+        pid_hash_remove(task);
+        pid_free(task->pid);
+    }
+
+    task_release_address_space(task);
+    task_release_files(task);
+    fpu_release(task);
+
+    task_put(task);
+}
+
+static void task_unlink_child(task_t *task) {
+    task_t *parent = task->parent;
+    if (parent == NULL)
+        return;
+
+    task_t **link = &parent->children;
+    while (*link != NULL && *link != task) {
+        link = &(*link)->sibling;
+    }
+    if (*link == task) {
+        *link = task->sibling;
+    }
+
+    task->parent = NULL;
+    task->sibling = NULL;
+}
+
+static void task_orphan_children(task_t *task) {
+    task_t *zombies = NULL;
+
+    uint64_t flags = spin_lock(&task_lock);
+
+    task_t *child = task->children;
+    while (child != NULL) {
+        task_t *next = child->sibling;
+
+        child->parent = NULL;
+        child->sibling = NULL;
+        if (child->state == TASK_TERMINATED && !child->on_cpu && !child->joined) {
+            child->sibling = zombies;
+            zombies = child;
+        }
+
+        child = next;
+    }
+    task->children = NULL;
+
+    spin_unlock(&task_lock, flags);
+
+    while (zombies != NULL) {
+        task_t *next = zombies->sibling;
+        task_free(zombies);
+        zombies = next;
+    }
+}
+
+static void task_reap(task_t *task) {
+    while (task->on_cpu) {
+        cpu_relax();
+    }
+
+    uint64_t flags = spin_lock(&task_lock);
+    task_unlink_child(task);
+    spin_unlock(&task_lock, flags);
+
+    task_free(task);
+}
+
 static void task_entry_wrapper() {
+    task_switch_finish();
     __asm__ volatile("sti");
 
     task_t *self = task_current();
@@ -32,16 +247,12 @@ static void task_entry_wrapper() {
         self->entry_point();
     }
 
-    if (self != NULL) {
-        self->state = TASK_TERMINATED;
-    }
-
-    while (1) {
-        scheduler_schedule();
-    }
+    task_exit(0);
 }
 
 static void user_task_entry_wrapper() {
+    task_switch_finish();
+
     task_t *self = task_current();
     if (self == NULL || self->entry_point == NULL) {
         task_exit(0);
@@ -52,17 +263,13 @@ static void user_task_entry_wrapper() {
 
     uint64_t kernel_stack_top = (uint64_t)self->stack + self->stack_size;
     tss_set_kernel_stack(kernel_stack_top);
+    cpu_current()->kernel_stack = kernel_stack_top;
 
-    extern uint64_t current_kernel_stack;
-    current_kernel_stack = kernel_stack_top;
-
-    jump_to_usermode((uint64_t)self->entry_point, user_rsp);
+    jump_to_usermode_arg((uint64_t)self->entry_point, user_rsp, self->thread_arg);
 }
 
 void task_init() {
-    current_task = NULL;
-    task_list = NULL;
-    next_pid = 1;
+    pid_init();
 }
 
 task_t *task_create(void (*entry_point)(), uint64_t stack_size) {
@@ -71,6 +278,7 @@ task_t *task_create(void (*entry_point)(), uint64_t stack_size) {
         printkf_error("task_create(): failed to allocate task\n");
         return NULL;
     }
+    memset(task, 0, sizeof(task_t));
 
     task->stack = malloc(stack_size);
     if (task->stack == NULL) {
@@ -80,7 +288,6 @@ task_t *task_create(void (*entry_point)(), uint64_t stack_size) {
     }
 
     task->stack_size = stack_size;
-    task->pid = next_pid++;
     task->parent_pid = 0;
     task->state = TASK_READY;
     task->entry_point = entry_point;
@@ -105,8 +312,10 @@ task_t *task_create(void (*entry_point)(), uint64_t stack_size) {
 
     task->context = (cpu_state_t *)sp;
 
-    task->next = task_list;
-    task_list = task;
+    if (task_register(task, NULL) < 0) {
+        task_free(task);
+        return NULL;
+    }
 
     return task;
 }
@@ -119,6 +328,7 @@ task_t *task_create_user(void (*entry_point)(), uint64_t stack_size) {
         printkf_error("task_create_user(): failed to allocate task\n");
         return NULL;
     }
+    memset(task, 0, sizeof(task_t));
 
     task->stack = malloc(8192);
     if (task->stack == NULL) {
@@ -137,14 +347,14 @@ task_t *task_create_user(void (*entry_point)(), uint64_t stack_size) {
     }
 
     task->user_stack_size = 0x1000;
-    task->user_stack = pfallocator_request_page();
+    task->user_stack = pfallocator_request_zeroed_page();
     if (task->user_stack == NULL) {
         printkf_error("task_create_user(): failed to allocate user stack\n");
+        page_table_destroy_user(task->page_table);
         free(task->stack);
         free(task);
         return NULL;
     }
-    memset(task->user_stack, 0, 0x1000);
 
     task->user_stack_virt = USER_STACK_TOP - task->user_stack_size;
 
@@ -152,7 +362,14 @@ task_t *task_create_user(void (*entry_point)(), uint64_t stack_size) {
     void *phys_addr = (void *)((uint64_t)task->user_stack - hhdm_offset);
     page_map_memory_to(task->page_table, (void *)task->user_stack_virt, phys_addr);
 
-    task->pid = next_pid++;
+    task->fds = fd_table_create();
+    if (task->fds == NULL) {
+        page_table_destroy_user(task->page_table);
+        free(task->stack);
+        free(task);
+        return NULL;
+    }
+
     task->parent_pid = 0;
     task->state = TASK_READY;
     task->entry_point = entry_point;
@@ -174,31 +391,32 @@ task_t *task_create_user(void (*entry_point)(), uint64_t stack_size) {
 
     task->context = (cpu_state_t *)sp;
 
-    task->next = task_list;
-    task_list = task;
+    if (task_register(task, NULL) < 0) {
+        task_free(task);
+        return NULL;
+    }
 
     return task;
 }
 
 task_t *task_create_elf(const char *path, uint64_t stack_size) {
-    int fd = vfs_open(path, O_RDONLY);
-    if (fd < 0) {
+    vfs_file_t *file = vfs_file_open(path, O_RDONLY);
+    if (file == NULL) {
         printkf_error("task_create_from_elf: failed to open '%s'\n", path);
         return NULL;
     }
 
-    int64_t size = vfs_seek(fd, 0, SEEK_END);
-    vfs_seek(fd, 0, SEEK_SET);
+    int64_t size = file->node->inode->size;
 
     void *elf_data = malloc(size);
     if (elf_data == NULL) {
-        vfs_close(fd);
+        vfs_file_put(file);
         printkf_error("task_create_from_elf(): out of memory\n");
         return NULL;
     }
 
-    vfs_read(fd, elf_data, size);
-    vfs_close(fd);
+    vfs_file_pread(file, elf_data, size, 0);
+    vfs_file_put(file);
 
     task_t *task = task_create_user(NULL, stack_size);
     if (task == NULL) {
@@ -210,6 +428,7 @@ task_t *task_create_elf(const char *path, uint64_t stack_size) {
     if (elf_load(elf_data, &entry, task->page_table) < 0) {
         printkf_error("task_create_from_elf(): failed to load '%s'\n", path);
         free(elf_data);
+        task_free(task);
         return NULL;
     }
     free(elf_data);
@@ -219,20 +438,183 @@ task_t *task_create_elf(const char *path, uint64_t stack_size) {
     return task;
 }
 
-task_t *task_find_by_pid(uint32_t pid) {
-    uint64_t flags = spin_lock(&task_lock);
-    task_t *t = task_list;
-    while (t != NULL) {
-        if (t->pid == pid) {
-            spin_unlock(&task_lock, flags);
-            return t;
+task_t *task_create_idle() {
+    task_t *task = (task_t *)malloc(sizeof(task_t));
+    if (task == NULL) {
+        printkf_error("task_create_idle(): failed to allocate task\n");
+        return NULL;
+    }
+    memset(task, 0, sizeof(task_t));
+
+    task->pid = 0;
+    task->state = TASK_RUNNING;
+    task->page_table = page_get_pml4();
+    task->entry_point = scheduler_idle;
+    task->cpu = cpu_current()->id;
+    task->on_cpu = 1;
+
+    return task;
+}
+
+task_t *task_create_thread(void (*entry_point)(), uint64_t arg, uint64_t fs_base) {
+    task_t *parent = task_current();
+    if (parent == NULL || !parent->is_user) {
+        printkf_error("task_create_thread(): no current user task\n");
+        return NULL;
+    }
+
+    if (parent->group == NULL) {
+        thread_group_t *group = (thread_group_t *)malloc(sizeof(thread_group_t));
+        if (group == NULL) {
+            printkf_error("task_create_thread(): failed to allocate thread group\n");
+            return NULL;
         }
-        t = t->next;
+        memset(group, 0, sizeof(thread_group_t));
+        group->refcount = 1;
+
+        uint32_t slot = task_stack_slot(parent);
+        if (slot < THREAD_GROUP_MAX_STACKS)
+            group->stack_slots[slot / 64] |= 1ULL << (slot % 64);
+        parent->group = group;
     }
-    spin_unlock(&task_lock, flags);
+
+    task_t *thread = (task_t *)malloc(sizeof(task_t));
+    if (thread == NULL) {
+        printkf_error("task_create_thread(): failed to allocate task\n");
+        return NULL;
+    }
+    memset(thread, 0, sizeof(task_t));
+
+    thread->stack = malloc(8192);
+    if (thread->stack == NULL) {
+        printkf_error("task_create_thread(): failed to allocate kernel stack\n");
+        free(thread);
+        return NULL;
+    }
+    thread->stack_size = 8192;
+
+    void *user_stack = pfallocator_request_zeroed_page();
+    if (user_stack == NULL) {
+        printkf_error("task_create_thread(): failed to allocate user stack\n");
+        free(thread->stack);
+        free(thread);
+        return NULL;
+    }
+
+    thread_group_t *group = parent->group;
+    int slot = thread_group_alloc_slot(group);
+    if (slot < 0) {
+        printkf_error("task_create_thread(): too many threads\n");
+        pfallocator_free_page(user_stack);
+        free(thread->stack);
+        free(thread);
+        return NULL;
+    }
+
+    thread->user_stack = user_stack;
+    thread->user_stack_size = 0x1000;
+    thread->user_stack_virt = USER_STACK_TOP - slot * USER_THREAD_STACK_GAP - thread->user_stack_size;
+
+    void *phys_addr = (void *)((uint64_t)user_stack - page_get_offset());
+    page_map_memory_to(parent->page_table, (void *)thread->user_stack_virt, phys_addr);
+
+    uint64_t flags = spin_lock(&group->lock);
+    group->refcount++;
+    spin_unlock(&group->lock, flags);
+
+    thread->page_table = parent->page_table;
+    thread->group = group;
+    thread->fds = parent->fds;
+    if (thread->fds != NULL)
+        fd_table_get(thread->fds);
+    thread->parent_pid = parent->pid;
+    thread->state = TASK_READY;
+    thread->entry_point = entry_point;
+    thread->is_user = 1;
+    thread->is_thread = 1;
+    thread->thread_arg = arg;
+    thread->fs_base = fs_base;
+    thread->policy = parent->policy;
+    thread->rt_priority = parent->rt_priority;
+    thread->rt_slice = SCHED_RR_TIMESLICE;
+
+    uint64_t kstack_top = (uint64_t)thread->stack + thread->stack_size;
+    kstack_top &= ~0xFULL;
+    uint64_t *sp = (uint64_t *)kstack_top;
+
+    *--sp = (uint64_t)user_task_entry_wrapper;
+    *--sp = 0;
+    *--sp = 0;
+    *--sp = 0;
+    *--sp = 0;
+    *--sp = 0;
+    *--sp = 0;
+
+    thread->context = (cpu_state_t *)sp;
+
+    if (task_register(thread, parent) < 0) {
+        task_free(thread);
+        return NULL;
+    }
+    thread->parent_pid = parent->pid;
+    scheduler_add_task(thread);
+
+    return thread;
+}
+
+void task_set_fs_base(uint64_t fs_base) {
+    task_t *current = task_current();
+    if (current == NULL)
+        return;
+
+    cli();
+    current->fs_base = fs_base;
+    wrmsr(MSR_FS_BASE, fs_base);
+    sti();
+}
+
+task_t *task_find_by_pid(uint32_t pid) {
+    return pid_hash_find(pid);
+}
+
+task_t *task_get(uint32_t pid) {
+    return pid_hash_get(pid);
+}
+
+task_t *task_get_next(uint32_t pid) {
+    if (pid == 0)
+        pid = 1;
+
+    while ((pid = pid_next_used(pid)) != 0) {
+        task_t *task = pid_hash_get(pid);
+        if (task != NULL)
+            return task;
+        pid++;
+    }
+
     return NULL;
 }
 
+void task_put(task_t *task) {
+    if (__atomic_sub_fetch(&task->refcount, 1, __ATOMIC_ACQ_REL) != 0)
+        return;
+
+    trace_release(task);
+
+    if (task->stack)
+        free(task->stack);
+
+    free(task);
+}
+
+bool task_owned_by(task_t *task, task_t *owner) {
+    uint64_t flags = spin_lock(&task_lock);
+    bool same_group = task->group != NULL && task->group == owner->group;
+    bool owned = task == owner || task->parent == owner || same_group;
+    spin_unlock(&task_lock, flags);
+    return owned;
+}
+
 task_t *task_fork() {
     task_t *parent = task_current();
     if (parent == NULL) {
@@ -245,6 +627,7 @@ task_t *task_fork() {
         printkf_error("fork(): failed to allocate child task\n");
         return NULL;
     }
+    memset(child, 0, sizeof(task_t));
 
     child->stack = malloc(parent->stack_size);
     if (child->stack == NULL) {
@@ -264,31 +647,57 @@ task_t *task_fork() {
         free(child);
         return NULL;
     }
+    tlb_shootdown_all(parent->page_table);
 
     uint64_t hhdm_offset = page_get_offset();
     child->user_stack = pfallocator_request_page();
     if (child->user_stack == NULL) {
         printkf_error("fork(): failed to allocate user stack\n");
+        page_table_destroy_user(child->page_table);
         free(child->stack);
         free(child);
         return NULL;
     }
     memcpy(child->user_stack, parent->user_stack, 0x1000);
+
+    page_direntry_t *stack_pte = page_table_get_pte(child->page_table, (void *)child->user_stack_virt);
+    if (stack_pte != NULL && page_direntry_get_flag(stack_pte, PAGE_PRESENT)) {
+        pfallocator_unref_page((void *)((page_direntry_get_address(stack_pte) << 12) + hhdm_offset));
+    }
     void *phys_addr = (void *)((uint64_t)child->user_stack - hhdm_offset);
     page_map_memory_to(child->page_table, (void *)child->user_stack_virt, phys_addr);
 
-    child->pid = next_pid++;
-    child->parent_pid = parent->pid;
     child->state = TASK_READY;
     child->entry_point = parent->entry_point;
     child->wake_tick = 0;
     child->is_user = parent->is_user;
     child->exit_code = 0;
+    child->fs_base = parent->fs_base;
+    child->policy = parent->policy;
+    child->rt_priority = parent->rt_priority;
+    child->rt_slice = SCHED_RR_TIMESLICE;
+
+    if (parent->fds != NULL) {
+        child->fds = fd_table_clone(parent->fds);
+        if (child->fds == NULL) {
+            page_table_destroy_user(child->page_table);
+            free(child->stack);
+            free(child);
+            return NULL;
+        }
+    }
+
+    if (fpu_fork(parent, child) < 0) {
+        task_release_files(child);
+        page_table_destroy_user(child->page_table);
+        free(child->stack);
+        free(child);
+        return NULL;
+    }
 
     extern void fork_child_return();
-    extern uint64_t saved_syscall_rsp;
 
-    uint64_t syscall_offset = saved_syscall_rsp - (uint64_t)parent->stack;
+    uint64_t syscall_offset = (uint64_t)parent->syscall_frame - (uint64_t)parent->stack;
     uint64_t child_syscall_rsp = (uint64_t)child->stack + syscall_offset;
 
     uint64_t *child_sp = (uint64_t *)(child_syscall_rsp - 7 * sizeof(uint64_t));
@@ -302,117 +711,159 @@ task_t *task_fork() {
 
     child->context = (cpu_state_t *)child_sp;
 
-    uint64_t flags = spin_lock(&task_lock);
-    child->next = task_list;
-    task_list = child;
-    spin_unlock(&task_lock, flags);
+    if (task_register(child, parent) < 0) {
+        task_free(child);
+        return NULL;
+    }
     scheduler_add_task(child);
 
     return child;
 }
 
-static void task_remove_from_list(task_t *task) {
+int task_waitpid(uint32_t pid) {
+    task_t *parent = task_current();
+
     uint64_t flags = spin_lock(&task_lock);
 
-    if (task_list == task) {
-        task_list = task->next;
-    } else {
-        task_t *prev = task_list;
-        while (prev != NULL && prev->next != task) {
-            prev = prev->next;
-        }
-        if (prev != NULL) {
-            prev->next = task->next;
-        }
+    task_t *child = task_find_by_pid(pid);
+    if (child == NULL || child->parent != parent || child->joined) {
+        spin_unlock(&task_lock, flags);
+        return -1;
     }
+    child->joined = 1;
 
     spin_unlock(&task_lock, flags);
-}
 
-static void task_destroy(task_t *task) {
-    if (task == NULL)
-        return;
+    wait_event(&child->exit_wq, child->state == TASK_TERMINATED);
 
-    scheduler_remove_task(task);
-    task_remove_from_list(task);
+    int exit_code = child->exit_code;
 
-    if (task->stack)
-        free(task->stack);
-    if (task->user_stack)
-        pfallocator_free_page(task->user_stack);
-    if (task->page_table)
-        page_table_destroy_user(task->page_table);
+    task_reap(child);
 
-    free(task);
+    return exit_code;
 }
 
-int task_waitpid(uint32_t pid) {
-    task_t *child = task_find_by_pid(pid);
-    if (child == NULL) {
-        return -1;
-    }
+int task_join(uint32_t tid) {
+    task_t *current = task_current();
 
-    task_t *parent = task_current();
-    if (child->parent_pid != parent->pid) {
+    uint64_t flags = spin_lock(&task_lock);
+
+    task_t *leader = current->is_thread ? current->parent : current;
+    task_t *thread = task_find_by_pid(tid);
+    if (thread == NULL || thread == current || !thread->is_thread || leader == NULL || thread->parent != leader ||
+        thread->joined) {
+        spin_unlock(&task_lock, flags);
         return -1;
     }
+    thread->joined = 1;
 
-    while (child->state != TASK_TERMINATED) {
-        task_yield();
-    }
+    spin_unlock(&task_lock, flags);
 
-    int exit_code = child->exit_code;
+    wait_event(&thread->exit_wq, thread->state == TASK_TERMINATED);
 
-    task_destroy(child);
+    int exit_code = thread->exit_code;
+
+    task_reap(thread);
 
     return exit_code;
 }
 
 task_t *task_current() {
-    return current_task;
+    return cpu_current_task();
 }
 
 void task_switch(task_t *next) {
-    if (next == NULL || next == current_task) {
+    cpu_t *cpu = cpu_current();
+    task_t *old_task = cpu->current;
+
+    if (next == NULL || next == old_task) {
         return;
     }
 
-    task_t *old_task = current_task;
+    scheduler_account_switch(old_task, next);
 
     if (old_task != NULL && old_task->state == TASK_RUNNING) {
         old_task->state = TASK_READY;
     }
 
     next->state = TASK_RUNNING;
-    current_task = next;
+    next->cpu = cpu->id;
+    next->on_cpu = 1;
+    cpu->current = next;
+    cpu->prev = old_task;
 
-    uint64_t hhdm_offset = page_get_offset();
-    uint64_t new_cr3_phys = (uint64_t)next->page_table - hhdm_offset;
+    __atomic_store_n(&cpu->page_table, next->page_table, __ATOMIC_SEQ_CST);
+    if (old_task == NULL || old_task->page_table != next->page_table) {
+        uint64_t hhdm_offset = page_get_offset();
+        uint64_t new_cr3_phys = (uint64_t)next->page_table - hhdm_offset;
+
+        __asm__ volatile("mov %0, %%cr3" : : "r"(new_cr3_phys) : "memory");
+    }
 
-    __asm__ volatile("mov %0, %%cr3" : : "r"(new_cr3_phys) : "memory");
+    fpu_switch(old_task, next);
 
-    uint64_t kernel_stack_top = (uint64_t)next->stack + next->stack_size;
-    tss_set_kernel_stack(kernel_stack_top);
+    if (old_task == NULL || old_task->fs_base != next->fs_base) {
+        wrmsr(MSR_FS_BASE, next->fs_base);
+    }
 
-    extern uint64_t current_kernel_stack;
-    current_kernel_stack = kernel_stack_top;
+    if (next->stack != NULL) {
+        uint64_t kernel_stack_top = (uint64_t)next->stack + next->stack_size;
+        tss_set_kernel_stack(kernel_stack_top);
+        cpu->kernel_stack = kernel_stack_top;
+    }
 
     if (old_task != NULL) {
         task_switch_impl(&old_task->context, next->context);
     } else {
         task_switch_impl(NULL, next->context);
     }
+
+    task_switch_finish();
+}
+
+static void task_finish_exit(task_t *task) {
+    scheduler_remove_task(task);
+
+    if (task->stack) {
+        free(task->stack);
+        task->stack = NULL;
+    }
+
+    uint64_t flags = spin_lock(&task_lock);
+    bool reap = task->parent == NULL && !task->joined;
+    task->on_cpu = 0;
+    spin_unlock(&task_lock, flags);
+
+    if (reap)
+        task_free(task);
+}
+
+void task_switch_finish() {
+    cpu_t *cpu = cpu_current();
+    task_t *prev = cpu->prev;
+
+    if (prev == NULL)
+        return;
+
+    cpu->prev = NULL;
+
+    if (prev->state == TASK_TERMINATED) {
+        task_finish_exit(prev);
+    } else {
+        prev->on_cpu = 0;
+    }
 }
 
 void task_yield() {
-    scheduler_schedule();
+    scheduler_yield();
 }
 
 void task_block() {
     uint64_t flags = spin_lock(&task_lock);
 
-    if (current_task != NULL) {
-        current_task->state = TASK_BLOCKED;
+    task_t *current = task_current();
+    if (current != NULL) {
+        current->state = TASK_BLOCKED;
     }
 
     spin_unlock(&task_lock, flags);
@@ -426,10 +877,7 @@ void task_unblock(task_t *task) {
 
     uint64_t flags = spin_lock(&task_lock);
 
-    if (task->state == TASK_BLOCKED) {
-        task->state = TASK_READY;
-        task->wake_tick = 0;
-    }
+    scheduler_wake(task);
 
     spin_unlock(&task_lock, flags);
 }
@@ -437,7 +885,9 @@ void task_unblock(task_t *task) {
 void sleep_ms(uint64_t ms) {
     if (ms == 0)
         return;
-    if (current_task == NULL)
+
+    task_t *current = task_current();
+    if (current == NULL)
         return;
 
     uint64_t ticks_to_sleep = (ms + 9) / 10;
@@ -447,8 +897,8 @@ void sleep_ms(uint64_t ms) {
     __asm__ volatile("cli");
 
     uint64_t now = timer_get_ticks();
-    current_task->wake_tick = now + ticks_to_sleep;
-    current_task->state = TASK_BLOCKED;
+    current->wake_tick = now + ticks_to_sleep;
+    current->state = TASK_BLOCKED;
 
     scheduler_schedule();
 }
@@ -457,12 +907,21 @@ void task_exit(int code) {
     task_t *current = task_current();
 
     if (current != NULL) {
-        current->state = TASK_TERMINATED;
-        current->exit_code = code;
+        ring_destroy(current);
+        task_release_address_space(current);
+        task_release_files(current);
+        fpu_release(current);
+        task_orphan_children(current);
     }
 
     cli();
 
+    if (current != NULL) {
+        current->exit_code = code;
+        current->state = TASK_TERMINATED;
+        wait_queue_wake_all(&current->exit_wq);
+    }
+
     scheduler_schedule();
 
     printkf_error("task_exit(): SHOULD NEVER REACH HERE\n");
@@ -4,6 +4,9 @@
 #include <stdint.h>
 
 #include "../mem/paging/paging.h"
+#include "../sync/spinlock.h"
+#include "../sync/waitqueue.h"
+#include "rusage.h"
 
 typedef enum {
     TASK_READY,
@@ -23,10 +26,36 @@ typedef struct {
 } __attribute__((packed)) cpu_state_t;
 
 #define USER_STACK_TOP 0x7FFFFFF00000ULL
+#define USER_THREAD_STACK_GAP 0x10000ULL
+#define THREAD_GROUP_MAX_STACKS 256
+
+typedef struct {
+    volatile uint32_t refcount;
+    spinlock_t lock;
+    uint64_t stack_slots[THREAD_GROUP_MAX_STACKS / 64];
+} thread_group_t;
+
+typedef struct {
+    uint64_t runtime_ns;
+    uint64_t wait_ns;
+    uint64_t sleep_ns;
+    uint64_t user_ticks;
+    uint64_t system_ticks;
+    uint64_t nvcsw;
+    uint64_t nivcsw;
+    uint64_t wakeups;
+    uint64_t max_wakeup_latency_ns;
+    uint64_t wakeup_latency_hist[RUSAGE_LATENCY_BUCKETS];
+    uint64_t exec_start;
+    uint64_t enqueue_stamp;
+    uint64_t sleep_stamp;
+    bool woken;
+} task_stats_t;
 
 typedef struct task {
     uint32_t pid;
     uint32_t parent_pid;
+    volatile uint32_t refcount;
     task_state_t state;
     cpu_state_t *context;
     void *stack;
@@ -34,20 +63,52 @@ typedef struct task {
     uint64_t stack_size;
     void (*entry_point)();
     struct task *next;
+    struct task *pid_next;
+    struct task *parent;
+    struct task *children;
+    struct task *sibling;
     uint64_t wake_tick;
     void *user_stack;
     uint64_t user_stack_virt;
     uint64_t user_stack_size;
     uint8_t is_user;
+    uint8_t is_thread;
+    uint8_t joined;
     int exit_code;
+    uint32_t cpu;
+    volatile uint8_t on_cpu;
+    uint8_t on_rq;
+    uint8_t on_sleep_queue;
+    wait_queue_t exit_wq;
+    struct syscall_frame *syscall_frame;
+    volatile int preempt_count;
+    thread_group_t *group;
+    uint64_t thread_arg;
+    uint64_t fs_base;
+    void *fpu_state;
+    uint32_t fpu_cpu;
+    uint8_t policy;
+    uint8_t rt_priority;
+    uint32_t rt_slice;
+    task_stats_t stats;
+    struct ring *ring;
+    struct syscall_trace *trace;
+    struct fd_table *fds;
 } task_t;
 
 void task_init();
 task_t *task_create(void (*entry_point)(), uint64_t stack_size);
 task_t *task_create_user(void (*entry_point)(), uint64_t stack_size);
 task_t *task_create_elf(const char *path, uint64_t stack_size);
+task_t *task_create_idle();
+task_t *task_create_thread(void (*entry_point)(), uint64_t arg, uint64_t fs_base);
+int task_join(uint32_t tid);
+bool task_has_threads(task_t *task);
+void thread_group_collapse(task_t *task);
+void task_set_fs_base(uint64_t fs_base);
 task_t *task_current();
 void task_switch(task_t *next);
+void task_switch_finish();
 void task_yield();
 void task_block();
 void task_unblock(task_t *task);
@@ -57,3 +118,7 @@ void task_exit(int code);
 task_t *task_fork();
 int task_waitpid(uint32_t pid);
 task_t *task_find_by_pid(uint32_t pid);
+task_t *task_get(uint32_t pid);
+task_t *task_get_next(uint32_t pid);
+void task_put(task_t *task);
+bool task_owned_by(task_t *task, task_t *owner);
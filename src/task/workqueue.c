@@ -0,0 +1,277 @@
+#include "workqueue.h"
+
+#include <stddef.h>
+
+#include "../drivers/timer/timer.h"
+#include "../io/terminal.h"
+#include "../mem/alloc/heap.h"
+#include "../std/string.h"
+#include "scheduler.h"
+
+workqueue_t *system_wq = NULL;
+
+static void workqueue_append(workqueue_t *wq, work_t *work) {
+    work->next = NULL;
+
+    if (wq->tail == NULL) {
+        wq->head = work;
+        wq->tail = work;
+    } else {
+        wq->tail->next = work;
+        wq->tail = work;
+    }
+
+    wq->nr_pending++;
+}
+
+static work_t *workqueue_pop(workqueue_t *wq) {
+    work_t *work = wq->head;
+    if (work == NULL)
+        return NULL;
+
+    wq->head = work->next;
+    if (wq->head == NULL)
+        wq->tail = NULL;
+
+    work->next = NULL;
+    wq->nr_pending--;
+    return work;
+}
+
+static void workqueue_promote_delayed(workqueue_t *wq) {
+    uint64_t now = timer_get_ticks();
+
+    while (wq->delayed != NULL && wq->delayed->expires <= now) {
+        work_t *work = wq->delayed;
+        wq->delayed = work->next;
+        work->delayed = false;
+        workqueue_append(wq, work);
+    }
+}
+
+static bool workqueue_has_ready(workqueue_t *wq, uint32_t generation) {
+    if (wq->head != NULL || wq->generation != generation)
+        return true;
+
+    work_t *delayed = wq->delayed;
+    return delayed != NULL && delayed->expires <= timer_get_ticks();
+}
+
+static void workqueue_worker() {
+    workqueue_t *wq = (workqueue_t *)task_current()->thread_arg;
+
+    while (1) {
+        uint64_t flags = spin_lock(&wq->lock);
+
+        workqueue_promote_delayed(wq);
+
+        work_t *work = workqueue_pop(wq);
+        if (work != NULL) {
+            work->pending = false;
+            work->running = true;
+            wq->active++;
+            spin_unlock(&wq->lock, flags);
+
+            work->func(work);
+
+            flags = spin_lock(&wq->lock);
+            work->running = false;
+            wq->active--;
+            spin_unlock(&wq->lock, flags);
+
+            wait_queue_wake_all(&wq->flush_wq);
+            continue;
+        }
+
+        uint32_t generation = wq->generation;
+        uint64_t timeout_ms = 0;
+        if (wq->delayed != NULL) {
+            uint64_t now = timer_get_ticks();
+            uint64_t ticks = wq->delayed->expires > now ? wq->delayed->expires - now : 1;
+            timeout_ms = (ticks * 1000) / timer_get_frequency();
+            if (timeout_ms == 0)
+                timeout_ms = 1;
+        }
+
+        spin_unlock(&wq->lock, flags);
+
+        wait_event_timeout(&wq->work_wq, workqueue_has_ready(wq, generation), timeout_ms);
+    }
+}
+
+workqueue_t *workqueue_create(const char *name, uint32_t max_active, uint32_t flags) {
+    if (max_active == 0 || max_active > WORKQUEUE_MAX_WORKERS) {
+        printkf_error("workqueue_create(): invalid concurrency %u for '%s'\n", max_active, name);
+        return NULL;
+    }
+
+    workqueue_t *wq = (workqueue_t *)malloc(sizeof(workqueue_t));
+    if (wq == NULL) {
+        printkf_error("workqueue_create(): failed to allocate workqueue\n");
+        return NULL;
+    }
+    memset(wq, 0, sizeof(workqueue_t));
+
+    wq->name = name;
+    wq->flags = flags;
+    wq->max_active = max_active;
+    wait_queue_init(&wq->work_wq);
+    wait_queue_init(&wq->flush_wq);
+
+    for (uint32_t i = 0; i < max_active; i++) {
+        task_t *worker = task_create(workqueue_worker, WORKQUEUE_STACK_SIZE);
+        if (worker == NULL) {
+            printkf_error("workqueue_create(): failed to create worker %u for '%s'\n", i, name);
+            break;
+        }
+
+        worker->thread_arg = (uint64_t)wq;
+        if (flags & WQ_HIGHPRI) {
+            scheduler_set_policy(worker, SCHED_FIFO, WQ_HIGHPRI_PRIORITY);
+        }
+
+        wq->workers[i] = worker;
+        scheduler_add_task(worker);
+    }
+
+    if (wq->workers[0] == NULL) {
+        free(wq);
+        return NULL;
+    }
+
+    return wq;
+}
+
+void workqueue_init() {
+    system_wq = workqueue_create("events", 2, 0);
+    if (system_wq == NULL) {
+        panic("workqueue_init(): failed to create system workqueue");
+    }
+}
+
+void work_init(work_t *work, work_func_t func) {
+    memset(work, 0, sizeof(work_t));
+    work->func = func;
+}
+
+bool queue_work(workqueue_t *wq, work_t *work) {
+    uint64_t flags = spin_lock(&wq->lock);
+
+    if (work->pending || work->canceling) {
+        spin_unlock(&wq->lock, flags);
+        return false;
+    }
+
+    work->pending = true;
+    work->wq = wq;
+    workqueue_append(wq, work);
+
+    spin_unlock(&wq->lock, flags);
+
+    wait_queue_wake_one(&wq->work_wq);
+    return true;
+}
+
+bool queue_delayed_work(workqueue_t *wq, work_t *work, uint64_t delay_ms) {
+    if (delay_ms == 0)
+        return queue_work(wq, work);
+
+    uint64_t ticks = (delay_ms * timer_get_frequency() + 999) / 1000;
+    if (ticks == 0)
+        ticks = 1;
+
+    uint64_t flags = spin_lock(&wq->lock);
+
+    if (work->pending || work->canceling) {
+        spin_unlock(&wq->lock, flags);
+        return false;
+    }
+
+    work->pending = true;
+    work->delayed = true;
+    work->wq = wq;
+    work->expires = timer_get_ticks() + ticks;
+
+    work_t **link = &wq->delayed;
+    while (*link != NULL && (*link)->expires <= work->expires) {
+        link = &(*link)->next;
+    }
+    work->next = *link;
+    *link = work;
+
+    wq->generation++;
+
+    spin_unlock(&wq->lock, flags);
+
+    wait_queue_wake_one(&wq->work_wq);
+    return true;
+}
+
+static bool work_is_running(workqueue_t *wq, work_t *work) {
+    uint64_t flags = spin_lock(&wq->lock);
+    bool running = work->running;
+    spin_unlock(&wq->lock, flags);
+    return running;
+}
+
+static bool workqueue_is_idle(workqueue_t *wq) {
+    uint64_t flags = spin_lock(&wq->lock);
+    bool idle = wq->head == NULL && wq->active == 0;
+    spin_unlock(&wq->lock, flags);
+    return idle;
+}
+
+bool cancel_work(work_t *work) {
+    workqueue_t *wq = work->wq;
+    if (wq == NULL)
+        return false;
+
+    uint64_t flags = spin_lock(&wq->lock);
+
+    bool was_pending = work->pending;
+    work->canceling = true;
+
+    if (work->pending && work->delayed) {
+        work_t **link = &wq->delayed;
+        while (*link != NULL && *link != work) {
+            link = &(*link)->next;
+        }
+        if (*link == work)
+            *link = work->next;
+        work->delayed = false;
+    } else if (work->pending) {
+        work_t *prev = NULL;
+        for (work_t *cur = wq->head; cur != NULL; prev = cur, cur = cur->next) {
+            if (cur != work)
+                continue;
+
+            if (prev == NULL)
+                wq->head = cur->next;
+            else
+                prev->next = cur->next;
+            if (wq->tail == cur)
+                wq->tail = prev;
+            wq->nr_pending--;
+            break;
+        }
+    }
+
+    if (was_pending) {
+        work->next = NULL;
+        work->pending = false;
+    }
+
+    spin_unlock(&wq->lock, flags);
+
+    wait_event(&wq->flush_wq, !work_is_running(wq, work));
+
+    flags = spin_lock(&wq->lock);
+    work->canceling = false;
+    spin_unlock(&wq->lock, flags);
+
+    return was_pending;
+}
+
+void flush_workqueue(workqueue_t *wq) {
+    wait_event(&wq->flush_wq, workqueue_is_idle(wq));
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../sync/spinlock.h"
+#include "../sync/waitqueue.h"
+#include "task.h"
+
+#define WORKQUEUE_MAX_WORKERS 8
+#define WORKQUEUE_STACK_SIZE 8192
+
+#define WQ_HIGHPRI (1 << 0)
+#define WQ_HIGHPRI_PRIORITY 40
+
+struct work;
+struct workqueue;
+
+typedef void (*work_func_t)(struct work *work);
+
+typedef struct work {
+    work_func_t func;
+    struct work *next;
+    struct workqueue *wq;
+    uint64_t expires;
+    volatile bool pending;
+    volatile bool delayed;
+    volatile bool running;
+    volatile bool canceling;
+} work_t;
+
+typedef struct workqueue {
+    const char *name;
+    uint32_t flags;
+    spinlock_t lock;
+    work_t *head;
+    work_t *tail;
+    work_t *delayed;
+    uint32_t nr_pending;
+    uint32_t active;
+    uint32_t max_active;
+    volatile uint32_t generation;
+    wait_queue_t work_wq;
+    wait_queue_t flush_wq;
+    task_t *workers[WORKQUEUE_MAX_WORKERS];
+} workqueue_t;
+
+extern workqueue_t *system_wq;
+
+void workqueue_init();
+workqueue_t *workqueue_create(const char *name, uint32_t max_active, uint32_t flags);
+
+void work_init(work_t *work, work_func_t func);
+bool queue_work(workqueue_t *wq, work_t *work);
+bool queue_delayed_work(workqueue_t *wq, work_t *work, uint64_t delay_ms);
+bool cancel_work(work_t *work);
+void flush_workqueue(workqueue_t *wq);
+
+static inline bool schedule_work(work_t *work) {
+    return queue_work(system_wq, work);
+}
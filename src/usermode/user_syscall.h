@@ -4,7 +4,16 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "../fs/vfs/fdtable.h"
+#include "../fs/vfs/page_cache.h"
+#include "../fs/vfs/vfs.h"
+#include "../ipc/poll.h"
+#include "../ipc/shm.h"
+#include "../syscall/ring.h"
 #include "../syscall/syscall.h"
+#include "../syscall/trace.h"
+#include "../task/cpustat.h"
+#include "../task/rusage.h"
 
 static inline uint64_t syscall0(uint64_t num) {
     uint64_t ret;
@@ -30,6 +39,16 @@ static inline uint64_t syscall3(uint64_t num, uint64_t arg1, uint64_t arg2, uint
     return ret;
 }
 
+static inline uint64_t syscall4(uint64_t num, uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4) {
+    uint64_t ret;
+    register uint64_t r10 __asm__("r10") = arg4;
+    __asm__ volatile("syscall"
+                     : "=a"(ret)
+                     : "a"(num), "D"(arg1), "S"(arg2), "d"(arg3), "r"(r10)
+                     : "rcx", "r11", "memory");
+    return ret;
+}
+
 static inline void exit(int code) {
     syscall1(SYS_EXIT, code);
     __builtin_unreachable();
@@ -67,6 +86,22 @@ static inline int64_t read(int fd, void *buf, size_t len) {
     return syscall3(SYS_READ, fd, (uint64_t)buf, len);
 }
 
+static inline int64_t pread(int fd, void *buf, size_t len, uint64_t offset) {
+    return syscall4(SYS_PREAD, fd, (uint64_t)buf, len, offset);
+}
+
+static inline int64_t pwrite(int fd, const void *buf, size_t len, uint64_t offset) {
+    return syscall4(SYS_PWRITE, fd, (uint64_t)buf, len, offset);
+}
+
+static inline int64_t readv(int fd, const vfs_iovec_t *iov, int iovcnt) {
+    return syscall3(SYS_READV, fd, (uint64_t)iov, iovcnt);
+}
+
+static inline int64_t writev(int fd, const vfs_iovec_t *iov, int iovcnt) {
+    return syscall3(SYS_WRITEV, fd, (uint64_t)iov, iovcnt);
+}
+
 static inline int open(const char *path, int flags) {
     return syscall2(SYS_OPEN, (uint64_t)path, flags);
 }
@@ -87,10 +122,136 @@ static inline int readdir(int fd, char *name, size_t size) {
     return syscall3(SYS_READDIR, fd, (uint64_t)name, size);
 }
 
+static inline int stat(const char *path, vfs_stat_t *st) {
+    return syscall2(SYS_STAT, (uint64_t)path, (uint64_t)st);
+}
+
+static inline int fstat(int fd, vfs_stat_t *st) {
+    return syscall2(SYS_FSTAT, fd, (uint64_t)st);
+}
+
+static inline int64_t getdents(int fd, void *buf, size_t size) {
+    return syscall3(SYS_GETDENTS, fd, (uint64_t)buf, size);
+}
+
+static inline int fcntl(int fd, int cmd, int arg) {
+    return syscall3(SYS_FCNTL, fd, cmd, arg);
+}
+
+static inline int pipe(int fds[2], int flags) {
+    return (int)syscall2(SYS_PIPE, (uint64_t)fds, flags);
+}
+
+static inline int dup2(int oldfd, int newfd) {
+    return (int)syscall2(SYS_DUP2, oldfd, newfd);
+}
+
+static inline int shm_open(const char *name, int flags) {
+    return (int)syscall2(SYS_SHM_OPEN, (uint64_t)name, flags);
+}
+
+static inline int shm_unlink(const char *name) {
+    return (int)syscall1(SYS_SHM_UNLINK, (uint64_t)name);
+}
+
+static inline int ftruncate(int fd, size_t size) {
+    return (int)syscall2(SYS_FTRUNCATE, fd, size);
+}
+
+static inline void *mmap(void *addr, size_t size, int prot, int fd) {
+    return (void *)syscall4(SYS_MMAP, (uint64_t)addr, size, prot, fd);
+}
+
+static inline int munmap(void *addr, size_t size) {
+    return (int)syscall2(SYS_MUNMAP, (uint64_t)addr, size);
+}
+
+static inline int socket(int flags) {
+    return (int)syscall1(SYS_SOCKET, flags);
+}
+
+static inline int bind(int fd, const char *path) {
+    return (int)syscall2(SYS_BIND, fd, (uint64_t)path);
+}
+
+static inline int listen(int fd, int backlog) {
+    return (int)syscall2(SYS_LISTEN, fd, backlog);
+}
+
+static inline int accept(int fd, int flags) {
+    return (int)syscall2(SYS_ACCEPT, fd, flags);
+}
+
+static inline int connect(int fd, const char *path) {
+    return (int)syscall2(SYS_CONNECT, fd, (uint64_t)path);
+}
+
+static inline int poll(pollfd_t *fds, uint32_t nfds, int64_t timeout_ms) {
+    return (int)syscall3(SYS_POLL, (uint64_t)fds, nfds, timeout_ms);
+}
+
+static inline int epoll_create(int flags) {
+    return (int)syscall1(SYS_EPOLL_CREATE, flags);
+}
+
+static inline int epoll_ctl(int epfd, int op, int fd, const epoll_event_t *event) {
+    return (int)syscall4(SYS_EPOLL_CTL, epfd, op, fd, (uint64_t)event);
+}
+
+static inline int epoll_wait(int epfd, epoll_event_t *events, int maxevents, int64_t timeout_ms) {
+    return (int)syscall4(SYS_EPOLL_WAIT, epfd, (uint64_t)events, maxevents, timeout_ms);
+}
+
+static inline int64_t copy_file_range(int fd_in, int64_t *off_in, int fd_out, int64_t *off_out, size_t len) {
+    vfs_copy_range_t range = {off_in ? *off_in : -1, off_out ? *off_out : -1, len};
+    int64_t ret = (int64_t)syscall3(SYS_COPY_FILE_RANGE, fd_in, fd_out, (uint64_t)&range);
+    if (off_in)
+        *off_in = range.off_in;
+    if (off_out)
+        *off_out = range.off_out;
+    return ret;
+}
+
+static inline int64_t sendfile(int out_fd, int in_fd, int64_t *offset, size_t count) {
+    return (int64_t)syscall4(SYS_SENDFILE, out_fd, in_fd, (uint64_t)offset, count);
+}
+
+static inline int cachestat(page_cache_stats_t *stats) {
+    return (int)syscall1(SYS_CACHESTAT, (uint64_t)stats);
+}
+
 static inline int unlink(const char *path, bool recursive) {
     return syscall2(SYS_UNLINK, (uint64_t)path, recursive);
 }
 
+static inline int getrusage(int pid, rusage_t *usage, int flags) {
+    return (int)syscall3(SYS_GETRUSAGE, pid, (uint64_t)usage, flags);
+}
+
+static inline int cpustat(int cpu, cpustat_t *stat) {
+    return (int)syscall2(SYS_CPUSTAT, cpu, (uint64_t)stat);
+}
+
+static inline ring_shared_t *ring_setup(uint32_t entries, uint32_t flags) {
+    return (ring_shared_t *)syscall2(SYS_RING_SETUP, entries, flags);
+}
+
+static inline int64_t ring_enter(uint32_t to_submit, uint32_t min_complete, uint32_t flags) {
+    return (int64_t)syscall3(SYS_RING_ENTER, to_submit, min_complete, flags);
+}
+
+static inline int syscall_stat(uint32_t nr, syscall_stat_t *stat) {
+    return (int)syscall2(SYS_SYSCALL_STAT, nr, (uint64_t)stat);
+}
+
+static inline int systrace(int pid, int mode) {
+    return (int)syscall2(SYS_TRACE, pid, mode);
+}
+
+static inline int systrace_read(int pid, trace_record_t *records, uint32_t count) {
+    return (int)syscall3(SYS_TRACE_READ, pid, (uint64_t)records, count);
+}
+
 static inline void print(const char *s) {
     uint64_t len = 0;
     while (s[len])
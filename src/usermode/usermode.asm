@@ -1,8 +1,12 @@
 section .text
 global jump_to_usermode
+global jump_to_usermode_arg
 jump_to_usermode:
+    xor rdx, rdx
+jump_to_usermode_arg:
     mov rcx, rdi
     mov r11, rsi
+    mov rdi, rdx
 
     push 0x1b
     push r11
@@ -15,7 +19,6 @@ jump_to_usermode:
     xor rcx, rcx
     xor rdx, rdx
     xor rsi, rsi
-    xor rdi, rdi
     xor rbp, rbp
     xor r8, r8
     xor r9, r9
@@ -26,4 +29,6 @@ jump_to_usermode:
     xor r14, r14
     xor r15, r15
 
+    cli
+    swapgs
     iretq
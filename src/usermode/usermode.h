@@ -3,3 +3,4 @@
 #include <stdint.h>
 
 void jump_to_usermode(uint64_t user_rip, uint64_t user_rsp);
+void jump_to_usermode_arg(uint64_t user_rip, uint64_t user_rsp, uint64_t arg);
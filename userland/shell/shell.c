@@ -126,6 +126,262 @@ static void cmd_exec(const char *args) {
     }
 }
 
+static char *first_word(char *s) {
+    while (*s == ' ')
+        s++;
+
+    char *end = s;
+    while (*end && *end != ' ')
+        end++;
+    *end = '\0';
+
+    return s;
+}
+
+static void cmd_pipe(char *line) {
+    char *bar = line;
+    while (*bar && *bar != '|')
+        bar++;
+    *bar = '\0';
+
+    char *left = first_word(line);
+    char *right = first_word(bar + 1);
+    if (left[0] == '\0' || right[0] == '\0') {
+        print("pipe: missing program path\n");
+        return;
+    }
+
+    char left_path[256];
+    char right_path[256];
+    build_path(left_path, left);
+    build_path(right_path, right);
+
+    int fds[2];
+    if (pipe(fds, 0) < 0) {
+        print("pipe: failed to create pipe\n");
+        return;
+    }
+
+    int writer = fork();
+    if (writer == 0) {
+        dup2(fds[1], 1);
+        close(fds[0]);
+        close(fds[1]);
+        exec(left_path);
+        exit(1);
+    }
+
+    int reader = writer > 0 ? fork() : -1;
+    if (reader == 0) {
+        dup2(fds[0], 0);
+        close(fds[0]);
+        close(fds[1]);
+        exec(right_path);
+        exit(1);
+    }
+
+    close(fds[0]);
+    close(fds[1]);
+
+    if (writer < 0 || reader < 0) {
+        print("pipe: fork failed\n");
+    }
+    if (writer > 0)
+        waitpid(writer);
+    if (reader > 0) {
+        int status = waitpid(reader);
+        if (status != 0) {
+            print("Process ");
+            print_num(reader);
+            print(" exited with code ");
+            print_num(status);
+            print("\n");
+        }
+    }
+}
+
+static syscall_stat_t syscall_info[SYSCALL_COUNT];
+static trace_record_t trace_buf[32];
+
+static void print_hex(uint64_t n) {
+    char buf[17];
+    int i = 0;
+
+    print("0x");
+    do {
+        int digit = n & 0xF;
+        buf[i++] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        n >>= 4;
+    } while (n > 0);
+
+    while (i > 0) {
+        write(1, &buf[--i], 1);
+    }
+}
+
+static void load_syscall_info(void) {
+    for (uint32_t nr = 0; nr < SYSCALL_COUNT; nr++) {
+        if (syscall_stat(nr, &syscall_info[nr]) < 0)
+            syscall_info[nr].name[0] = '\0';
+    }
+}
+
+static void print_trace_enter(trace_record_t *rec) {
+    syscall_stat_t *info = rec->nr < SYSCALL_COUNT ? &syscall_info[rec->nr] : (syscall_stat_t *)0;
+
+    print("[");
+    print_num(rec->pid);
+    print("] ");
+    if (info == (syscall_stat_t *)0 || info->name[0] == '\0') {
+        print("syscall_");
+        print_num(rec->nr);
+        print("()");
+        return;
+    }
+
+    print(info->name);
+    print("(");
+    for (int i = 0; i < info->nargs; i++) {
+        if (i > 0)
+            print(", ");
+
+        switch (info->args[i]) {
+        case SYSCALL_ARG_STR:
+            print("\"");
+            print(rec->str);
+            print("\"");
+            break;
+        case SYSCALL_ARG_HEX:
+        case SYSCALL_ARG_PTR:
+            print_hex(rec->args[i]);
+            break;
+        case SYSCALL_ARG_UINT:
+            print_num((int64_t)rec->args[i]);
+            break;
+        default:
+            print_num((int)rec->args[i]);
+            break;
+        }
+    }
+    print(")");
+}
+
+static void cmd_strace(const char *args) {
+    if (args[0] == '\0') {
+        print("strace: missing program path\n");
+        return;
+    }
+
+    char path[256];
+    build_path(path, args);
+    load_syscall_info();
+
+    int pid = fork();
+    if (pid == 0) {
+        systrace(0, TRACE_ON);
+        exec(path);
+        print("strace: failed to execute '");
+        print(path);
+        print("'\n");
+        exit(1);
+    } else if (pid < 0) {
+        print("strace: fork failed\n");
+        return;
+    }
+
+    int pending = 0;
+    while (1) {
+        int n = systrace_read(pid, trace_buf, 32);
+        if (n < 0)
+            break;
+        if (n == 0) {
+            sleep(10);
+            continue;
+        }
+
+        for (int i = 0; i < n; i++) {
+            trace_record_t *rec = &trace_buf[i];
+            if (rec->dropped)
+                print("\n<records dropped>\n");
+
+            if (rec->kind == TRACE_ENTER) {
+                if (pending)
+                    print(" = ?\n");
+                print_trace_enter(rec);
+                pending = 1;
+            } else {
+                if (!pending)
+                    print("<resumed>");
+                print(" = ");
+                print_num(rec->ret);
+                print(" <");
+                print_num(rec->duration_ns / 1000);
+                print("us>\n");
+                pending = 0;
+            }
+        }
+    }
+    if (pending)
+        print(" = ?\n");
+
+    int status = waitpid(pid);
+    print("+++ exited with ");
+    print_num(status);
+    print(" +++\n");
+}
+
+static void cmd_sysstat(void) {
+    load_syscall_info();
+
+    print("syscall               calls    errors   avg us   max us\n");
+    for (uint32_t nr = 0; nr < SYSCALL_COUNT; nr++) {
+        syscall_stat_t *info = &syscall_info[nr];
+        if (info->name[0] == '\0' || info->calls == 0)
+            continue;
+
+        print(info->name);
+        for (size_t i = strlen(info->name); i < 20; i++)
+            print(" ");
+        print(" ");
+        print_num(info->calls);
+        print("  ");
+        print_num(info->errors);
+        print("  ");
+        print_num(info->total_ns / info->calls / 1000);
+        print("  ");
+        print_num(info->max_ns / 1000);
+        print("\n");
+    }
+}
+
+static void cmd_cachestat(void) {
+    page_cache_stats_t stats;
+    if (cachestat(&stats) < 0) {
+        print("cachestat: failed\n");
+        return;
+    }
+
+    print("pages: ");
+    print_num(stats.pages);
+    print("  dirty: ");
+    print_num(stats.dirty);
+    print("  hits: ");
+    print_num(stats.hits);
+    print("  misses: ");
+    print_num(stats.misses);
+    print("\nevictions: ");
+    print_num(stats.evictions);
+    print("  writebacks: ");
+    print_num(stats.writebacks);
+    print("\nreadahead hits: ");
+    print_num(stats.ra_hits);
+    print("  misses: ");
+    print_num(stats.ra_misses);
+    print("  pages: ");
+    print_num(stats.ra_pages);
+    print("\n");
+}
+
 static void cmd_ls(const char *args) {
     char path[256];
 
@@ -143,13 +399,26 @@ static void cmd_ls(const char *args) {
         return;
     }
 
-    char name[256];
-    int count = 0;
-    while (readdir(fd, name, 256) > 0) {
-        print("  ");
-        print(name);
-        print("\n");
-        count++;
+    static uint64_t dents[512];
+    int64_t bytes;
+    while ((bytes = getdents(fd, dents, sizeof(dents))) > 0) {
+        for (int64_t pos = 0; pos < bytes;) {
+            vfs_dirent_t *dirent = (vfs_dirent_t *)((char *)dents + pos);
+
+            print(dirent->type == VFS_DIRECTORY ? "  d " : "  - ");
+            int64_t size = dirent->size;
+            int digits = 1;
+            for (int64_t v = size; v >= 10; v /= 10)
+                digits++;
+            for (int i = digits; i < 10; i++)
+                print(" ");
+            print_num(size);
+            print("  ");
+            print(dirent->name);
+            print("\n");
+
+            pos += dirent->reclen;
+        }
     }
 
     close(fd);
@@ -284,6 +553,59 @@ static void cmd_write(const char *args) {
     close(fd);
 }
 
+static void cmd_cp(const char *args) {
+    int i = 0;
+    while (args[i] && args[i] != ' ')
+        i++;
+
+    if (i == 0 || args[i] == '\0') {
+        print("cp: usage: cp <src> <dst>\n");
+        return;
+    }
+
+    char src_name[256];
+    for (int j = 0; j < i; j++) {
+        src_name[j] = args[j];
+    }
+    src_name[i] = '\0';
+
+    const char *dst_name = &args[i + 1];
+    while (*dst_name == ' ')
+        dst_name++;
+
+    char src[256];
+    char dst[256];
+    build_path(src, src_name);
+    build_path(dst, dst_name);
+
+    int in = open(src, O_RDONLY);
+    if (in < 0) {
+        print("cp: cannot open '");
+        print(src);
+        print("'\n");
+        return;
+    }
+
+    int out = open(dst, O_CREAT | O_WRONLY | O_TRUNC);
+    if (out < 0) {
+        print("cp: cannot create '");
+        print(dst);
+        print("'\n");
+        close(in);
+        return;
+    }
+
+    int64_t n;
+    while ((n = copy_file_range(in, 0, out, 0, 1 << 20)) > 0)
+        ;
+
+    if (n < 0)
+        print("cp: copy failed\n");
+
+    close(out);
+    close(in);
+}
+
 static void cmd_rm(const char *args) {
     if (args[0] == '\0') {
         print("rm: missing file name\n");
@@ -330,8 +652,13 @@ static void cmd_help(void) {
     print("  touch <name>  - create empty file\n");
     print("  cat <file>    - display file contents\n");
     print("  write <f> <t> - write text to file\n");
+    print("  cp <src> <d>  - copy file\n");
     print("  rm <file>     - remove file\n");
     print("  rmdir <file>  - removes directory and its contents recursively\n");
+    print("  strace <prog> - run a program and trace its syscalls\n");
+    print("  sysstat       - show per-syscall call counts and latency\n");
+    print("  cachestat     - show page cache and readahead counters\n");
+    print("  <a> | <b>     - run two programs with a's output piped into b\n");
 }
 
 static void process_command(void) {
@@ -349,6 +676,17 @@ static void process_command(void) {
         return;
     }
 
+    for (char *p = cmd; *p; p++) {
+        if (*p == '|') {
+            cmd_pipe(cmd);
+            for (int i = 0; i < INPUT_BUFFER_SIZE; i++) {
+                input_buffer[i] = 0;
+            }
+            input_index = 0;
+            return;
+        }
+    }
+
     char *args = cmd;
     while (*args && *args != ' ')
         args++;
@@ -387,10 +725,18 @@ static void process_command(void) {
         cmd_cat(args);
     } else if (streq(cmd, "write")) {
         cmd_write(args);
+    } else if (streq(cmd, "cp")) {
+        cmd_cp(args);
     } else if (streq(cmd, "rm")) {
         cmd_rm(args);
     } else if (streq(cmd, "rmdir")) {
         cmd_rmdir(args);
+    } else if (streq(cmd, "strace")) {
+        cmd_strace(args);
+    } else if (streq(cmd, "sysstat")) {
+        cmd_sysstat();
+    } else if (streq(cmd, "cachestat")) {
+        cmd_cachestat();
     } else {
         print("Unknown command: ");
         print(cmd);
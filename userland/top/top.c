@@ -0,0 +1,142 @@
+#include "../../src/usermode/user_syscall.h"
+
+#define MAX_TASKS 64
+#define MAX_CPUS 64
+#define SAMPLE_MS 1000
+
+typedef struct {
+    uint32_t pid;
+    uint64_t runtime_ns;
+} sample_t;
+
+static sample_t samples[MAX_TASKS];
+static int sample_count = 0;
+
+static uint64_t cpu_idle[MAX_CPUS];
+static uint64_t cpu_stamp[MAX_CPUS];
+
+static void print_padded(int64_t n, int width) {
+    int digits = 1;
+    for (int64_t v = n < 0 ? -n : n; v >= 10; v /= 10)
+        digits++;
+    if (n < 0)
+        digits++;
+
+    for (int i = digits; i < width; i++)
+        write(1, " ", 1);
+    print_num(n);
+}
+
+static const char *state_name(uint8_t state) {
+    switch (state) {
+    case 0:
+        return " R ";
+    case 1:
+        return " R ";
+    case 2:
+        return " S ";
+    case 3:
+        return " Z ";
+    }
+    return " ? ";
+}
+
+static uint64_t previous_runtime(uint32_t pid) {
+    for (int i = 0; i < sample_count; i++) {
+        if (samples[i].pid == pid)
+            return samples[i].runtime_ns;
+    }
+    return 0;
+}
+
+static void take_cpu_samples() {
+    cpustat_t stat;
+    for (int cpu = 0; cpu < MAX_CPUS && cpustat(cpu, &stat) == 0; cpu++) {
+        cpu_idle[cpu] = stat.idle_ns;
+        cpu_stamp[cpu] = stat.now_ns;
+    }
+}
+
+static void print_cpus() {
+    cpustat_t stat;
+    for (int cpu = 0; cpu < MAX_CPUS && cpustat(cpu, &stat) == 0; cpu++) {
+        uint64_t elapsed = stat.now_ns - cpu_stamp[cpu];
+        uint64_t idle = stat.idle_ns - cpu_idle[cpu];
+        if (idle > elapsed)
+            idle = elapsed;
+        uint64_t busy_tenths = elapsed ? ((elapsed - idle) * 1000) / elapsed : 0;
+
+        print("cpu");
+        print_num(cpu);
+        print(": ");
+        print_padded(busy_tenths / 10, 3);
+        print(".");
+        print_num(busy_tenths % 10);
+        print("% busy, idle via ");
+        print(stat.idle_method == CPUSTAT_IDLE_MWAIT ? "mwait" : "hlt");
+        for (uint32_t i = 0; i < stat.nr_states && i < CPUSTAT_IDLE_STATES; i++) {
+            print("  C");
+            print_num(i + 1);
+            print("=");
+            print_num(stat.residency_ns[i] / 1000000);
+            print("ms/");
+            print_num(stat.entries[i]);
+        }
+        print("\n");
+    }
+    print("\n");
+}
+
+static uint64_t take_samples() {
+    rusage_t usage;
+    uint64_t now = 0;
+    int pid = 1;
+
+    take_cpu_samples();
+
+    sample_count = 0;
+    while (sample_count < MAX_TASKS && (pid = getrusage(pid, &usage, RUSAGE_NEXT)) > 0) {
+        samples[sample_count].pid = usage.pid;
+        samples[sample_count].runtime_ns = usage.runtime_ns;
+        sample_count++;
+        now = usage.now_ns;
+        pid++;
+    }
+
+    return now;
+}
+
+void _start() {
+    uint64_t start = take_samples();
+    sleep(SAMPLE_MS);
+
+    print_cpus();
+
+    print("  PID  PPID  S  %CPU   USER(ms)    SYS(ms)   WAIT(ms)  VCSW  ICSW  MAXLAT(us)\n");
+
+    rusage_t usage;
+    int pid = 1;
+    while ((pid = getrusage(pid, &usage, RUSAGE_NEXT)) > 0) {
+        uint64_t elapsed = usage.now_ns - start;
+        uint64_t delta = usage.runtime_ns - previous_runtime(usage.pid);
+        uint64_t cpu_tenths = elapsed ? (delta * 1000) / elapsed : 0;
+
+        print_padded(usage.pid, 5);
+        print_padded(usage.parent_pid, 6);
+        print(state_name(usage.state));
+        print_padded(cpu_tenths / 10, 4);
+        print(".");
+        print_num(cpu_tenths % 10);
+        print_padded(usage.user_ns / 1000000, 11);
+        print_padded(usage.system_ns / 1000000, 11);
+        print_padded(usage.wait_ns / 1000000, 11);
+        print_padded(usage.nvcsw, 6);
+        print_padded(usage.nivcsw, 6);
+        print_padded(usage.max_wakeup_latency_ns / 1000, 12);
+        print("\n");
+
+        pid++;
+    }
+
+    exit(0);
+}